@@ -0,0 +1 @@
+../assert.h
\ No newline at end of file
@@ -35,6 +35,7 @@
 #include "bootmanager.h"
 #include "checksum.h"
 #include "config.h"
+#include "lzss.h"
 
 #include <new>
 
@@ -73,45 +74,116 @@ void Bootloader::lockFirmware()
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Bootloader::eraseSector(size_t sector)
+auto Bootloader::getSectorAddress(size_t sector) const -> Result<uint32_t>
+{
+    if (sector >= Config::FirmwareSectorCount)
+        return Programmer::InvalidSectorError;
+
+    return Programmer::sectorAddress(sector);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Bootloader::getSectorChecksum(size_t sector) const -> Result<uint32_t>
+{
+    const auto address = getSectorAddress(sector);
+    if (!address)
+        return address.error();
+
+    return Checksum::compute(address.value(), Config::SectorSize);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Bootloader::getRangeChecksum(uint32_t address, size_t size) const -> Result<uint32_t>
+{
+    const bool rangeValid = (address >= Config::FlashStartAddress) &&
+                            (address <= Config::FlashEndAddress) &&
+                            (size <= Config::FlashEndAddress - address);
+    if (!rangeValid)
+        return Programmer::InvalidAddressError;
+
+    return Checksum::compute(address, size);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Bootloader::eraseSector(size_t sector) -> Result<>
 {
     if (!m_programmer)
-        throw Error(Error::Type::FirmwareLocked);
+        return FirmwareLockedError;
 
-    m_programmer->eraseSector(sector);
+    return m_programmer->eraseSector(sector);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Bootloader::writeHexRecord(const char* string)
+auto Bootloader::eraseTail(size_t firstSector) -> Result<>
 {
     if (!m_programmer)
-        throw Error(Error::Type::FirmwareLocked);
+        return FirmwareLockedError;
+
+    return m_programmer->eraseTail(firstSector);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Bootloader::writeHexRecord(const char* string) -> Result<>
+{
+    if (!m_programmer)
+        return FirmwareLockedError;
 
     const auto record = HexRecord::fromString(string);
-    m_programmer->processRecord(record);
+    if (!record)
+        return record.error();
+
+    return m_programmer->processRecord(record.value());
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Bootloader::launchFirmware()
+auto Bootloader::writeBlock(uint32_t address, const uint8_t* data, size_t size,
+                            uint32_t checksum) -> Result<>
 {
-    lockFirmware();
-    BootManager::reboot(BootManager::Mode::Firmware);
+    if (!m_programmer)
+        return FirmwareLockedError;
+
+    if (size == 0 || size > Config::SectorSize)
+        return InvalidLengthError;
+
+    if (Checksum::compute(data, size) != checksum)
+        return InvalidChecksumError;
+
+    return m_programmer->writeBlock(address, data, size);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Bootloader::Error::what() const noexcept -> const char*
+auto Bootloader::writePackedBlock(uint32_t address, const uint8_t* data, size_t packedSize,
+                                  size_t size, uint32_t checksum) -> Result<>
 {
-    switch (m_type)
-    {
-    case Type::FirmwareLocked:
-        return "FIRMWARE_LOCKED";
+    if (!m_programmer)
+        return FirmwareLockedError;
 
-    default:
-        return "UNKNOWN_BOOTLOADER_ERROR";
-    }
+    if (size == 0 || size > m_unpackedBlock.size())
+        return InvalidLengthError;
+
+    const auto unpacked = Lzss::decode(data, packedSize, m_unpackedBlock.data(), size);
+    if (!unpacked)
+        return unpacked.error();
+
+    if (unpacked.value() != size)
+        return Lzss::InvalidDataError;
+
+    return writeBlock(address, m_unpackedBlock.data(), size, checksum);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Bootloader::launchFirmware()
+{
+    lockFirmware();
+    BootManager::reboot(BootManager::Mode::Firmware);
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -35,9 +35,9 @@
 
 #include "config.h"
 #include "programmer.h"
+#include "result.h"
 
 #include <array>
-#include <exception>
 
 class Bootloader
 {
@@ -50,7 +50,9 @@ public:
         size_t sectorCount = Config::FirmwareSectorCount;
     };
 
-    class Error;
+    static constexpr Error FirmwareLockedError = Error("FIRMWARE_LOCKED");
+    static constexpr Error InvalidLengthError = Error("INVALID_LENGTH");
+    static constexpr Error InvalidChecksumError = Error("INVALID_CHECKSUM");
 
 public:
     Bootloader() = default;
@@ -63,36 +65,37 @@ public:
     void unlockFirmware();
     void lockFirmware();
 
-    void eraseSector(size_t sector);
-    void writeHexRecord(const char* record);
+    // Start address and CRC-32 of a firmware sector as currently in flash, locked or not
+    auto getSectorAddress(size_t sector) const -> Result<uint32_t>;
+    auto getSectorChecksum(size_t sector) const -> Result<uint32_t>;
 
-    void launchFirmware();
+    // CRC-32 of any range within flash, to verify what has been written
+    auto getRangeChecksum(uint32_t address, size_t size) const -> Result<uint32_t>;
 
-private:
-    std::array<char, sizeof(Programmer)> m_programmerBuffer;
-    Programmer* m_programmer = nullptr;
+    auto eraseSector(size_t sector) -> Result<>;
 
-    Info m_info;
-};
+    // Erases what is not blank from the given sector on, unless already erased since unlocking
+    auto eraseTail(size_t firstSector) -> Result<>;
 
-// ---------------------------------------------------------------------------------------------- //
+    auto writeHexRecord(const char* record) -> Result<>;
 
-class Bootloader::Error : public std::exception
-{
-public:
-    enum class Type
-    {
-        FirmwareLocked
-    };
+    // Up to one sector of raw data, checksum is the CRC-32 also used for the whole image
+    auto writeBlock(uint32_t address, const uint8_t* data, size_t size,
+                    uint32_t checksum) -> Result<>;
 
-public:
-    Error(Type type) : m_type(type) {}
+    // Block compressed with Lzss, size and checksum refer to the unpacked data
+    auto writePackedBlock(uint32_t address, const uint8_t* data, size_t packedSize, size_t size,
+                          uint32_t checksum) -> Result<>;
 
-    auto type() const -> Type { return m_type; }
-    auto what() const noexcept -> const char* override;
+    void launchFirmware();
 
 private:
-    Type m_type;
+    std::array<char, sizeof(Programmer)> m_programmerBuffer;
+    Programmer* m_programmer = nullptr;
+
+    std::array<uint8_t, Config::SectorSize> m_unpackedBlock = {};
+
+    Info m_info;
 };
 
 // ---------------------------------------------------------------------------------------------- //
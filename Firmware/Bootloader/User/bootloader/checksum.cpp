@@ -37,14 +37,75 @@
 
 // ---------------------------------------------------------------------------------------------- //
 
+namespace {
+    constexpr uint32_t CrcInitializer = 0x00000000;
+
+#if defined(CRC_CR_REV_IN)
+    // The CRC unit's default polynomial is the one of crc32.c in normal form. Reversing input
+    // words and output makes it process little-endian words the way the table does bytes.
+    auto updateWords(uint32_t crc, const uint32_t* words, uint32_t count) -> uint32_t
+    {
+        __HAL_RCC_CRC_CLK_ENABLE();
+
+        CRC->INIT = __RBIT(crc);
+        CRC->CR = CRC_CR_REV_IN | CRC_CR_REV_OUT | CRC_CR_RESET;
+
+        for (uint32_t i = 0; i < count; ++i)
+            CRC->DR = words[i];
+
+        crc = CRC->DR;
+
+        __HAL_RCC_CRC_CLK_DISABLE();
+
+        return crc;
+    }
+#endif
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 auto Checksum::compute() -> uint32_t
 {
-    static constexpr uint32_t CrcInitializer = 0x00000000;
+    return compute(Config::FirmwareStartAddress,
+                   Config::FirmwareEndAddress - Config::FirmwareStartAddress);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Checksum::compute(uint32_t address, uint32_t length) -> uint32_t
+{
+    return compute(reinterpret_cast<const uint8_t*>(address), length);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Checksum::compute(const uint8_t* data, uint32_t length) -> uint32_t
+{
+    return update(CrcInitializer, data, length);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Checksum::update(uint32_t crc, const uint8_t* data, uint32_t length) -> uint32_t
+{
+#if defined(CRC_CR_REV_IN)
+    // Unaligned bytes at either end go through the table, the CRC state is the same in both
+    const auto misalignment = reinterpret_cast<uintptr_t>(data) % sizeof(uint32_t);
+    const uint32_t head = (misalignment != 0) ? sizeof(uint32_t) - misalignment : 0;
+
+    if (length <= head)
+        return crc32_update_buffer(crc, data, length);
+
+    const uint32_t count = (length - head) / sizeof(uint32_t);
+    const uint32_t tail = head + count * sizeof(uint32_t);
 
-    const auto buffer = reinterpret_cast<const uint8_t*>(Config::FirmwareStartAddress);
-    const uint32_t length = Config::FirmwareEndAddress - Config::FirmwareStartAddress;
+    crc = crc32_update_buffer(crc, data, head);
+    crc = updateWords(crc, reinterpret_cast<const uint32_t*>(data + head), count);
 
-    return crc32_update_buffer(CrcInitializer, buffer, length);
+    return crc32_update_buffer(crc, data + tail, length - tail);
+#else
+    return crc32_update_buffer(crc, data, length);
+#endif
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -39,6 +39,11 @@ class Checksum
 {
 public:
     static auto compute() -> uint32_t;
+    static auto compute(uint32_t address, uint32_t length) -> uint32_t;
+
+    // Same result as crc32_update_buffer() with initial value 0, using the CRC unit if present
+    static auto compute(const uint8_t* data, uint32_t length) -> uint32_t;
+    static auto update(uint32_t crc, const uint8_t* data, uint32_t length) -> uint32_t;
     static auto read() -> uint32_t;
     static auto verify() -> bool;
 };
@@ -118,12 +118,12 @@ auto hexToNum(std::span<const char> hex) -> T
 // ---------------------------------------------------------------------------------------------- //
 
 template <typename T>
-auto scanValue(const char*& str) -> T
+auto scanValue(const char*& str) -> Result<T>
 {
     std::array<char, 2*sizeof(T)> value = {};
 
     if (std::strlen(str) < value.size())
-        throw HexRecord::ParserError(HexRecord::ParserError::Type::InvalidRecord);
+        return HexRecord::InvalidRecordError;
 
     for (char& byte : value)
         byte = *(str++);
@@ -133,71 +133,56 @@ auto scanValue(const char*& str) -> T
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto HexRecord::fromString(const char* str) -> HexRecord
+auto HexRecord::fromString(const char* str) -> Result<HexRecord>
 {
     HexRecord record;
 
     if (std::strlen(str) < 1 || *(str++) != ':')
-        throw ParserError(ParserError::Type::InvalidRecord);
+        return InvalidRecordError;
 
-    record.m_length = scanValue<uint8_t>(str);
+    const auto length = scanValue<uint8_t>(str);
+    if (!length)
+        return length.error();
 
-    if (record.m_length > MaximumLength)
-        throw ParserError(ParserError::Type::InvalidLength);
-
-    record.m_address = scanValue<uint16_t>(str);
-
-    const uint8_t typeIndex = scanValue<uint8_t>(str);
-
-    if (typeIndex >= TypeCount)
-        throw ParserError(ParserError::Type::InvalidType);
-
-    record.m_type = static_cast<Type>(typeIndex);
-
-    for (uint8_t i = 0; i < record.m_length; ++i)
-        record.m_data[i] = scanValue<uint8_t>(str);
+    record.m_length = length.value();
 
-    record.m_checksum = scanValue<uint8_t>(str);
-
-    if (record.m_checksum != record.computeChecksum())
-        throw ParserError(ParserError::Type::InvalidChecksum);
-
-    return record;
-}
+    if (record.m_length > MaximumLength)
+        return InvalidLengthError;
 
-// ---------------------------------------------------------------------------------------------- //
+    const auto address = scanValue<uint16_t>(str);
+    if (!address)
+        return address.error();
 
-HexRecord::ParserError::ParserError(Type type)
-    : m_type(type) {}
+    record.m_address = address.value();
 
-// ---------------------------------------------------------------------------------------------- //
+    const auto typeIndex = scanValue<uint8_t>(str);
+    if (!typeIndex)
+        return typeIndex.error();
 
-auto HexRecord::ParserError::type() const -> Type
-{
-    return m_type;
-}
+    if (typeIndex.value() >= TypeCount)
+        return InvalidTypeError;
 
-// ---------------------------------------------------------------------------------------------- //
+    record.m_type = static_cast<Type>(typeIndex.value());
 
-auto HexRecord::ParserError::what() const noexcept -> const char*
-{
-    switch (m_type)
+    for (uint8_t i = 0; i < record.m_length; ++i)
     {
-    case Type::InvalidRecord:
-        return "INVALID_RECORD";
+        const auto byte = scanValue<uint8_t>(str);
+        if (!byte)
+            return byte.error();
 
-    case Type::InvalidLength:
-        return "INVALID_LENGTH";
+        record.m_data[i] = byte.value();
+    }
 
-    case Type::InvalidType:
-        return "INVALID_TYPE";
+    const auto checksum = scanValue<uint8_t>(str);
+    if (!checksum)
+        return checksum.error();
 
-    case Type::InvalidChecksum:
-        return "INVALID_CHECKSUM";
+    record.m_checksum = checksum.value();
 
-    default:
-        return "UNKNOWN_PARSER_ERROR";
-    }
+    if (record.m_checksum != record.computeChecksum())
+        return InvalidChecksumError;
+
+    return record;
 }
 
 // ---------------------------------------------------------------------------------------------- //
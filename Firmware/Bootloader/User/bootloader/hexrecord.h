@@ -33,10 +33,11 @@
 
 #pragma once
 
+#include "result.h"
+
 #include <array>
 #include <cstddef>
 #include <cstdint>
-#include <exception>
 
 class HexRecord
 {
@@ -56,7 +57,10 @@ public:
     static constexpr size_t MaximumLength = 32;
     using Data = std::array<uint8_t, MaximumLength>;
 
-    class ParserError;
+    static constexpr Error InvalidRecordError = Error("INVALID_RECORD");
+    static constexpr Error InvalidLengthError = Error("INVALID_LENGTH");
+    static constexpr Error InvalidTypeError = Error("INVALID_TYPE");
+    static constexpr Error InvalidChecksumError = Error("INVALID_CHECKSUM");
 
 public:
     auto length() const -> uint8_t;
@@ -67,9 +71,10 @@ public:
 
     auto computeChecksum() const -> uint8_t;
 
-    static auto fromString(const char* str) -> HexRecord;
+    static auto fromString(const char* str) -> Result<HexRecord>;
 
 private:
+    friend class Result<HexRecord>;
     HexRecord() = default;
 
 private:
@@ -81,26 +86,3 @@ private:
 };
 
 // ---------------------------------------------------------------------------------------------- //
-
-class HexRecord::ParserError : public std::exception
-{
-public:
-    enum class Type
-    {
-        InvalidRecord,
-        InvalidLength,
-        InvalidType,
-        InvalidChecksum
-    };
-
-public:
-    ParserError(Type type);
-
-    auto type() const -> Type;
-    auto what() const noexcept -> const char* override;
-
-private:
-    Type m_type;
-};
-
-// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,89 @@
+// ============================================================================================== //
+//                                                                                                //
+//   This file is part of the ISF Firmware Updater bootloader.                                    //
+//                                                                                                //
+//   Author:                                                                                      //
+//   Marcel Hasler <mahasler@gmail.com>                                                           //
+//                                                                                                //
+//   Copyright (c) 2020 - 2023                                                                    //
+//   Bonn-Rhein-Sieg University of Applied Sciences                                               //
+//                                                                                                //
+//   Redistribution and use in source and binary forms, with or without modification,             //
+//   are permitted provided that the following conditions are met:                                //
+//                                                                                                //
+//   1. Redistributions of source code must retain the above copyright notice,                    //
+//      this list of conditions and the following disclaimer.                                     //
+//                                                                                                //
+//   2. Redistributions in binary form must reproduce the above copyright notice,                 //
+//      this list of conditions and the following disclaimer in the documentation                 //
+//      and/or other materials provided with the distribution.                                    //
+//                                                                                                //
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"                  //
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED            //
+//   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.           //
+//   IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,             //
+//   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT           //
+//   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR           //
+//   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,            //
+//   WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)           //
+//   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE                   //
+//   POSSIBILITY OF SUCH DAMAGE.                                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+
+#include "lzss.h"
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr uint16_t DistanceMask = 0x07ff;
+    constexpr size_t LengthShift = 11;
+    constexpr size_t MinimumLength = 3;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Lzss::decode(const uint8_t* source, size_t sourceSize,
+                  uint8_t* target, size_t targetSize) -> Result<size_t>
+{
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < sourceSize)
+    {
+        const uint8_t flags = source[in++];
+
+        for (size_t bit = 0; bit < 8 && in < sourceSize; ++bit)
+        {
+            if (flags & (1 << bit))
+            {
+                if (out >= targetSize)
+                    return InvalidDataError;
+
+                target[out++] = source[in++];
+                continue;
+            }
+
+            if (in + 2 > sourceSize)
+                return InvalidDataError;
+
+            const auto reference = static_cast<uint16_t>(source[in] | (source[in + 1] << 8));
+            in += 2;
+
+            const size_t distance = (reference & DistanceMask) + 1;
+            const size_t length = (reference >> LengthShift) + MinimumLength;
+
+            if (distance > out || out + length > targetSize)
+                return InvalidDataError;
+
+            // Byte by byte, a reference may overlap the data it produces
+            for (size_t i = 0; i < length; ++i, ++out)
+                target[out] = target[out - distance];
+        }
+    }
+
+    return out;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -85,10 +85,18 @@ Programmer::~Programmer()
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Programmer::eraseSector(size_t sector)
+auto Programmer::sectorAddress(size_t sector) -> uint32_t
+{
+    const auto index = Config::FirmwareStartSector + static_cast<uint32_t>(sector);
+    return Config::FlashStartAddress + index * Config::SectorSize;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Programmer::eraseSector(size_t sector) -> Result<>
 {
     if (sector >= Config::FirmwareSectorCount)
-        throw EraseError(EraseError::Type::InvalidSector, sector);
+        return InvalidSectorError;
 
     FLASH_EraseInitTypeDef eraseInit = {};
     uint32_t sectorError = 0;
@@ -108,34 +116,66 @@ void Programmer::eraseSector(size_t sector)
     HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&eraseInit, &sectorError);
 
     if (status != HAL_OK)
-        throw EraseError(EraseError::Type::EraseFailed, sectorError);
+        return EraseFailedError;
+
+    m_erased[sector] = true;
+
+    // Only sectors holding data already summed up invalidate it, never the user page
+    const uint32_t start = sectorAddress(sector);
+    const uint32_t end = start + Config::SectorSize;
+
+    if (end > Config::FirmwareStartAddress && start < m_checksumAddress)
+        m_checksumValid = false;
+
+    return {};
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Programmer::processRecord(const HexRecord& record)
+auto Programmer::eraseTail(size_t firstSector) -> Result<>
+{
+    if (firstSector > Config::FirmwareSectorCount)
+        return InvalidSectorError;
+
+    for (size_t sector = firstSector; sector < Config::FirmwareSectorCount; ++sector)
+    {
+        if (auto result = prepare(sector); !result)
+            return result;
+    }
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Programmer::processRecord(const HexRecord& record) -> Result<>
 {
     switch (record.type())
     {
     case HexRecord::Type::ExtendedLinearAddress:
         processExtendedLinearAddress(record);
-        break;
+        return {};
 
     case HexRecord::Type::Data:
-        processData(record);
-        break;
+        return processData(record);
 
     case HexRecord::Type::EndOfFile:
-        processEndOfFile(record);
-        break;
+        return processEndOfFile(record);
 
     default:
-        break;
+        return {};
     }
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
+auto Programmer::writeBlock(uint32_t address, const uint8_t* data, size_t size) -> Result<>
+{
+    return program(address, data, size);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void Programmer::processExtendedLinearAddress(const HexRecord& record)
 {
     const HexRecord::Data& bytes = record.data();
@@ -144,98 +184,135 @@ void Programmer::processExtendedLinearAddress(const HexRecord& record)
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Programmer::processData(const HexRecord& record)
+auto Programmer::processData(const HexRecord& record) -> Result<>
 {
-    const HexRecord::Data& bytes = record.data();
+    return program(m_baseAddress | record.address(), record.data().data(), record.length());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Programmer::processEndOfFile(const HexRecord&) -> Result<>
+{
+    uint32_t checksum = 0;
+
+    if (m_checksumValid)
+    {
+        updateChecksum(Config::FirmwareEndAddress, nullptr, 0);
+        checksum = m_checksum;
+    }
+    else
+        checksum = Checksum::compute();
+
+    auto status = HAL_FLASH_Program(ProgramType, Config::ChecksumAddress, checksum);
+
+    if (status != HAL_OK)
+        return WriteFailedError;
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Programmer::prepare(size_t sector) -> Result<>
+{
+    // A blank sector needs no erase, whether left so by a previous update or never written
+    if (m_erased[sector] || isBlank(sector))
+    {
+        m_erased[sector] = true;
+        return {};
+    }
 
-    const uint32_t address = m_baseAddress | record.address();
-    const uint32_t length = record.length();
+    return eraseSector(sector);
+}
+
+// ---------------------------------------------------------------------------------------------- //
 
+auto Programmer::program(uint32_t address, const uint8_t* data, size_t size) -> Result<>
+{
     const bool addressValid = (address % WordSize) == 0 &&
                               (address >= Config::FirmwareStartAddress) &&
-                              (address + length <= Config::FirmwareEndAddress);
+                              (address + size <= Config::FirmwareEndAddress);
     if (!addressValid)
-        throw ProgramError(ProgramError::Type::InvalidAddress, address);
+        return InvalidAddressError;
+
+    if (size == 0)
+        return {};
+
+    for (size_t sector = sectorOf(address); sector <= sectorOf(address + size - 1); ++sector)
+    {
+        if (auto result = prepare(sector); !result)
+            return result;
+    }
 
-    for (uint32_t offset = 0; offset < length; offset += WordSize)
+    for (uint32_t offset = 0; offset < size; offset += WordSize)
     {
-        DataType data = 0;
+        DataType word = 0;
 
         for (uint32_t i = 0; i < WordSize; ++i)
         {
-            const auto byte = static_cast<DataType>(bytes[offset + i]);
-            data |= (byte << (i*8));
+            const uint8_t byte = (offset + i < size) ? data[offset + i] : 0xff;
+            word |= (static_cast<DataType>(byte) << (i*8));
         }
 
-        auto status = HAL_FLASH_Program(ProgramType, address + offset, data);
+        auto status = HAL_FLASH_Program(ProgramType, address + offset, word);
 
         if (status != HAL_OK)
-            throw ProgramError(ProgramError::Type::WriteFailed, HAL_FLASH_GetError());
+            return WriteFailedError;
 
         const auto readback = *reinterpret_cast<volatile DataType*>(address + offset);
 
-        if (readback != data)
-            throw ProgramError(ProgramError::Type::DataMismatch);
+        if (readback != word)
+            return DataMismatchError;
     }
-}
-
-// ---------------------------------------------------------------------------------------------- //
 
-void Programmer::processEndOfFile(const HexRecord&)
-{
-    const uint32_t checksum = Checksum::compute();
+    updateChecksum(address, data, size);
 
-    auto status = HAL_FLASH_Program(ProgramType, Config::ChecksumAddress, checksum);
-
-    if (status != HAL_OK)
-        throw ProgramError(ProgramError::Type::WriteFailed, HAL_FLASH_GetError());
+    return {};
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-Programmer::EraseError::EraseError(Type type, uint32_t sector)
-    : m_type(type), m_sector(sector) {}
+void Programmer::updateChecksum(uint32_t address, const uint8_t* data, size_t size)
+{
+    // The user page below the image is not covered by the checksum
+    if (address + size <= Config::FirmwareStartAddress)
+        return;
 
-// ---------------------------------------------------------------------------------------------- //
+    if (address < m_checksumAddress)
+        m_checksumValid = false;
 
-auto Programmer::EraseError::what() const noexcept -> const char*
-{
-    switch (m_type)
-    {
-    case Type::InvalidSector:
-        return "INVALID_SECTOR";
+    if (!m_checksumValid)
+        return;
 
-    case Type::EraseFailed:
-        return "ERASE_FAILED";
+    // Gaps are read back, they are erased unless the sector was kept from a previous update
+    const auto gap = reinterpret_cast<const uint8_t*>(m_checksumAddress);
 
-    default:
-        return "UNKNOWN_ERASE_ERROR";
-    }
+    m_checksum = Checksum::update(m_checksum, gap, address - m_checksumAddress);
+    m_checksum = Checksum::update(m_checksum, data, size);
+
+    m_checksumAddress = address + size;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-Programmer::ProgramError::ProgramError(Type type, uint32_t code)
-    : m_type(type), m_code(code) {}
+auto Programmer::sectorOf(uint32_t address) -> size_t
+{
+    return (address - sectorAddress(0)) / Config::SectorSize;
+}
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Programmer::ProgramError::what() const noexcept -> const char*
+auto Programmer::isBlank(size_t sector) -> bool
 {
-    switch (m_type)
-    {
-    case Type::InvalidAddress:
-        return "INVALID_ADDRESS";
-
-    case Type::WriteFailed:
-        return "WRITE_FAILED";
+    const auto words = reinterpret_cast<const volatile DataType*>(sectorAddress(sector));
 
-    case Type::DataMismatch:
-        return "DATA_MISMATCH";
-
-    default:
-        return "UNKNOWN_PROGRAM_ERROR";
+    for (size_t i = 0; i < Config::SectorSize / WordSize; ++i)
+    {
+        if (words[i] != static_cast<DataType>(~DataType(0)))
+            return false;
     }
+
+    return true;
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -33,81 +33,61 @@
 
 #pragma once
 
+#include "config.h"
 #include "hexrecord.h"
+#include "result.h"
 
-#include <exception>
+#include <bitset>
 
 // ---------------------------------------------------------------------------------------------- //
 
 class Programmer
 {
 public:
-    class EraseError;
-    class ProgramError;
+    static constexpr Error InvalidSectorError = Error("INVALID_SECTOR");
+    static constexpr Error EraseFailedError = Error("ERASE_FAILED");
+
+    static constexpr Error InvalidAddressError = Error("INVALID_ADDRESS");
+    static constexpr Error WriteFailedError = Error("WRITE_FAILED");
+    static constexpr Error DataMismatchError = Error("DATA_MISMATCH");
 
 public:
     Programmer();
     ~Programmer();
 
-    void eraseSector(size_t sector);
-    void processRecord(const HexRecord& record);
-
-private:
-    void processExtendedLinearAddress(const HexRecord& record);
-    void processData(const HexRecord& record);
-    void processEndOfFile(const HexRecord& record);
-
-private:
-    uint32_t m_baseAddress = 0;
-};
-
-// ---------------------------------------------------------------------------------------------- //
-
-class Programmer::EraseError : public std::exception
-{
-public:
-    enum class Type
-    {
-        InvalidSector,
-        EraseFailed
-    };
+    static auto sectorAddress(size_t sector) -> uint32_t;
 
-public:
-    EraseError(Type type, uint32_t sector = 0);
+    // Sectors are also erased on the first write into them unless blank or erased before, so
+    // only those the image leaves empty need to be erased explicitly
+    auto eraseSector(size_t sector) -> Result<>;
+    auto eraseTail(size_t firstSector) -> Result<>;
 
-    auto type() const -> Type { return m_type; }
-    auto sector() const -> uint32_t { return m_sector; }
+    auto processRecord(const HexRecord& record) -> Result<>;
 
-    auto what() const noexcept -> const char* override;
+    // Absolute address, a partial last word is padded with 0xFF
+    auto writeBlock(uint32_t address, const uint8_t* data, size_t size) -> Result<>;
 
 private:
-    Type m_type;
-    uint32_t m_sector;
-};
-
-// ---------------------------------------------------------------------------------------------- //
-
-class Programmer::ProgramError : public std::exception
-{
-public:
-    enum class Type
-    {
-        InvalidAddress,
-        WriteFailed,
-        DataMismatch
-    };
+    void processExtendedLinearAddress(const HexRecord& record);
+    auto processData(const HexRecord& record) -> Result<>;
+    auto processEndOfFile(const HexRecord& record) -> Result<>;
 
-public:
-    ProgramError(Type type, uint32_t code = 0);
+    auto prepare(size_t sector) -> Result<>;
+    auto program(uint32_t address, const uint8_t* data, size_t size) -> Result<>;
 
-    auto type() const -> Type { return m_type; }
-    auto code() const -> uint32_t { return m_code; }
+    void updateChecksum(uint32_t address, const uint8_t* data, size_t size);
 
-    auto what() const noexcept -> const char* override;
+    static auto sectorOf(uint32_t address) -> size_t;
+    static auto isBlank(size_t sector) -> bool;
 
 private:
-    Type m_type;
-    uint32_t m_code;
+    uint32_t m_baseAddress = 0;
+    std::bitset<Config::FirmwareSectorCount> m_erased;
+
+    // Image checksum up to m_checksumAddress, kept while data is written in ascending order
+    uint32_t m_checksum = 0;
+    uint32_t m_checksumAddress = Config::FirmwareStartAddress;
+    bool m_checksumValid = true;
 };
 
 // ---------------------------------------------------------------------------------------------- //
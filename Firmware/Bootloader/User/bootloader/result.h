@@ -0,0 +1 @@
+../result.h
\ No newline at end of file
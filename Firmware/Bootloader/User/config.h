@@ -33,11 +33,14 @@ namespace Config {
     constexpr uint32_t RamStartAddress = 0x20000004; // 32 bits for bootflags
     constexpr uint32_t RamEndAddress = 0x2000a000; // 40 kB
 
+    constexpr size_t HostBufferSize = 8192; // Power of two, more than Protocol::UploadWindow
+
     constexpr uint32_t FlashStartAddress = FLASH_BASE;
     constexpr uint32_t FlashEndAddress = 0x08020000; // 128 kB
 
     constexpr uint32_t FirmwareStartSector = 24; // 24*2 kB bootloader space
     constexpr uint32_t FirmwareSectorCount = 40; // 78 kB firmware + 2 kB user page
+    constexpr uint32_t SectorSize = 0x800; // 2 kB pages, also the largest block written at once
 
     constexpr uint32_t FirmwareStartAddress = 0x0800c800; // Start of actual firmware
     constexpr uint32_t FirmwareEndAddress = FlashEndAddress - sizeof(uint64_t); // 32-bit CRC
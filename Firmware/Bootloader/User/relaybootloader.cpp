@@ -24,10 +24,25 @@
 #include "config.h"
 #include "relaybootloader.h"
 
+#include <cstdint>
+
 // ---------------------------------------------------------------------------------------------- //
 
 namespace {
-    constexpr char TokenSeparator = ' ';
+    using Protocol::Command;
+
+    constexpr char TokenSeparator = Protocol::TokenSeparator;
+
+    constexpr Error MissingArgumentError = Error("MISSING_ARGUMENT");
+    constexpr Error InvalidArgumentError = Error("INVALID_ARGUMENT");
+    constexpr Error UnknownCommandError = Error("UNKNOWN_COMMAND");
+    constexpr Error DataOverflowError = Error("DATA_OVERFLOW");
+    constexpr Error BlockTimeoutError = Error("BLOCK_TIMEOUT");
+    constexpr Error InvalidSequenceError = Error("INVALID_SEQUENCE");
+
+    // Leaving room for the request libIRB sends to resynchronize after a failed upload
+    static_assert(Config::HostBufferSize > Protocol::UploadWindow,
+                  "Host buffer must hold more than a full upload window");
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -56,82 +71,189 @@ void RelayBootloader::onHostDataReceived(const String& data)
     if (tokenCount < 1)
         return;
 
-    const String tag = data.getToken(TokenSeparator, 0);
+    const auto tag = Protocol::tagOf({ data.data(), data.size() });
+    const Protocol::CommandInfo* command = Protocol::find(tag);
 
-    if (tag == "<ERASE_SECTOR>" || tag == "<WRITE_HEX_RECORD>")
+    if (!command || !(command->modes & Protocol::BootloaderMode))
+        return sendError(UnknownCommandError);
+
+    if (tokenCount - 1 < command->minArguments)
+        return sendError(MissingArgumentError);
+
+    if (tokenCount - 1 > command->maxArguments)
+        return sendError(InvalidArgumentError);
+
+    switch (command->command)
     {
-        if (tokenCount < 2)
-            return sendError("MISSING_ARGUMENT");
+    case Command::EraseSector:
+        protocolEraseSector(data.getToken(TokenSeparator, 1));
+        break;
 
-        const String argument = data.getToken(TokenSeparator, 1);
+    case Command::EraseTail:
+        protocolEraseTail(data.getToken(TokenSeparator, 1));
+        break;
 
-        if (tag == "<ERASE_SECTOR>")
-            protocolEraseSector(argument);
-        else if (tag == "<WRITE_HEX_RECORD>")
-            protocolWriteHexRecord(argument);
-    }
-    else if (tag == "<GET_BOOT_MODE>")
+    case Command::WriteHexRecord:
+        protocolWriteHexRecord(data, tokenCount);
+        break;
+
+    case Command::WriteBlock:
+        protocolWriteBlock(data, tokenCount, false);
+        break;
+
+    case Command::WritePackedBlock:
+        protocolWriteBlock(data, tokenCount, true);
+        break;
+
+    case Command::GetBootMode:
         protocolGetBootMode();
-    else if (tag == "<GET_BOARD_NAME>")
+        break;
+
+    case Command::GetBoardName:
         protocolGetBoardName();
-    else if (tag == "<GET_HARDWARE_VERSION>")
+        break;
+
+    case Command::GetHardwareVersion:
         protocolGetHardwareVersion();
-    else if (tag == "<GET_BOOTLOADER_VERSION>")
+        break;
+
+    case Command::GetBootloaderVersion:
         protocolGetBootloaderVersion();
-    else if (tag == "<GET_SECTOR_COUNT>")
+        break;
+
+    case Command::GetSectorCount:
         protocolGetSectorCount();
-    else if (tag == "<GET_FIRMWARE_VALID>")
+        break;
+
+    case Command::GetSectorChecksums:
+        protocolGetSectorChecksums();
+        break;
+
+    case Command::GetRangeChecksum:
+        protocolGetRangeChecksum(data);
+        break;
+
+    case Command::GetFirmwareValid:
         protocolGetFirmwareValid();
-    else if (tag == "<LAUNCH_FIRMWARE>")
+        break;
+
+    case Command::LaunchFirmware:
         protocolLaunchFirmware();
-    else if (tag == "<UNLOCK_FIRMWARE>")
+        break;
+
+    case Command::UnlockFirmware:
         protocolUnlockFirmware();
-    else if (tag == "<LOCK_FIRMWARE>")
+        break;
+
+    case Command::LockFirmware:
         protocolLockFirmware();
-    else
-        sendError("UNKNOWN_COMMAND");
+        break;
+
+    default:
+        sendError(UnknownCommandError);
+        break;
+    }
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBootloader::onHostDataOverflow()
 {
-    sendError("DATA_OVERFLOW");
+    sendError(DataOverflowError);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBootloader::onHostAttachmentReceived(size_t size)
+{
+    if (m_blockDiscarded)
+        return;
+
+    if (m_blockRejected)
+        return sendResult(Bootloader::InvalidLengthError, size);
+
+    if (size != m_attachmentSize)
+        return sendResult(BlockTimeoutError, size);
+
+    if (m_blockPacked)
+    {
+        return sendResult(Bootloader::writePackedBlock(m_blockAddress, m_block.data(), size,
+                                                       m_blockSize, m_blockChecksum), size);
+    }
+
+    sendResult(Bootloader::writeBlock(m_blockAddress, m_block.data(), m_blockSize,
+                                      m_blockChecksum), size);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBootloader::protocolGetBootMode()
 {
-    sendResponse("<BOOT_MODE>", "BOOTLOADER");
+    sendResponse(Command::GetBootMode, "BOOTLOADER");
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBootloader::protocolGetBoardName()
 {
-    sendResponse("<BOARD_NAME>", Config::BoardName);
+    sendResponse(Command::GetBoardName, Config::BoardName);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBootloader::protocolGetHardwareVersion()
 {
-    sendResponse("<HARDWARE_VERSION>", Config::HardwareVersion);
+    sendResponse(Command::GetHardwareVersion, Config::HardwareVersion);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBootloader::protocolGetBootloaderVersion()
 {
-    sendResponse("<BOOTLOADER_VERSION>", Config::BootloaderVersion);
+    sendResponse(Command::GetBootloaderVersion, Config::BootloaderVersion);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBootloader::protocolGetSectorCount()
 {
-    sendResponse("<SECTOR_COUNT>", String::format("%d", Config::FirmwareSectorCount));
+    sendResponse(Command::GetSectorCount, String::format("%d", Config::FirmwareSectorCount));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBootloader::protocolGetSectorChecksums()
+{
+    for (size_t sector = 0; sector < Config::FirmwareSectorCount; ++sector)
+    {
+        const auto address = static_cast<unsigned long>(getSectorAddress(sector).value());
+        const auto checksum = static_cast<unsigned long>(getSectorChecksum(sector).value());
+
+        sendResponse(Command::GetSectorChecksums,
+                     String::format("%u 0x%08lx,0x%08lx", static_cast<unsigned>(sector),
+                                    address, checksum));
+    }
+
+    sendResponse("<OK>");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBootloader::protocolGetRangeChecksum(const String& data)
+{
+    const auto address = data.getToken(TokenSeparator, 1).toULong();
+    const auto size = data.getToken(TokenSeparator, 2).toULong();
+
+    if (!address || !size)
+        return sendError(InvalidArgumentError);
+
+    const auto checksum = Bootloader::getRangeChecksum(address.value(), size.value());
+
+    if (!checksum)
+        return sendError(checksum.error());
+
+    sendResponse(Command::GetRangeChecksum,
+                 String::format("0x%08lx", static_cast<unsigned long>(checksum.value())));
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -139,7 +261,7 @@ void RelayBootloader::protocolGetSectorCount()
 void RelayBootloader::protocolGetFirmwareValid()
 {
     const char* valid = Bootloader::getFirmwareValid() ? "1" : "0";
-    sendResponse("<FIRMWARE_VALID>", valid);
+    sendResponse(Command::GetFirmwareValid, valid);
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -156,26 +278,21 @@ void RelayBootloader::protocolLaunchFirmware()
 
 void RelayBootloader::protocolUnlockFirmware()
 {
-    try {
-        Bootloader::unlockFirmware();
-        sendResponse("<OK>");
-    }
-    catch (const std::exception& e) {
-        sendError(e.what());
-    }
+    Bootloader::unlockFirmware();
+
+    m_uploadSequence = 0;
+    m_uploadFailed = false;
+    m_unacknowledgedBytes = 0;
+
+    sendResponse("<OK>");
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBootloader::protocolLockFirmware()
 {
-    try {
-        Bootloader::lockFirmware();
-        sendResponse("<OK>");
-    }
-    catch (const std::exception& e) {
-        sendError(e.what());
-    }
+    Bootloader::lockFirmware();
+    sendResponse("<OK>");
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -184,25 +301,148 @@ void RelayBootloader::protocolEraseSector(const String& data)
 {
     const auto sector = data.toULong();
 
-    try {
-        Bootloader::eraseSector(sector);
-        sendResponse("<OK>");
+    if (!sector)
+        return sendError(InvalidArgumentError);
+
+    if (auto result = Bootloader::eraseSector(sector.value()); !result)
+        return sendError(result.error());
+
+    sendResponse("<OK>");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBootloader::protocolEraseTail(const String& data)
+{
+    const auto sector = data.toULong();
+
+    if (!sector)
+        return sendError(InvalidArgumentError);
+
+    if (auto result = Bootloader::eraseTail(sector.value()); !result)
+        return sendError(result.error());
+
+    sendResponse("<OK>");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBootloader::protocolWriteHexRecord(const String& data, size_t tokenCount)
+{
+    if (!acceptSequence(data, tokenCount, 2))
+        return;
+
+    sendResult(Bootloader::writeHexRecord(data.getToken(TokenSeparator, 1).c_str()),
+               data.size());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBootloader::protocolWriteBlock(const String& data, size_t tokenCount, bool packed)
+{
+    const auto address = data.getToken(TokenSeparator, 1).toULong();
+
+    const String arguments = data.getToken(TokenSeparator, 2);
+    const auto size = arguments.getToken(',', 0).toULong();
+    const auto checksum = arguments.getToken(',', 1).toULong();
+    const auto packedSize = packed ? arguments.getToken(',', 2).toULong() : size;
+
+    // Attachments of an invalid length are dropped before reporting it, their bytes would be
+    // parsed as requests otherwise. Without a size there is no telling where the next request
+    // starts, so everything is dropped until the host waits for the response.
+    if (!packedSize || packedSize.value() == 0 || packedSize.value() > m_block.size())
+    {
+        // Answered with UPLOAD_NAK in a sequenced upload like any other failed block
+        m_blockDiscarded = !acceptSequence(data, tokenCount, 3);
+        m_blockRejected = true;
+
+        return m_hostInterface.discardAttachment(packedSize ? packedSize.value() : SIZE_MAX);
+    }
+
+    m_blockRejected = false;
+    m_blockPacked = packed;
+    m_attachmentSize = packedSize.value();
+    m_blockDiscarded = !acceptSequence(data, tokenCount, 3);
+
+    m_hostInterface.receiveAttachment(m_block.data(), m_attachmentSize);
+
+    if (m_blockDiscarded)
+        return;
+
+    if (!address || !size || !checksum)
+    {
+        m_blockDiscarded = true;
+        return sendResult(InvalidArgumentError, 0);
+    }
+
+    m_blockAddress = address.value();
+    m_blockSize = size.value();
+    m_blockChecksum = checksum.value();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBootloader::acceptSequence(const String& data, size_t tokenCount,
+                                     size_t sequenceToken) -> bool
+{
+    m_sequenced = tokenCount > sequenceToken;
+
+    if (!m_sequenced)
+        return true;
+
+    const auto sequence = data.getToken(TokenSeparator, sequenceToken).toULong();
+
+    if (!sequence)
+    {
+        m_sequenced = false;
+        sendError(InvalidArgumentError);
+        return false;
     }
-    catch (const std::exception& e) {
-        sendError(e.what());
+
+    if (sequence.value() == m_uploadSequence)
+    {
+        m_uploadFailed = false;
+        return true;
     }
+
+    // After a failure everything up to the resent request is dropped, it has been reported once
+    if (sequence.value() > m_uploadSequence && !m_uploadFailed)
+        sendResult(InvalidSequenceError, 0);
+
+    return false;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayBootloader::protocolWriteHexRecord(const String& data)
+void RelayBootloader::sendResult(const Result<>& result, size_t size)
 {
-    try {
-        Bootloader::writeHexRecord(data.c_str());
-        sendResponse("<OK>");
+    if (!m_sequenced)
+    {
+        if (!result)
+            return sendError(result.error());
+
+        return sendResponse("<OK>");
+    }
+
+    const auto sequence = static_cast<unsigned long>(m_uploadSequence);
+
+    if (!result)
+    {
+        m_uploadFailed = true;
+        m_unacknowledgedBytes = 0;
+
+        return sendResponse(Protocol::UploadNakTag.data(),
+                            String::format("%lu,%s", sequence, result.error().code()));
     }
-    catch (const std::exception& e) {
-        sendError(e.what());
+
+    ++m_uploadSequence;
+    m_unacknowledgedBytes += size;
+
+    // Acknowledged in batches, but never leaving the host waiting for data already processed
+    if (!m_hostInterface.dataPending() || m_unacknowledgedBytes >= Protocol::UploadWindow / 2)
+    {
+        m_unacknowledgedBytes = 0;
+        sendResponse(Protocol::UploadAckTag.data(), String::format("%lu", sequence));
     }
 }
 
@@ -220,9 +460,16 @@ void RelayBootloader::sendResponse(const String& tag, const String& data)
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayBootloader::sendError(const String& error)
+void RelayBootloader::sendResponse(Protocol::Command command, const String& data)
+{
+    sendResponse(Protocol::info(command).response.data(), data);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBootloader::sendError(const Error& error)
 {
-    m_hostInterface.sendData("<ERROR> " + error);
+    m_hostInterface.sendData("<ERROR> " + String(error.code()));
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -23,10 +23,14 @@
 
 #pragma once
 
+#include "config.h"
 #include "hostinterface.h"
+#include "protocol.h"
 
 #include "bootloader/bootloader.h"
 
+#include <array>
+
 class RelayBootloader : public Bootloader, public HostInterface::Owner
 {
 public:
@@ -37,6 +41,7 @@ public:
 private:
     void onHostDataReceived(const String& data) override;
     void onHostDataOverflow() override;
+    void onHostAttachmentReceived(size_t size) override;
 
     void protocolGetBootMode();
 
@@ -44,6 +49,8 @@ private:
     void protocolGetHardwareVersion();
     void protocolGetBootloaderVersion();
     void protocolGetSectorCount();
+    void protocolGetSectorChecksums();
+    void protocolGetRangeChecksum(const String& data);
     void protocolGetFirmwareValid();
 
     void protocolLaunchFirmware();
@@ -52,11 +59,33 @@ private:
     void protocolLockFirmware();
 
     void protocolEraseSector(const String& data);
-    void protocolWriteHexRecord(const String& data);
+    void protocolEraseTail(const String& data);
+    void protocolWriteHexRecord(const String& data, size_t tokenCount);
+    void protocolWriteBlock(const String& data, size_t tokenCount, bool packed);
+
+    // Sequenced requests, see Protocol::UploadWindow. Replies to the sequence number itself.
+    auto acceptSequence(const String& data, size_t tokenCount, size_t sequenceToken) -> bool;
+    void sendResult(const Result<>& result, size_t size);
 
     void sendResponse(const String& tag, const String& data = {});
-    void sendError(const String& error);
+    void sendResponse(Protocol::Command command, const String& data);
+    void sendError(const Error& error);
 
 private:
     HostInterface m_hostInterface;
+
+    // Attachment of the pending WRITE_BLOCK or WRITE_PACKED_BLOCK
+    std::array<uint8_t, Config::SectorSize> m_block = {};
+    uint32_t m_blockAddress = 0;
+    size_t m_blockSize = 0;
+    size_t m_attachmentSize = 0;
+    uint32_t m_blockChecksum = 0;
+    bool m_blockPacked = false;
+    bool m_blockDiscarded = false; // Already answered
+    bool m_blockRejected = false;  // Invalid length, answered once dropped
+
+    bool m_sequenced = false;
+    uint32_t m_uploadSequence = 0;
+    bool m_uploadFailed = false;
+    size_t m_unacknowledgedBytes = 0;
 };
@@ -0,0 +1 @@
+../../Common/result.h
\ No newline at end of file
@@ -26,6 +26,8 @@
 
 #include "usbd_cdc_if.h"
 
+#include <algorithm>
+
 // ---------------------------------------------------------------------------------------------- //
 
 HostInterface* HostInterface::s_instance = nullptr;
@@ -59,21 +61,17 @@ void HostInterface::update()
 {
     if (m_dataOverflow)
     {
+        m_bufferTail = m_bufferHead;
         m_currentData.clear();
+        m_attachmentPending = false;
         m_dataOverflow = false;
 
         m_owner->onHostDataOverflow();
     }
-    else if (m_dataReceived)
-    {
-        // New data may arrive before call to onHostDataReceived() returns
-        const String data = m_currentData;
-
-        m_currentData.clear();
-        m_dataReceived = false;
-
-        m_owner->onHostDataReceived(data);
-    }
+    else if (m_attachmentPending)
+        updateAttachment();
+    else
+        updateLine();
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -99,27 +97,131 @@ void HostInterface::sendData(String data)
 
 // ---------------------------------------------------------------------------------------------- //
 
+void HostInterface::receiveAttachment(uint8_t* buffer, size_t size)
+{
+    ASSERT(buffer != nullptr);
+
+    m_attachmentPending = true;
+    m_attachment = buffer;
+    m_attachmentSize = size;
+    m_attachmentReceived = 0;
+    m_attachmentStart = HAL_GetTick();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HostInterface::discardAttachment(size_t size)
+{
+    m_attachmentPending = true;
+    m_attachment = nullptr;
+    m_attachmentSize = size;
+    m_attachmentReceived = 0;
+    m_attachmentStart = HAL_GetTick();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HostInterface::dataPending() const -> bool
+{
+    return m_bufferHead != m_bufferTail;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HostInterface::updateLine()
+{
+    const uint32_t head = m_bufferHead;
+    uint32_t tail = m_bufferTail;
+
+    while (tail != head)
+    {
+        const char c = static_cast<char>(m_buffer[tail++ % m_buffer.size()]);
+
+        if (m_discardLine)
+        {
+            m_discardLine = (c != '\n');
+            continue;
+        }
+
+        if (m_currentData.size() == m_currentData.capacity())
+        {
+            m_currentData.clear();
+            m_discardLine = (c != '\n');
+            m_bufferTail = tail;
+
+            return m_owner->onHostDataOverflow();
+        }
+
+        m_currentData += c;
+
+        if (m_currentData.endsWith(LineTerminator))
+        {
+            m_currentData.trim(LineTerminatorSize);
+            m_bufferTail = tail;
+
+            // One line per call, the owner may want the following bytes as an attachment
+            m_owner->onHostDataReceived(m_currentData);
+            m_currentData.clear();
+
+            return;
+        }
+    }
+
+    m_bufferTail = tail;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HostInterface::updateAttachment()
+{
+    const uint32_t head = m_bufferHead;
+    uint32_t tail = m_bufferTail;
+
+    if (m_attachment)
+    {
+        while (tail != head && m_attachmentReceived < m_attachmentSize)
+            m_attachment[m_attachmentReceived++] = m_buffer[tail++ % m_buffer.size()];
+    }
+    else if (tail != head)
+    {
+        const size_t count = std::min<size_t>(head - tail, m_attachmentSize - m_attachmentReceived);
+
+        tail += count;
+        m_attachmentReceived += count;
+        m_attachmentStart = HAL_GetTick();
+    }
+
+    m_bufferTail = tail;
+
+    const bool complete = m_attachmentReceived == m_attachmentSize;
+
+    if (complete || HAL_GetTick() - m_attachmentStart >= AttachmentTimeout)
+    {
+        m_attachmentPending = false;
+        m_owner->onHostAttachmentReceived(m_attachmentReceived);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void HostInterface::processData(const uint8_t* data, uint32_t size)
 {
     if (m_dataOverflow)
         return;
 
-    if (m_dataReceived || m_currentData.size() + size > m_currentData.capacity())
-        m_dataOverflow = true;
-    else
+    const uint32_t head = m_bufferHead;
+
+    // Dropping part of a packet would corrupt the stream unnoticed, so all of it is reported
+    if (size > m_buffer.size() - (head - m_bufferTail))
     {
-        for (uint32_t i = 0; i < size; ++i)
-        {
-            m_currentData += data[i];
-
-            if (m_currentData.endsWith(LineTerminator))
-            {
-                m_currentData.trim(LineTerminatorSize);
-                m_dataReceived = true;
-                return;
-            }
-        }
+        m_dataOverflow = true;
+        return;
     }
+
+    for (uint32_t i = 0; i < size; ++i)
+        m_buffer[(head + i) % m_buffer.size()] = data[i];
+
+    m_bufferHead = head + size;
 }
 
 // ---------------------------------------------------------------------------------------------- //
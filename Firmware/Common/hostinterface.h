@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include "config.h"
 #include "defaultstring.h"
 
 #include <array>
@@ -33,11 +34,17 @@ public:
     static constexpr const char* LineTerminator = "\r\n";
     static constexpr size_t LineTerminatorSize = 2;
 
+    // Time in ms after which an incomplete attachment is handed over as is
+    static constexpr uint32_t AttachmentTimeout = 500;
+
     class Owner
     {
         friend class HostInterface;
         virtual void onHostDataReceived(const String& data) = 0;
         virtual void onHostDataOverflow() = 0;
+
+        // Only needed by owners that call receiveAttachment()
+        virtual void onHostAttachmentReceived(size_t) {}
     };
 
 public:
@@ -48,7 +55,21 @@ public:
 
     void sendData(String data);
 
+    // Stores the next size bytes in buffer instead of parsing them as a line, may be called from
+    // onHostDataReceived(). onHostAttachmentReceived() reports the number of bytes received.
+    void receiveAttachment(uint8_t* buffer, size_t size);
+
+    // Same for an attachment that cannot be stored, its bytes are dropped. The timeout restarts
+    // with every byte, so SIZE_MAX drops everything until the host waits for a response.
+    void discardAttachment(size_t size);
+
+    // Whether the host has sent more than has been handed over so far
+    auto dataPending() const -> bool;
+
 protected:
+    void updateLine();
+    void updateAttachment();
+
     void processData(const uint8_t* data, uint32_t size);
 
     static void cdcReceiveCallback(uint8_t* buffer, uint32_t size);
@@ -56,11 +77,25 @@ protected:
 
 private:
     Owner* m_owner;
-    String m_currentData;
 
-    volatile bool m_dataReceived = false;
+    // Filled by the USB interrupt, free-running indices so the whole buffer can be used
+    std::array<uint8_t, Config::HostBufferSize> m_buffer = {};
+    volatile uint32_t m_bufferHead = 0;
+    volatile uint32_t m_bufferTail = 0;
     volatile bool m_dataOverflow = false;
 
+    String m_currentData;
+    bool m_discardLine = false;
+
+    bool m_attachmentPending = false;
+    uint8_t* m_attachment = nullptr;
+    size_t m_attachmentSize = 0;
+    size_t m_attachmentReceived = 0;
+    uint32_t m_attachmentStart = 0;
+
     volatile bool m_txComplete = true;
     static HostInterface* s_instance;
+
+    static_assert((Config::HostBufferSize & (Config::HostBufferSize - 1)) == 0,
+                  "Host buffer size must be a power of two");
 };
@@ -0,0 +1,350 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Single description of every command tag shared by the firmware, the bootloader and libIRB.
+// Both ends dispatch, check argument counts and match response tags through this table, so
+// adding a command here is the only place where the two can disagree about its shape.
+namespace Protocol {
+
+constexpr char TokenSeparator = ' ';
+constexpr char ValueSeparator = ',';
+
+constexpr std::string_view OkTag = "<OK>";
+constexpr std::string_view ErrorTag = "<ERROR>";
+
+// Sequenced WRITE_HEX_RECORD, WRITE_BLOCK and WRITE_PACKED_BLOCK requests are not answered one
+// by one. The bootloader acknowledges all requests up to a number at once or names the one to
+// resend from, and hosts may have at most this many bytes of unacknowledged requests in flight.
+constexpr std::string_view UploadAckTag = "<UPLOAD_ACK>";
+constexpr std::string_view UploadNakTag = "<UPLOAD_NAK>";
+constexpr size_t UploadWindow = 6144;
+
+enum class Command : uint8_t
+{
+    Reset,
+    GetFaultMask,
+    SetRelayState,
+    GetRelayState,
+    SetStateMask,
+    GetStateMask,
+    GetRelayPower,
+    GetRelayWattage,
+    GetEnergyCounters,
+    ResetEnergyCounters,
+    ArmCapture,
+    DisarmCapture,
+    GetCaptureStatus,
+    ReadCapture,
+    CharacterizeRelay,
+    GetCharacterizationStatus,
+    GetSwitchTiming,
+    ClearFault,
+    SetReclosePolicy,
+    GetReclosePolicy,
+    GetRecloseStatus,
+    SetPowerLimit,
+    GetPowerLimit,
+    SavePowerLimits,
+    SetBusSpeed,
+    GetBusSpeed,
+    SetFilter,
+    GetFilter,
+    SetProfileLimit,
+    StoreProfile,
+    GetProfiles,
+    GetProfileLimits,
+    LoadProfile,
+    GetJournalStatus,
+    ReadJournal,
+    GetPerfCounters,
+    GetPerfHistograms,
+    ResetPerfCounters,
+    GetDeviceTime,
+    SetTimestamps,
+    GetBootMode,
+    GetBoardName,
+    GetHardwareVersion,
+    GetFirmwareVersion,
+    GetSerialNumber,
+    GetBuildTimestamp,
+    LaunchBootloader,
+    GetBootloaderVersion,
+    GetSectorCount,
+    GetSectorChecksums,
+    GetRangeChecksum,
+    GetFirmwareValid,
+    UnlockFirmware,
+    LockFirmware,
+    EraseSector,
+    EraseTail,
+    WriteHexRecord,
+    WriteBlock,
+    WritePackedBlock,
+    LaunchFirmware
+};
+
+enum class Reply : uint8_t
+{
+    Ok,     // <OK>
+    Value,  // <RESPONSE_TAG> value
+    List    // <RESPONSE_TAG> index value, one line per item, followed by <OK>
+};
+
+// Which of the two programs on the board understands a command
+enum Mode : uint8_t
+{
+    FirmwareMode   = 0x1,
+    BootloaderMode = 0x2,
+    AnyMode        = FirmwareMode | BootloaderMode
+};
+
+// Tags are string literals, so data() may be passed on wherever a C string is expected
+struct CommandInfo
+{
+    Command command;
+    std::string_view tag;
+    uint8_t minArguments;
+    uint8_t maxArguments;
+    Reply reply;
+    std::string_view response;
+    uint8_t modes;
+};
+
+// Arguments are counted as tokens following the tag, comma-separated values form one token
+inline constexpr std::array Commands = {
+    CommandInfo { Command::Reset, "<RESET>", 0, 0,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetFaultMask, "<GET_FAULT_MASK>", 0, 0,
+                  Reply::Value, "<FAULT_MASK>", FirmwareMode },
+    CommandInfo { Command::SetRelayState, "<SET_RELAY_STATE>", 2, 2,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetRelayState, "<GET_RELAY_STATE>", 1, 1,
+                  Reply::Value, "<RELAY_STATE>", FirmwareMode },
+    CommandInfo { Command::SetStateMask, "<SET_STATE_MASK>", 1, 1,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetStateMask, "<GET_STATE_MASK>", 0, 0,
+                  Reply::Value, "<STATE_MASK>", FirmwareMode },
+    CommandInfo { Command::GetRelayPower, "<GET_RELAY_POWER>", 1, 1,
+                  Reply::Value, "<RELAY_POWER>", FirmwareMode },
+    CommandInfo { Command::GetRelayWattage, "<GET_RELAY_WATTAGE>", 1, 1,
+                  Reply::Value, "<RELAY_WATTAGE>", FirmwareMode },
+    CommandInfo { Command::GetEnergyCounters, "<GET_ENERGY_COUNTERS>", 0, 0,
+                  Reply::List, "<ENERGY_COUNTER>", FirmwareMode },
+    CommandInfo { Command::ResetEnergyCounters, "<RESET_ENERGY_COUNTERS>", 0, 1,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::ArmCapture, "<ARM_CAPTURE>", 2, 2,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::DisarmCapture, "<DISARM_CAPTURE>", 0, 0,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetCaptureStatus, "<GET_CAPTURE_STATUS>", 0, 0,
+                  Reply::Value, "<CAPTURE_STATUS>", FirmwareMode },
+    CommandInfo { Command::ReadCapture, "<READ_CAPTURE>", 0, 0,
+                  Reply::List, "<CAPTURE_SAMPLE>", FirmwareMode },
+    CommandInfo { Command::CharacterizeRelay, "<CHARACTERIZE_RELAY>", 1, 1,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetCharacterizationStatus, "<GET_CHARACTERIZATION_STATUS>", 0, 0,
+                  Reply::Value, "<CHARACTERIZATION_STATUS>", FirmwareMode },
+    CommandInfo { Command::GetSwitchTiming, "<GET_SWITCH_TIMING>", 1, 1,
+                  Reply::Value, "<SWITCH_TIMING>", FirmwareMode },
+    CommandInfo { Command::ClearFault, "<CLEAR_FAULT>", 1, 1,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::SetReclosePolicy, "<SET_RECLOSE_POLICY>", 2, 2,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetReclosePolicy, "<GET_RECLOSE_POLICY>", 1, 1,
+                  Reply::Value, "<RECLOSE_POLICY>", FirmwareMode },
+    CommandInfo { Command::GetRecloseStatus, "<GET_RECLOSE_STATUS>", 1, 1,
+                  Reply::Value, "<RECLOSE_STATUS>", FirmwareMode },
+    CommandInfo { Command::SetPowerLimit, "<SET_POWER_LIMIT>", 2, 2,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetPowerLimit, "<GET_POWER_LIMIT>", 1, 1,
+                  Reply::Value, "<POWER_LIMIT>", FirmwareMode },
+    CommandInfo { Command::SavePowerLimits, "<SAVE_POWER_LIMITS>", 0, 0,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::SetBusSpeed, "<SET_BUS_SPEED>", 1, 1,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetBusSpeed, "<GET_BUS_SPEED>", 0, 0,
+                  Reply::Value, "<BUS_SPEED>", FirmwareMode },
+    CommandInfo { Command::SetFilter, "<SET_FILTER>", 2, 2,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetFilter, "<GET_FILTER>", 2, 2,
+                  Reply::Value, "<FILTER>", FirmwareMode },
+    CommandInfo { Command::SetProfileLimit, "<SET_PROFILE_LIMIT>", 2, 2,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::StoreProfile, "<STORE_PROFILE>", 2, 2,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetProfiles, "<GET_PROFILES>", 0, 0,
+                  Reply::List, "<PROFILE>", FirmwareMode },
+    CommandInfo { Command::GetProfileLimits, "<GET_PROFILE_LIMITS>", 1, 1,
+                  Reply::List, "<PROFILE_LIMIT>", FirmwareMode },
+    CommandInfo { Command::LoadProfile, "<LOAD_PROFILE>", 1, 1,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetJournalStatus, "<GET_JOURNAL_STATUS>", 0, 0,
+                  Reply::Value, "<JOURNAL_STATUS>", FirmwareMode },
+    CommandInfo { Command::ReadJournal, "<READ_JOURNAL>", 1, 1,
+                  Reply::List, "<JOURNAL_ENTRY>", FirmwareMode },
+    CommandInfo { Command::GetPerfCounters, "<GET_PERF_COUNTERS>", 0, 0,
+                  Reply::List, "<PERF_COUNTER>", FirmwareMode },
+    CommandInfo { Command::GetPerfHistograms, "<GET_PERF_HISTOGRAMS>", 0, 0,
+                  Reply::List, "<PERF_HISTOGRAM>", FirmwareMode },
+    CommandInfo { Command::ResetPerfCounters, "<RESET_PERF_COUNTERS>", 0, 0,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetDeviceTime, "<GET_DEVICE_TIME>", 0, 0,
+                  Reply::Value, "<DEVICE_TIME>", FirmwareMode },
+    CommandInfo { Command::SetTimestamps, "<SET_TIMESTAMPS>", 1, 1,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetBootMode, "<GET_BOOT_MODE>", 0, 0,
+                  Reply::Value, "<BOOT_MODE>", AnyMode },
+    CommandInfo { Command::GetBoardName, "<GET_BOARD_NAME>", 0, 0,
+                  Reply::Value, "<BOARD_NAME>", AnyMode },
+    CommandInfo { Command::GetHardwareVersion, "<GET_HARDWARE_VERSION>", 0, 0,
+                  Reply::Value, "<HARDWARE_VERSION>", AnyMode },
+    CommandInfo { Command::GetFirmwareVersion, "<GET_FIRMWARE_VERSION>", 0, 0,
+                  Reply::Value, "<FIRMWARE_VERSION>", FirmwareMode },
+    CommandInfo { Command::GetSerialNumber, "<GET_SERIAL_NUMBER>", 0, 0,
+                  Reply::Value, "<SERIAL_NUMBER>", FirmwareMode },
+    CommandInfo { Command::GetBuildTimestamp, "<GET_BUILD_TIMESTAMP>", 0, 0,
+                  Reply::Value, "<BUILD_TIMESTAMP>", FirmwareMode },
+    CommandInfo { Command::LaunchBootloader, "<LAUNCH_BOOTLOADER>", 0, 0,
+                  Reply::Ok, "", FirmwareMode },
+    CommandInfo { Command::GetBootloaderVersion, "<GET_BOOTLOADER_VERSION>", 0, 0,
+                  Reply::Value, "<BOOTLOADER_VERSION>", BootloaderMode },
+    CommandInfo { Command::GetSectorCount, "<GET_SECTOR_COUNT>", 0, 0,
+                  Reply::Value, "<SECTOR_COUNT>", BootloaderMode },
+    CommandInfo { Command::GetSectorChecksums, "<GET_SECTOR_CRCS>", 0, 0,
+                  Reply::List, "<SECTOR_CRC>", BootloaderMode },
+    CommandInfo { Command::GetRangeChecksum, "<GET_RANGE_CRC>", 2, 2,
+                  Reply::Value, "<RANGE_CRC>", BootloaderMode },
+    CommandInfo { Command::GetFirmwareValid, "<GET_FIRMWARE_VALID>", 0, 0,
+                  Reply::Value, "<FIRMWARE_VALID>", BootloaderMode },
+    CommandInfo { Command::UnlockFirmware, "<UNLOCK_FIRMWARE>", 0, 0,
+                  Reply::Ok, "", BootloaderMode },
+    CommandInfo { Command::LockFirmware, "<LOCK_FIRMWARE>", 0, 0,
+                  Reply::Ok, "", BootloaderMode },
+    CommandInfo { Command::EraseSector, "<ERASE_SECTOR>", 1, 1,
+                  Reply::Ok, "", BootloaderMode },
+    CommandInfo { Command::EraseTail, "<ERASE_TAIL>", 1, 1,
+                  Reply::Ok, "", BootloaderMode },
+    CommandInfo { Command::WriteHexRecord, "<WRITE_HEX_RECORD>", 1, 2,
+                  Reply::Ok, "", BootloaderMode },
+    CommandInfo { Command::WriteBlock, "<WRITE_BLOCK>", 2, 3,
+                  Reply::Ok, "", BootloaderMode },
+    CommandInfo { Command::WritePackedBlock, "<WRITE_PACKED_BLOCK>", 2, 3,
+                  Reply::Ok, "", BootloaderMode },
+    CommandInfo { Command::LaunchFirmware, "<LAUNCH_FIRMWARE>", 0, 0,
+                  Reply::Ok, "", BootloaderMode }
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+constexpr auto info(Command command) -> const CommandInfo&
+{
+    return Commands[static_cast<size_t>(command)];
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace Detail {
+    constexpr auto hasEnumOrder() -> bool
+    {
+        for (size_t i = 0; i < Commands.size(); ++i)
+        {
+            if (static_cast<size_t>(Commands[i].command) != i)
+                return false;
+        }
+
+        return true;
+    }
+
+    constexpr auto sortedByTag() -> std::array<const CommandInfo*, Commands.size()>
+    {
+        std::array<const CommandInfo*, Commands.size()> sorted = {};
+
+        for (size_t i = 0; i < Commands.size(); ++i)
+            sorted[i] = &Commands[i];
+
+        std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) {
+            return a->tag < b->tag;
+        });
+
+        return sorted;
+    }
+
+    inline constexpr auto SortedCommands = sortedByTag();
+
+    constexpr auto hasUniqueTags() -> bool
+    {
+        for (size_t i = 1; i < SortedCommands.size(); ++i)
+        {
+            if (SortedCommands[i - 1]->tag == SortedCommands[i]->tag)
+                return false;
+        }
+
+        return true;
+    }
+}
+
+static_assert(Detail::hasEnumOrder(), "Commands must be listed in the order of their enum");
+static_assert(Detail::hasUniqueTags(), "Command tags must be unique");
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Binary search over the tags sorted at compile time, nullptr if the tag is unknown
+constexpr auto find(std::string_view tag) -> const CommandInfo*
+{
+    const auto& sorted = Detail::SortedCommands;
+
+    const auto it = std::lower_bound(sorted.begin(), sorted.end(), tag,
+                                     [](const CommandInfo* info, std::string_view tag) {
+        return info->tag < tag;
+    });
+
+    if (it == sorted.end() || (*it)->tag != tag)
+        return nullptr;
+
+    return *it;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// The tag of a request line without copying it, the line does not have to be terminated
+constexpr auto tagOf(std::string_view line) -> std::string_view
+{
+    return line.substr(0, line.find(TokenSeparator));
+}
+
+static_assert(find("<GET_RELAY_STATE>")->command == Command::GetRelayState);
+static_assert(find("<GET_RELAY_STATE") == nullptr);
+static_assert(tagOf("<ERASE_SECTOR> 3") == "<ERASE_SECTOR>");
+
+} // namespace Protocol
+
+// ---------------------------------------------------------------------------------------------- //
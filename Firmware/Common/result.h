@@ -0,0 +1,81 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "assert.h"
+
+#include <utility>
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Error codes are sent to the host as they are, e.g. "<ERROR> INVALID_ARGUMENT"
+class Error
+{
+public:
+    constexpr explicit Error(const char* code) : m_code(code) {}
+
+    constexpr auto code() const -> const char* { return m_code; }
+
+private:
+    const char* m_code;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+template <typename T = void>
+class Result
+{
+public:
+    constexpr Result(const T& value) : m_value(value) {}
+    constexpr Result(T&& value) : m_value(std::move(value)) {}
+    constexpr Result(Error error) : m_error(error.code()) {}
+
+    constexpr explicit operator bool() const { return m_error == nullptr; }
+
+    constexpr auto value() const -> const T& { ASSERT(m_error == nullptr); return m_value; }
+    constexpr auto error() const -> Error { ASSERT(m_error != nullptr); return Error(m_error); }
+
+private:
+    T m_value = {};
+    const char* m_error = nullptr;
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+template <>
+class Result<void>
+{
+public:
+    constexpr Result() = default;
+    constexpr Result(Error error) : m_error(error.code()) {}
+
+    constexpr explicit operator bool() const { return m_error == nullptr; }
+
+    constexpr auto error() const -> Error { ASSERT(m_error != nullptr); return Error(m_error); }
+
+private:
+    const char* m_error = nullptr;
+};
+
+// ---------------------------------------------------------------------------------------------- //
@@ -25,9 +25,11 @@
 #define STATICSTRING_H
 
 #include "assert.h"
+#include "result.h"
 
 #include <algorithm>
 #include <array>
+#include <cerrno>
 #include <cstdarg>
 #include <cstdlib>
 #include <cstring>
@@ -35,6 +37,24 @@
 
 // ---------------------------------------------------------------------------------------------- //
 
+#ifdef STATICSTRING_STATISTICS
+// Lets host builds count the copies made, every one costs a loop over the contents on the device
+struct StaticStringStatistics
+{
+    static inline size_t copies = 0;
+    static inline size_t bytes = 0;
+
+    static void add(size_t size) { ++copies; bytes += size; }
+    static void reset() { copies = 0; bytes = 0; }
+};
+
+#define STATICSTRING_COUNT_COPY(size) StaticStringStatistics::add(size)
+#else
+#define STATICSTRING_COUNT_COPY(size)
+#endif
+
+// ---------------------------------------------------------------------------------------------- //
+
 template <size_t N>
 class StaticString
 {
@@ -61,6 +81,8 @@ public:
 
     static constexpr auto DefaultTokenBehavior = TokenBehavior::KeepEmptyTokens;
 
+    static constexpr Error NumberError = Error("INVALID_NUMBER");
+
 public:
     StaticString();
     StaticString(const StaticString& other);
@@ -98,10 +120,10 @@ public:
     auto getTokens(char separator, size_t first, size_t count,
                    TokenBehavior behavior = DefaultTokenBehavior) const -> StaticString;
 
-    auto toLong() const -> long;
-    auto toULong() const -> unsigned long;
-    auto toFloat() const -> float;
-    auto toDouble() const -> double;
+    auto toLong() const -> Result<long>;
+    auto toULong() const -> Result<unsigned long>;
+    auto toFloat() const -> Result<float>;
+    auto toDouble() const -> Result<double>;
 
     void fill(char c);
     void clear();
@@ -139,6 +161,9 @@ public:
 
     static auto format(const char* format, ...) -> StaticString;
 
+private:
+    auto isNumberEnd(const char* end) const -> bool;
+
 private:
     std::array<char, (N/4 + 1) * 4> m_data;
     size_t m_size = 0;
@@ -158,6 +183,8 @@ template <size_t N>
 StaticString<N>::StaticString(const StaticString& other)
     : m_size(other.m_size)
 {
+    STATICSTRING_COUNT_COPY(other.m_size);
+
     std::copy_n(std::begin(other.m_data), other.m_size, std::begin(m_data));
     m_data[m_size] = '\0';
 }
@@ -168,6 +195,8 @@ template <size_t N>
 StaticString<N>::StaticString(StaticString&& other) noexcept
     : m_size(other.m_size)
 {
+    STATICSTRING_COUNT_COPY(other.m_size);
+
     std::copy_n(std::begin(other.m_data), other.m_size, std::begin(m_data));
     m_data[m_size] = '\0';
 
@@ -215,6 +244,8 @@ StaticString<N>::StaticString(const char* string, size_t first, size_t last)
 template <size_t N>
 auto StaticString<N>::operator=(const StaticString& other) -> StaticString&
 {
+    STATICSTRING_COUNT_COPY(other.m_size);
+
     std::copy_n(std::begin(other.m_data), other.m_size, std::begin(m_data));
     m_size = other.m_size;
     m_data[m_size] = '\0';
@@ -227,6 +258,8 @@ auto StaticString<N>::operator=(const StaticString& other) -> StaticString&
 template <size_t N>
 auto StaticString<N>::operator=(StaticString&& other) noexcept -> StaticString&
 {
+    STATICSTRING_COUNT_COPY(other.m_size);
+
     std::copy_n(std::begin(other.m_data), other.m_size, std::begin(m_data));
     m_size = other.m_size;
     m_data[m_size] = '\0';
@@ -481,33 +514,74 @@ auto StaticString<N>::getTokens(char separator, size_t first, size_t count,
 // ---------------------------------------------------------------------------------------------- //
 
 template <size_t N>
-auto StaticString<N>::toLong() const -> long
+auto StaticString<N>::toLong() const -> Result<long>
+{
+    char* end = nullptr;
+    errno = 0;
+
+    const long value = std::strtol(m_data.data(), &end, 0);
+
+    if (!isNumberEnd(end))
+        return NumberError;
+
+    return value;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+template <size_t N>
+auto StaticString<N>::toULong() const -> Result<unsigned long>
 {
-    return std::strtol(m_data.data(), nullptr, 0);
+    char* end = nullptr;
+    errno = 0;
+
+    const unsigned long value = std::strtoul(m_data.data(), &end, 0);
+
+    if (!isNumberEnd(end))
+        return NumberError;
+
+    return value;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 template <size_t N>
-auto StaticString<N>::toULong() const -> unsigned long
+auto StaticString<N>::toFloat() const -> Result<float>
 {
-    return std::strtoul(m_data.data(), nullptr, 0);
+    char* end = nullptr;
+    errno = 0;
+
+    const float value = std::strtof(m_data.data(), &end);
+
+    if (!isNumberEnd(end))
+        return NumberError;
+
+    return value;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 template <size_t N>
-auto StaticString<N>::toFloat() const -> float
+auto StaticString<N>::toDouble() const -> Result<double>
 {
-    return std::strtof(m_data.data(), nullptr);
+    char* end = nullptr;
+    errno = 0;
+
+    const double value = std::strtod(m_data.data(), &end);
+
+    if (!isNumberEnd(end))
+        return NumberError;
+
+    return value;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 template <size_t N>
-auto StaticString<N>::toDouble() const -> double
+auto StaticString<N>::isNumberEnd(const char* end) const -> bool
 {
-    return std::strtod(m_data.data(), nullptr);
+    // The whole string must have been consumed without a range error
+    return m_size > 0 && end == m_data.data() + m_size && errno == 0;
 }
 
 // ---------------------------------------------------------------------------------------------- //
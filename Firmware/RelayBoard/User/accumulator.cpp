@@ -0,0 +1,71 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "accumulator.h"
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Accumulator::reset(uint64_t timestamp)
+{
+    m_charge = 0.0;
+    m_energy = 0.0;
+    m_duration = 0;
+    m_timestamp = timestamp;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Accumulator::update(float current, float power, uint64_t timestamp)
+{
+    // Sample-and-hold integration, each reading covers the time since the previous one
+    const uint64_t elapsed = timestamp - m_timestamp;
+    const double seconds = elapsed * 1e-6;
+
+    m_charge += current * seconds;
+    m_energy += power * seconds;
+    m_duration += elapsed;
+    m_timestamp = timestamp;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Accumulator::charge() const -> double
+{
+    return m_charge;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Accumulator::energy() const -> double
+{
+    return m_energy / 3600.0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Accumulator::duration() const -> double
+{
+    return m_duration * 1e-6;
+}
+
+// ---------------------------------------------------------------------------------------------- //
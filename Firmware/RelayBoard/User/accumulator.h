@@ -0,0 +1,43 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <cstdint>
+
+class Accumulator
+{
+public:
+    void reset(uint64_t timestamp);
+    void update(float current, float power, uint64_t timestamp);
+
+    auto charge() const -> double;   // C
+    auto energy() const -> double;   // Wh
+    auto duration() const -> double; // s
+
+private:
+    double m_charge = 0.0; // As
+    double m_energy = 0.0; // Ws
+    uint64_t m_duration = 0; // us
+    uint64_t m_timestamp = 0;
+};
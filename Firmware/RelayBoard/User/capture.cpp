@@ -0,0 +1,164 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "assert.h"
+#include "capture.h"
+#include "journal.h"
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Capture::arm(size_t channel, uint8_t triggerMask, float threshold)
+{
+    m_state = State::Armed;
+
+    m_channel = channel;
+    m_triggerMask = triggerMask;
+    m_threshold = threshold;
+    m_lastCurrent = threshold;
+
+    m_triggerSource = 0;
+    m_triggerTimestamp = 0;
+
+    m_writeIndex = 0;
+    m_sampleCount = 0;
+    m_remainingCount = 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Capture::disarm()
+{
+    m_state = State::Idle;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Capture::state() const -> State
+{
+    return m_state;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Capture::channel() const -> size_t
+{
+    return m_channel;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Capture::isSampling() const -> bool
+{
+    return m_state == State::Armed || m_state == State::Triggered;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Capture::isSampling(size_t channel) const -> bool
+{
+    return isSampling() && channel == m_channel;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Capture::addSample(size_t channel, uint64_t timestamp, float voltage, float current)
+{
+    if (!isSampling(channel))
+        return;
+
+    m_samples[m_writeIndex] = { static_cast<uint32_t>(timestamp), voltage, current };
+
+    if (++m_writeIndex >= SampleCount)
+        m_writeIndex = 0;
+
+    if (m_sampleCount < SampleCount)
+        ++m_sampleCount;
+
+    if (m_state == State::Triggered)
+    {
+        if (--m_remainingCount == 0)
+            m_state = State::Complete;
+
+        return;
+    }
+
+    // Rising edge only, a channel already above the threshold when armed does not fire
+    const bool crossed = m_lastCurrent < m_threshold && current >= m_threshold;
+    m_lastCurrent = current;
+
+    if (crossed)
+        trigger(channel, ThresholdTrigger, timestamp);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Capture::trigger(size_t channel, uint8_t source, uint64_t timestamp)
+{
+    if (m_state != State::Armed || channel != m_channel || !(m_triggerMask & source))
+        return;
+
+    m_state = State::Triggered;
+    m_triggerSource = source;
+    m_triggerTimestamp = timestamp;
+
+    // Keep at most PreTriggerCount samples from before the trigger
+    if (m_sampleCount > PreTriggerCount)
+        m_sampleCount = PreTriggerCount;
+
+    m_remainingCount = SampleCount - PreTriggerCount;
+
+    Journal::add(Journal::Event::CaptureTriggered, channel, source);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Capture::triggerSource() const -> uint8_t
+{
+    return m_triggerSource;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Capture::triggerTimestamp() const -> uint64_t
+{
+    return m_triggerTimestamp;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Capture::sampleCount() const -> size_t
+{
+    return m_sampleCount;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Capture::sample(size_t index) const -> const Sample&
+{
+    ASSERT(index < m_sampleCount);
+
+    const size_t first = (m_writeIndex + SampleCount - m_sampleCount) % SampleCount;
+    return m_samples[(first + index) % SampleCount];
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,90 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+class Capture
+{
+public:
+    static constexpr size_t SampleCount = 128;
+    static constexpr size_t PreTriggerCount = 32;
+
+    static constexpr uint8_t SwitchTrigger    = 0x01;
+    static constexpr uint8_t FaultTrigger     = 0x02;
+    static constexpr uint8_t ThresholdTrigger = 0x04;
+    static constexpr uint8_t AllTriggers      = 0x07;
+
+    enum class State
+    {
+        Idle,
+        Armed,
+        Triggered,
+        Complete
+    };
+
+    struct Sample
+    {
+        uint32_t timestamp; // Lower 32 bits of device time
+        float voltage;
+        float current;
+    };
+
+public:
+    void arm(size_t channel, uint8_t triggerMask, float threshold);
+    void disarm();
+
+    auto state() const -> State;
+    auto channel() const -> size_t;
+
+    auto isSampling() const -> bool;
+    auto isSampling(size_t channel) const -> bool;
+
+    void addSample(size_t channel, uint64_t timestamp, float voltage, float current);
+    void trigger(size_t channel, uint8_t source, uint64_t timestamp);
+
+    auto triggerSource() const -> uint8_t;
+    auto triggerTimestamp() const -> uint64_t;
+
+    auto sampleCount() const -> size_t;
+    auto sample(size_t index) const -> const Sample&; // Oldest first
+
+private:
+    State m_state = State::Idle;
+
+    size_t m_channel = 0;
+    uint8_t m_triggerMask = 0;
+    float m_threshold = 0.0F;
+    float m_lastCurrent = 0.0F;
+
+    uint8_t m_triggerSource = 0;
+    uint64_t m_triggerTimestamp = 0;
+
+    std::array<Sample, SampleCount> m_samples = {};
+    size_t m_writeIndex = 0;
+    size_t m_sampleCount = 0;
+    size_t m_remainingCount = 0;
+};
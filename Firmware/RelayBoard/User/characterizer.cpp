@@ -0,0 +1,254 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "characterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    // Number of trailing samples averaged for the final value of a phase
+    constexpr size_t FinalCount = 8;
+
+    // Time at which the deviation passes the level between two samples, assuming it
+    // changes linearly in between
+    auto interpolate(int32_t time0, float deviation0, int32_t time1, float deviation1,
+                     float level) -> uint32_t
+    {
+        float time = static_cast<float>(time1);
+
+        if (deviation1 != deviation0)
+        {
+            const float fraction = (level - deviation0) / (deviation1 - deviation0);
+            time = static_cast<float>(time0) + fraction * static_cast<float>(time1 - time0);
+        }
+
+        return static_cast<uint32_t>(std::lround(std::fmax(time, 0.0F)));
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Characterizer::start(size_t channel, uint64_t timestamp)
+{
+    m_state = State::Running;
+    m_channel = channel;
+    m_lastCurrentValid = false;
+    m_timing = {};
+
+    beginPhase(Phase::Baseline, timestamp);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Characterizer::abort()
+{
+    if (m_state == State::Running)
+        m_state = State::Failed;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Characterizer::state() const -> State
+{
+    return m_state;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Characterizer::channel() const -> size_t
+{
+    return m_channel;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Characterizer::isRunning() const -> bool
+{
+    return m_state == State::Running;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Characterizer::isMeasuring() const -> bool
+{
+    return m_state == State::Running && m_phase != Phase::Baseline;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Characterizer::addSample(uint64_t timestamp, float current)
+{
+    if (m_state != State::Running)
+        return;
+
+    m_lastCurrent = current;
+    m_lastCurrentValid = true;
+
+    if (m_phase == Phase::Baseline || m_sampleCount >= SampleCount)
+        return;
+
+    const auto time = static_cast<int64_t>(timestamp - m_phaseStart);
+    m_samples[m_sampleCount++] = { static_cast<int32_t>(time), current };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Characterizer::poll(uint64_t timestamp) -> Action
+{
+    if (m_state != State::Running || !isPhaseComplete(timestamp))
+        return Action::None;
+
+    switch (m_phase)
+    {
+    case Phase::Baseline:
+        beginPhase(Phase::On, timestamp);
+        return Action::SwitchOn;
+
+    case Phase::On:
+        if (!analyze(&m_timing.onDelay, &m_timing.onSettling, &m_timing.resolution))
+        {
+            m_state = State::Failed;
+            return Action::Finish;
+        }
+
+        beginPhase(Phase::Off, timestamp);
+        return Action::SwitchOff;
+
+    case Phase::Off:
+        if (!analyze(&m_timing.offDelay, &m_timing.offSettling, &m_timing.resolution))
+        {
+            m_state = State::Failed;
+            return Action::Finish;
+        }
+
+        m_timing.valid = true;
+        m_state = State::Complete;
+        return Action::Finish;
+    }
+
+    return Action::None;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Characterizer::timing() const -> const Timing&
+{
+    return m_timing;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Characterizer::beginPhase(Phase phase, uint64_t timestamp)
+{
+    // The last reading before switching is the level the step starts from
+    m_baseline = m_lastCurrent;
+
+    m_phase = phase;
+    m_phaseStart = timestamp;
+    m_sampleCount = 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Characterizer::isPhaseComplete(uint64_t timestamp) const -> bool
+{
+    if (m_phase == Phase::Baseline)
+        return m_lastCurrentValid && (timestamp - m_phaseStart) >= BaselineDuration;
+
+    return m_sampleCount >= SampleCount || (timestamp - m_phaseStart) >= PhaseDuration;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Characterizer::analyze(uint32_t* delay, uint32_t* settling, uint32_t* interval) const -> bool
+{
+    if (m_sampleCount < 2 * FinalCount)
+        return false;
+
+    float final = 0.0F;
+
+    for (size_t i = m_sampleCount - FinalCount; i < m_sampleCount; ++i)
+        final += m_samples[i].current;
+
+    final /= FinalCount;
+
+    // Without a load there is no step to time
+    const float step = std::fabs(final - m_baseline);
+
+    if (step < MinimumStep)
+        return false;
+
+    const auto deviation = [this](size_t index, float reference) {
+        return std::fabs(m_samples[index].current - reference);
+    };
+
+    const float crossingLevel = 0.5F * step;
+    const float settlingLevel = SettlingBand * step;
+
+    size_t crossing = 0;
+
+    while (crossing < m_sampleCount && deviation(crossing, m_baseline) < crossingLevel)
+        ++crossing;
+
+    // Settled from the first sample after the last one outside the band
+    size_t settled = m_sampleCount;
+
+    while (settled > 0 && deviation(settled - 1, final) <= settlingLevel)
+        --settled;
+
+    if (crossing == m_sampleCount || settled >= m_sampleCount - FinalCount)
+        return false;
+
+    // Without an earlier sample to interpolate from, the edge is put at the sample itself
+    const size_t beforeCrossing = (crossing > 0) ? crossing - 1 : crossing;
+    const size_t beforeSettled = (settled > 0) ? settled - 1 : settled;
+
+    *delay = interpolate(m_samples[beforeCrossing].time, deviation(beforeCrossing, m_baseline),
+                         m_samples[crossing].time, deviation(crossing, m_baseline),
+                         crossingLevel);
+
+    *settling = interpolate(m_samples[beforeSettled].time, deviation(beforeSettled, final),
+                            m_samples[settled].time, deviation(settled, final),
+                            settlingLevel);
+
+    // Raised to the longest interval an edge of either phase was interpolated across
+    *interval = std::max({ *interval, sampleInterval(crossing), sampleInterval(settled) });
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Characterizer::sampleInterval(size_t index) const -> uint32_t
+{
+    // The first sample has no predecessor, the interval to the next one is used instead
+    if (index == 0)
+        index = 1;
+
+    return static_cast<uint32_t>(m_samples[index].time - m_samples[index - 1].time);
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,125 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Measures how long a relay takes to conduct and to stop conducting after its GPIO is
+// written. The owner switches the relay when told to by poll() and feeds current samples.
+class Characterizer
+{
+public:
+    static constexpr size_t SampleCount = 128;
+
+    static constexpr uint32_t BaselineDuration = 20000; // us
+    static constexpr uint32_t PhaseDuration = 50000;    // us
+
+    static constexpr float MinimumStep = 0.010F; // A
+    static constexpr float SettlingBand = 0.05F; // Fraction of step
+
+    enum class State
+    {
+        Idle,
+        Running,
+        Complete,
+        Failed
+    };
+
+    enum class Action
+    {
+        None,
+        SwitchOn,
+        SwitchOff,
+        Finish
+    };
+
+    // Delay until half of the current step, settling until within the band for good,
+    // both in us after the GPIO write and interpolated between samples. Resolution is
+    // the longest interval between the samples any of them was interpolated from.
+    struct Timing
+    {
+        bool valid = false;
+        uint32_t onDelay = 0;
+        uint32_t onSettling = 0;
+        uint32_t offDelay = 0;
+        uint32_t offSettling = 0;
+        uint32_t resolution = 0;
+    };
+
+public:
+    void start(size_t channel, uint64_t timestamp);
+    void abort();
+
+    auto state() const -> State;
+    auto channel() const -> size_t;
+
+    auto isRunning() const -> bool;
+
+    // True while the relay has been switched and every conversion counts
+    auto isMeasuring() const -> bool;
+
+    // Timestamp is the middle of the conversion the current was averaged over
+    void addSample(uint64_t timestamp, float current);
+    auto poll(uint64_t timestamp) -> Action;
+
+    auto timing() const -> const Timing&;
+
+private:
+    enum class Phase
+    {
+        Baseline,
+        On,
+        Off
+    };
+
+    struct Sample
+    {
+        int32_t time; // us since phase start, negative if converted before
+        float current;
+    };
+
+    void beginPhase(Phase phase, uint64_t timestamp);
+    auto isPhaseComplete(uint64_t timestamp) const -> bool;
+
+    auto analyze(uint32_t* delay, uint32_t* settling, uint32_t* interval) const -> bool;
+    auto sampleInterval(size_t index) const -> uint32_t;
+
+private:
+    State m_state = State::Idle;
+    Phase m_phase = Phase::Baseline;
+
+    size_t m_channel = 0;
+    uint64_t m_phaseStart = 0;
+
+    float m_baseline = 0.0F;
+    float m_lastCurrent = 0.0F;
+    bool m_lastCurrentValid = false;
+
+    std::array<Sample, SampleCount> m_samples = {};
+    size_t m_sampleCount = 0;
+
+    Timing m_timing;
+};
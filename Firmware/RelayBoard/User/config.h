@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include "i2cbus.h"
 #include "main.h"
 
 extern I2C_HandleTypeDef hi2c1;
@@ -34,7 +35,11 @@ namespace Config {
 
     constexpr uint32_t UserPage = 24;
 
+    constexpr size_t HostBufferSize = 256; // Power of two, a few requests
+
     constexpr I2C_HandleTypeDef* PowerMonitorHandle = &hi2c1;
+    constexpr I2cBus::Speed PowerMonitorBusSpeed = I2cBus::Speed::Fast;
     constexpr float ShuntResistance = 0.025F;
+    constexpr float CurrentLsb = 100e-6F; // 3.2767 A full scale
 
 } // End of namespace Config
@@ -0,0 +1 @@
+../../Bootloader/User/bootloader/crc32.c
\ No newline at end of file
@@ -0,0 +1 @@
+../../Bootloader/User/bootloader/crc32.h
\ No newline at end of file
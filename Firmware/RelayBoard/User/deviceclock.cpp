@@ -0,0 +1,57 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "deviceclock.h"
+#include "main.h"
+
+// ---------------------------------------------------------------------------------------------- //
+
+uint32_t DeviceClock::s_lastCount = 0;
+uint64_t DeviceClock::s_cycles = 0;
+
+// ---------------------------------------------------------------------------------------------- //
+
+void DeviceClock::init()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    s_lastCount = 0;
+    s_cycles = 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto DeviceClock::now() -> uint64_t
+{
+    const uint32_t count = DWT->CYCCNT;
+
+    s_cycles += count - s_lastCount;
+    s_lastCount = count;
+
+    return s_cycles / (SystemCoreClock / 1000000);
+}
+
+// ---------------------------------------------------------------------------------------------- //
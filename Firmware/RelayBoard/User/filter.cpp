@@ -0,0 +1,111 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "assert.h"
+#include "filter.h"
+
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Filter::configure(const Settings& settings)
+{
+    ASSERT(settings.medianLength >= 1 && settings.medianLength <= MaximumMedianLength);
+    ASSERT(settings.timeConstant >= 0.0F && settings.timeConstant <= MaximumTimeConstant);
+
+    m_settings = settings;
+    reset();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Filter::settings() const -> const Settings&
+{
+    return m_settings;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Filter::reset()
+{
+    m_windowSize = 0;
+    m_windowIndex = 0;
+    m_averageValid = false;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Filter::update(float value, uint64_t timestamp) -> float
+{
+    if (m_settings.medianLength > 1)
+        value = median(value);
+
+    if (m_settings.timeConstant > 0.0F)
+        value = average(value, timestamp);
+
+    return value;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Filter::median(float value) -> float
+{
+    const uint8_t length = m_settings.medianLength;
+
+    m_window[m_windowIndex] = value;
+    m_windowIndex = (m_windowIndex + 1) % length;
+    m_windowSize = std::min<uint8_t>(m_windowSize + 1, length);
+
+    // Until the window is full, the median of the samples received so far
+    std::array<float, MaximumMedianLength> sorted = m_window;
+    const auto middle = sorted.begin() + m_windowSize / 2;
+
+    std::nth_element(sorted.begin(), middle, sorted.begin() + m_windowSize);
+
+    return *middle;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Filter::average(float value, uint64_t timestamp) -> float
+{
+    if (!m_averageValid)
+    {
+        m_average = value;
+        m_timestamp = timestamp;
+        m_averageValid = true;
+
+        return value;
+    }
+
+    // First-order approximation of 1 - exp(-dt/tau), exact enough for dt well below tau
+    const float elapsed = (timestamp - m_timestamp) * 1e-6F;
+    const float alpha = elapsed / (m_settings.timeConstant + elapsed);
+
+    m_average += alpha * (value - m_average);
+    m_timestamp = timestamp;
+
+    return m_average;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,66 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+class Filter
+{
+public:
+    static constexpr size_t MaximumMedianLength = 7;
+    static constexpr float MaximumTimeConstant = 60.0F; // s
+
+    // A median length of 1 and a time constant of 0 pass samples through unchanged
+    struct Settings
+    {
+        uint8_t medianLength = 1;
+        float timeConstant = 0.0F; // s
+    };
+
+public:
+    void configure(const Settings& settings);
+    auto settings() const -> const Settings&;
+
+    void reset();
+
+    // Median is applied before the moving average to keep spikes out of it
+    auto update(float value, uint64_t timestamp) -> float;
+
+private:
+    auto median(float value) -> float;
+    auto average(float value, uint64_t timestamp) -> float;
+
+private:
+    Settings m_settings;
+
+    std::array<float, MaximumMedianLength> m_window = {};
+    uint8_t m_windowSize = 0;
+    uint8_t m_windowIndex = 0;
+
+    float m_average = 0.0F;
+    uint64_t m_timestamp = 0;
+    bool m_averageValid = false;
+};
@@ -0,0 +1,95 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "assert.h"
+#include "i2cbus.h"
+
+#include <array>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    // Generated by STM32CubeMX for 80 MHz PCLK1 with the analog filter enabled
+    constexpr std::array<uint32_t, I2cBus::SpeedCount> Timings = {
+        0x10909CEC,
+        0x00702991,
+        0x00300F38
+    };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+I2cBus::I2cBus(I2C_HandleTypeDef* i2c, Speed speed)
+    : m_i2c(i2c),
+      m_speed(speed)
+{
+    ASSERT(i2c != nullptr);
+    setSpeed(speed);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void I2cBus::setSpeed(Speed speed)
+{
+    const auto index = static_cast<size_t>(speed);
+    ASSERT(index < SpeedCount);
+
+    // Timing may only be changed while the peripheral is disabled
+    __HAL_I2C_DISABLE(m_i2c);
+
+    // Fast-mode Plus needs the stronger output drivers of the FM+ pins
+    if (speed == Speed::FastPlus)
+        HAL_I2CEx_EnableFastModePlus(I2C_FASTMODEPLUS_I2C1);
+    else
+        HAL_I2CEx_DisableFastModePlus(I2C_FASTMODEPLUS_I2C1);
+
+    m_i2c->Init.Timing = Timings[index];
+    m_i2c->Instance->TIMINGR = Timings[index];
+
+    __HAL_I2C_ENABLE(m_i2c);
+
+    m_speed = speed;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto I2cBus::speed() const -> Speed
+{
+    return m_speed;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto I2cBus::nameOf(Speed speed) -> const char*
+{
+    static constexpr std::array<const char*, SpeedCount> names = {
+        "STANDARD", "FAST", "FAST_PLUS"
+    };
+
+    const auto index = static_cast<size_t>(speed);
+    ASSERT(index < names.size());
+
+    return names[index];
+}
+
+// ---------------------------------------------------------------------------------------------- //
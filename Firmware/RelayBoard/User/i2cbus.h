@@ -0,0 +1,52 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "main.h"
+
+class I2cBus
+{
+public:
+    // High-speed mode (3.4 MHz) is not supported by the STM32L4 I2C peripheral
+    enum class Speed : uint8_t
+    {
+        Standard, // 100 kHz
+        Fast,     // 400 kHz
+        FastPlus  // 1 MHz
+    };
+
+    static constexpr size_t SpeedCount = 3;
+
+public:
+    I2cBus(I2C_HandleTypeDef* i2c, Speed speed);
+
+    void setSpeed(Speed speed);
+    auto speed() const -> Speed;
+
+    static auto nameOf(Speed speed) -> const char*;
+
+private:
+    I2C_HandleTypeDef* m_i2c;
+    Speed m_speed;
+};
@@ -22,6 +22,7 @@
 // ============================================================================================== //
 
 #include "ina226.h"
+#include "perfcounter.h"
 
 #include <array>
 
@@ -54,6 +55,10 @@ namespace Config {
     constexpr uint16_t ModeMask   = 0b0000000000000111;
 }
 
+namespace EnableMask {
+    constexpr uint16_t ConversionReadyFlag = 0b0000000000001000;
+}
+
 // ---------------------------------------------------------------------------------------------- //
 
 Ina226::Ina226(I2C_HandleTypeDef* i2c, Address address)
@@ -71,7 +76,7 @@ auto Ina226::address() const -> Address
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Ina226::setConfiguration(const Configuration& config)
+auto Ina226::setConfiguration(const Configuration& config) -> Result<>
 {
     // Default value, continuous shunt and bus conversion
     static constexpr uint16_t mode = 0b111 << Config::ModeOffset;
@@ -81,19 +86,29 @@ void Ina226::setConfiguration(const Configuration& config)
     const uint16_t shunt = indexOf(config.shuntVoltageConversionTime) << Config::VshCtOffset;
 
     const uint16_t value = count | bus | shunt | mode;
-    writeRegister(Register::Configuration, value);
 
-    writeRegister(Register::Calibration, config.calibrationValue);
+    if (auto result = writeRegister(Register::Configuration, value); !result)
+        return result;
+
+    return writeRegister(Register::Calibration, config.calibrationValue);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Ina226::getConfiguration() const -> Configuration
+auto Ina226::getConfiguration() const -> Result<Configuration>
 {
-    const uint16_t configuration = readRegister(Register::Configuration);
-    const uint16_t calibration = readRegister(Register::Calibration);
+    const auto configurationResult = readRegister(Register::Configuration);
+    if (!configurationResult)
+        return configurationResult.error();
+
+    const auto calibrationResult = readRegister(Register::Calibration);
+    if (!calibrationResult)
+        return calibrationResult.error();
+
+    const uint16_t configuration = configurationResult.value();
+    const uint16_t calibration = calibrationResult.value();
 
-    return {
+    return Configuration {
         static_cast<AverageCount>((configuration & Config::AvgMask) >> Config::AvgOffset),
         static_cast<ConversionTime>((configuration & Config::VbusCtMask) >> Config::VbusCtOffset),
         static_cast<ConversionTime>((configuration & Config::VshCtMask) >> Config::VshCtOffset),
@@ -103,40 +118,65 @@ auto Ina226::getConfiguration() const -> Configuration
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Ina226::getShuntVoltage() const -> int16_t
+auto Ina226::getShuntVoltage() const -> Result<int16_t>
+{
+    const auto result = readRegister(Register::ShuntVoltage);
+    if (!result)
+        return result.error();
+
+    return static_cast<int16_t>(result.value());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226::getBusVoltage() const -> Result<int16_t>
 {
-    const uint16_t value = readRegister(Register::ShuntVoltage);
-    return reinterpret_cast<const int16_t&>(value);
+    const auto result = readRegister(Register::BusVoltage);
+    if (!result)
+        return result.error();
+
+    return static_cast<int16_t>(result.value());
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Ina226::getBusVoltage() const -> int16_t
+auto Ina226::getPower() const -> Result<int16_t>
 {
-    const uint16_t value = readRegister(Register::BusVoltage);
-    return reinterpret_cast<const int16_t&>(value);
+    const auto result = readRegister(Register::Power);
+    if (!result)
+        return result.error();
+
+    return static_cast<int16_t>(result.value());
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Ina226::getPower() const -> int16_t
+auto Ina226::getCurrent() const -> Result<int16_t>
 {
-    const uint16_t value = readRegister(Register::Power);
-    return reinterpret_cast<const int16_t&>(value);
+    const auto result = readRegister(Register::Current);
+    if (!result)
+        return result.error();
+
+    return static_cast<int16_t>(result.value());
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Ina226::getCurrent() const -> int16_t
+auto Ina226::isConversionReady() const -> Result<bool>
 {
-    const uint16_t value = readRegister(Register::Current);
-    return reinterpret_cast<const int16_t&>(value);
+    const auto result = readRegister(Register::EnableMask);
+    if (!result)
+        return result.error();
+
+    return (result.value() & EnableMask::ConversionReadyFlag) != 0;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Ina226::writeRegister(uint8_t reg, uint16_t value)
+auto Ina226::writeRegister(uint8_t reg, uint16_t value) -> Result<>
 {
+    PerfScope scope(PerfCounter::Id::I2cTransfer);
+
     const auto address = static_cast<uint16_t>(m_address);
 
     std::array<uint8_t, 2> data = { static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value) };
@@ -144,13 +184,17 @@ void Ina226::writeRegister(uint8_t reg, uint16_t value)
     HAL_StatusTypeDef status = HAL_I2C_Mem_Write(m_i2c, address, reg, I2C_MEMADD_SIZE_8BIT,
                                                  data.data(), data.size(), Timeout);
     if (status != HAL_OK)
-        throw WriteError();
+        return WriteError;
+
+    return {};
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Ina226::readRegister(uint8_t reg) const -> uint16_t
+auto Ina226::readRegister(uint8_t reg) const -> Result<uint16_t>
 {
+    PerfScope scope(PerfCounter::Id::I2cTransfer);
+
     const auto address = static_cast<uint16_t>(m_address);
 
     std::array<uint8_t, 2> data;
@@ -158,9 +202,9 @@ auto Ina226::readRegister(uint8_t reg) const -> uint16_t
     HAL_StatusTypeDef status = HAL_I2C_Mem_Read(m_i2c, address, reg, I2C_MEMADD_SIZE_8BIT,
                                                 data.data(), data.size(), Timeout);
     if (status != HAL_OK)
-        throw ReadError();
+        return ReadError;
 
-    return (data[0] << 8) | data[1];
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
 }
 
 // ---------------------------------------------------------------------------------------------- //
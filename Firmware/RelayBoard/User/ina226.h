@@ -24,8 +24,7 @@
 #pragma once
 
 #include "main.h"
-
-#include <exception>
+#include "result.h"
 
 class Ina226
 {
@@ -99,34 +98,35 @@ public:
     static constexpr float ShuntVoltageLsb = 2.5e-6F;
     static constexpr float BusVoltageLsb = 1.25e-3F;
 
-    class WriteError : public std::exception
-    {
-    public:
-        auto what() const noexcept -> const char* { return "INA226_WRITE_ERROR"; }
-    };
+    // Power LSB is fixed at 25 times the current LSB chosen for calibration
+    static constexpr float PowerLsbFactor = 25.0F;
 
-    class ReadError : public std::exception
-    {
-    public:
-        auto what() const noexcept -> const char* { return "INA226_READ_ERROR"; }
-    };
+    static constexpr auto computeCalibrationValue(float currentLsb, float shuntResistance) {
+        return static_cast<int16_t>(0.00512F / (currentLsb * shuntResistance));
+    }
+
+    static constexpr Error WriteError = Error("INA226_WRITE_ERROR");
+    static constexpr Error ReadError = Error("INA226_READ_ERROR");
 
 public:
     Ina226(I2C_HandleTypeDef* i2c, Address address);
 
     auto address() const -> Address;
 
-    void setConfiguration(const Configuration& config);
-    auto getConfiguration() const -> Configuration;
+    auto setConfiguration(const Configuration& config) -> Result<>;
+    auto getConfiguration() const -> Result<Configuration>;
+
+    auto getShuntVoltage() const -> Result<int16_t>;
+    auto getBusVoltage() const -> Result<int16_t>;
+    auto getPower() const -> Result<int16_t>;
+    auto getCurrent() const -> Result<int16_t>;
 
-    auto getShuntVoltage() const -> int16_t;
-    auto getBusVoltage() const -> int16_t;
-    auto getPower() const -> int16_t;
-    auto getCurrent() const -> int16_t;
+    // Set once both conversions have completed, cleared by reading it
+    auto isConversionReady() const -> Result<bool>;
 
 private:
-    void writeRegister(uint8_t reg, uint16_t value);
-    auto readRegister(uint8_t reg) const -> uint16_t;
+    auto writeRegister(uint8_t reg, uint16_t value) -> Result<>;
+    auto readRegister(uint8_t reg) const -> Result<uint16_t>;
 
 private:
     I2C_HandleTypeDef* m_i2c;
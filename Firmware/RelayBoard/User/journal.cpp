@@ -0,0 +1,87 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "assert.h"
+#include "deviceclock.h"
+#include "journal.h"
+
+#include <array>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    std::array<Journal::Entry, Journal::EntryCount> g_entries;
+    uint32_t g_nextSequence = 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Journal::add(Event event, uint8_t channel, float value1, float value2)
+{
+    g_entries[g_nextSequence % EntryCount] = {
+        DeviceClock::now(), g_nextSequence, value1, value2, event, channel
+    };
+
+    ++g_nextSequence;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Journal::firstSequence() -> uint32_t
+{
+    return (g_nextSequence > EntryCount) ? g_nextSequence - EntryCount : 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Journal::nextSequence() -> uint32_t
+{
+    return g_nextSequence;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Journal::entry(uint32_t sequence) -> const Entry&
+{
+    ASSERT(sequence >= firstSequence() && sequence < nextSequence());
+    return g_entries[sequence % EntryCount];
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Journal::nameOf(Event event) -> const char*
+{
+    static constexpr std::array<const char*, 19> names = {
+        "BOOT", "RELAY_ON", "RELAY_OFF", "FAULT", "I2C_ERROR", "LIMIT_CHANGE", "LIMITS_SAVED",
+        "RESET", "TIMESTAMPS", "CAPTURE_ARMED", "CAPTURE_DISARMED", "CAPTURE_TRIGGERED",
+        "PROFILE_STORED", "PROFILE_LOADED", "BUS_SPEED",
+        "CHARACTERIZED", "RECLOSE", "LOCKOUT", "FAULT_CLEARED"
+    };
+
+    const auto index = static_cast<size_t>(event);
+    ASSERT(index < names.size());
+
+    return names[index];
+}
+
+// ---------------------------------------------------------------------------------------------- //
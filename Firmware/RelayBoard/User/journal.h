@@ -0,0 +1,79 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class Journal
+{
+public:
+    static constexpr size_t EntryCount = 128;
+    static constexpr uint8_t NoChannel = 0xff;
+
+    enum class Event : uint8_t
+    {
+        Boot,
+        RelayOn,
+        RelayOff,
+        Fault,
+        I2cError,
+        LimitChange,
+        LimitsSaved,
+        Reset,
+        Timestamps,
+        CaptureArmed,
+        CaptureDisarmed,
+        CaptureTriggered,
+        ProfileStored,
+        ProfileLoaded,
+        BusSpeed,
+        Characterized,
+        Reclose,
+        Lockout,
+        FaultCleared
+    };
+
+    struct Entry
+    {
+        uint64_t timestamp;
+        uint32_t sequence;
+        float value1;
+        float value2;
+        Event event;
+        uint8_t channel;
+    };
+
+public:
+    static void add(Event event, uint8_t channel = NoChannel, float value1 = 0.0F,
+                    float value2 = 0.0F);
+
+    // Sequence numbers increase monotonically, older entries are overwritten
+    static auto firstSequence() -> uint32_t;
+    static auto nextSequence() -> uint32_t;
+
+    static auto entry(uint32_t sequence) -> const Entry&;
+
+    static auto nameOf(Event event) -> const char*;
+};
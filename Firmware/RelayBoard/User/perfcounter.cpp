@@ -0,0 +1,127 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "assert.h"
+#include "perfcounter.h"
+
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    std::array<PerfCounter, PerfCounter::CounterCount> g_counters;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void PerfCounter::add(uint32_t cycles)
+{
+    ++m_count;
+    m_sum += cycles;
+
+    m_min = std::min(m_min, cycles);
+    m_max = std::max(m_max, cycles);
+
+    const int bit = 31 - __builtin_clz(cycles | 1);
+    const size_t index = std::clamp<int>(bit - FirstBinBits + 1, 0, BinCount - 1);
+
+    if (m_bins[index] < UINT16_MAX)
+        ++m_bins[index];
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void PerfCounter::reset()
+{
+    *this = PerfCounter();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PerfCounter::count() const -> uint32_t
+{
+    return m_count;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PerfCounter::min() const -> uint32_t
+{
+    return (m_count > 0) ? m_min : 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PerfCounter::max() const -> uint32_t
+{
+    return m_max;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PerfCounter::mean() const -> uint32_t
+{
+    return (m_count > 0) ? static_cast<uint32_t>(m_sum / m_count) : 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PerfCounter::bin(size_t index) const -> uint16_t
+{
+    ASSERT(index < BinCount);
+    return m_bins[index];
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PerfCounter::get(Id id) -> PerfCounter&
+{
+    const auto index = static_cast<size_t>(id);
+    ASSERT(index < CounterCount);
+
+    return g_counters[index];
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PerfCounter::nameOf(Id id) -> const char*
+{
+    static constexpr std::array<const char*, CounterCount> names = {
+        "MAIN_LOOP", "RELAY_UPDATE", "I2C_TRANSFER", "HOST_UPDATE", "COMMAND", "SEND_DATA"
+    };
+
+    const auto index = static_cast<size_t>(id);
+    ASSERT(index < CounterCount);
+
+    return names[index];
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void PerfCounter::resetAll()
+{
+    for (auto& counter : g_counters)
+        counter.reset();
+}
+
+// ---------------------------------------------------------------------------------------------- //
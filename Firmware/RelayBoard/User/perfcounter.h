@@ -0,0 +1,91 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "main.h"
+
+#include <array>
+
+class PerfCounter
+{
+public:
+    enum class Id
+    {
+        MainLoop,
+        RelayUpdate,
+        I2cTransfer,
+        HostUpdate,
+        Command,
+        SendData
+    };
+
+    static constexpr size_t CounterCount = 6;
+
+    // Bin 0 holds durations below 512 cycles, each further bin covers twice the range
+    // of the previous one, the last bin everything from 2^19 cycles (6.5 ms) upwards
+    static constexpr size_t BinCount = 12;
+    static constexpr uint32_t FirstBinBits = 9;
+
+public:
+    void add(uint32_t cycles);
+    void reset();
+
+    auto count() const -> uint32_t;
+    auto min() const -> uint32_t;
+    auto max() const -> uint32_t;
+    auto mean() const -> uint32_t;
+    auto bin(size_t index) const -> uint16_t;
+
+    static auto get(Id id) -> PerfCounter&;
+    static auto nameOf(Id id) -> const char*;
+
+    static void resetAll();
+
+private:
+    uint32_t m_count = 0;
+    uint32_t m_min = UINT32_MAX;
+    uint32_t m_max = 0;
+    uint64_t m_sum = 0;
+
+    std::array<uint16_t, BinCount> m_bins = {};
+};
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Adds the cycles spent between construction and destruction to a counter
+class PerfScope
+{
+public:
+    PerfScope(PerfCounter::Id id)
+        : m_counter(PerfCounter::get(id)),
+          m_start(DWT->CYCCNT) {}
+
+    ~PerfScope() { m_counter.add(DWT->CYCCNT - m_start); }
+
+private:
+    PerfCounter& m_counter;
+    uint32_t m_start;
+};
+
+// ---------------------------------------------------------------------------------------------- //
@@ -21,6 +21,7 @@
 //                                                                                                //
 // ============================================================================================== //
 
+#include "assert.h"
 #include "config.h"
 #include "powermonitor.h"
 
@@ -31,22 +32,97 @@ PowerMonitor::PowerMonitor(I2C_HandleTypeDef* i2c, Ina226::Address address)
 {
     Ina226::Configuration config = {};
     config.averageCount = Ina226::AverageCount::X4;
+    config.calibrationValue = Ina226::computeCalibrationValue(Config::CurrentLsb,
+                                                              Config::ShuntResistance);
 
-    m_chip.setConfiguration(config);
+    // A chip that cannot be configured at power-up is a hardware fault
+    const bool configured = static_cast<bool>(m_chip.setConfiguration(config));
+    ASSERT(configured);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto PowerMonitor::getVoltage() const -> float
+auto PowerMonitor::getVoltage() const -> Result<float>
 {
-    return m_chip.getBusVoltage() * Ina226::BusVoltageLsb;
+    const auto voltage = m_chip.getBusVoltage();
+    if (!voltage)
+        return voltage.error();
+
+    return voltage.value() * Ina226::BusVoltageLsb;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PowerMonitor::getCurrent() const -> Result<float>
+{
+    const auto voltage = m_chip.getShuntVoltage();
+    if (!voltage)
+        return voltage.error();
+
+    return voltage.value() * Ina226::ShuntVoltageLsb / Config::ShuntResistance;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PowerMonitor::getPower() const -> Result<float>
+{
+    const auto result = m_chip.getPower();
+    if (!result)
+        return result.error();
+
+    // Register is unsigned, computed by the chip from the same conversion as bus and current
+    const auto power = static_cast<uint16_t>(result.value());
+    return power * Ina226::PowerLsbFactor * Config::CurrentLsb;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PowerMonitor::setSamplingRate(SamplingRate rate) -> Result<>
+{
+    const auto result = m_chip.getConfiguration();
+    if (!result)
+        return result.error();
+
+    // Trades noise for a conversion time matching the interleaved capture rate
+    Ina226::Configuration config = result.value();
+
+    Ina226::ConversionTime time = Ina226::ConversionTime::_1100us;
+
+    if (rate == SamplingRate::Fast)
+        time = Ina226::ConversionTime::_332us;
+    else if (rate == SamplingRate::Fastest)
+        time = Ina226::ConversionTime::_140us;
+
+    config.averageCount = (rate == SamplingRate::Normal) ? Ina226::AverageCount::X4
+                                                         : Ina226::AverageCount::X1;
+    config.busVoltageConversionTime = time;
+    config.shuntVoltageConversionTime = time;
+
+    if (auto result = m_chip.setConfiguration(config); !result)
+        return result;
+
+    m_samplingRate = rate;
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PowerMonitor::getConversionTime() const -> uint32_t
+{
+    if (m_samplingRate == SamplingRate::Fast)
+        return 2 * 332;
+
+    if (m_samplingRate == SamplingRate::Fastest)
+        return 2 * 140;
+
+    return 4 * 2 * 1100;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto PowerMonitor::getCurrent() const -> float
+auto PowerMonitor::isConversionReady() const -> Result<bool>
 {
-    return m_chip.getShuntVoltage() * Ina226::ShuntVoltageLsb / Config::ShuntResistance;
+    return m_chip.isConversionReady();
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -27,12 +27,28 @@
 
 class PowerMonitor
 {
+public:
+    enum class SamplingRate
+    {
+        Normal,  // 1.1 ms, 4 averages
+        Fast,    // 332 us, no averaging
+        Fastest  // 140 us, no averaging
+    };
+
 public:
     PowerMonitor(I2C_HandleTypeDef* i2c, Ina226::Address address);
 
-    auto getVoltage() const -> float;
-    auto getCurrent() const -> float;
+    auto getVoltage() const -> Result<float>;
+    auto getCurrent() const -> Result<float>;
+    auto getPower() const -> Result<float>;
+
+    auto setSamplingRate(SamplingRate rate) -> Result<>;
+
+    // Time in us for one bus and shunt conversion pair including averaging
+    auto getConversionTime() const -> uint32_t;
+    auto isConversionReady() const -> Result<bool>;
 
 private:
     Ina226 m_chip;
+    SamplingRate m_samplingRate = SamplingRate::Normal;
 };
@@ -0,0 +1 @@
+../../Common/protocol.h
\ No newline at end of file
@@ -0,0 +1,148 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "assert.h"
+#include "recloser.h"
+
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Recloser::configure(const Policy& policy)
+{
+    ASSERT(policy.retryCount <= MaximumRetryCount);
+    ASSERT(policy.delay >= MinimumDelay && policy.delay <= MaximumDelay);
+
+    m_policy = policy;
+    reset();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Recloser::policy() const -> const Policy&
+{
+    return m_policy;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Recloser::reset()
+{
+    m_tripCount = 0;
+    m_retryIndex = 0;
+    m_lockedOut = false;
+    m_exhausted = false;
+    m_pending = false;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Recloser::onTrip(uint64_t timestamp) -> bool
+{
+    m_pending = false;
+
+    if (m_tripCount < UINT16_MAX)
+        ++m_tripCount;
+
+    if (m_policy.lockoutCount > 0 && m_tripCount >= m_policy.lockoutCount)
+        m_lockedOut = true;
+
+    if (m_retryIndex > 0 && timestamp - m_recloseTime >= RecoveryTime)
+        m_retryIndex = 0;
+
+    if (m_lockedOut)
+        return false;
+
+    m_exhausted = m_retryIndex >= m_policy.retryCount;
+
+    if (m_exhausted)
+        return false;
+
+    const uint64_t delay = std::min(static_cast<uint64_t>(m_policy.delay) << m_retryIndex,
+                                    static_cast<uint64_t>(MaximumDelay));
+
+    m_dueTime = timestamp + delay * 1000;
+    m_pending = true;
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Recloser::onReclose(uint64_t timestamp)
+{
+    m_pending = false;
+    m_recloseTime = timestamp;
+    ++m_retryIndex;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Recloser::cancel()
+{
+    m_pending = false;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Recloser::isDue(uint64_t timestamp) const -> bool
+{
+    return m_pending && timestamp >= m_dueTime;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Recloser::isPending() const -> bool
+{
+    return m_pending;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Recloser::isLockedOut() const -> bool
+{
+    return m_lockedOut;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Recloser::isExhausted() const -> bool
+{
+    return m_exhausted;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Recloser::tripCount() const -> uint16_t
+{
+    return m_tripCount;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Recloser::retryIndex() const -> uint8_t
+{
+    return m_retryIndex;
+}
+
+// ---------------------------------------------------------------------------------------------- //
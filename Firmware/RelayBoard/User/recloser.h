@@ -0,0 +1,83 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Tracks trips of one channel and decides when a tripped relay may be switched on again
+class Recloser
+{
+public:
+    static constexpr uint8_t MaximumRetryCount = 10;
+    static constexpr uint32_t MinimumDelay = 1;      // ms
+    static constexpr uint32_t MaximumDelay = 60000;  // ms
+
+    // A reclosed relay that holds for this long starts over with the first retry
+    static constexpr uint32_t RecoveryTime = 1000000; // us
+
+    // Retry count 0 disables reclosing, lockout count 0 disables the lockout. Each retry
+    // waits twice as long as the previous one, starting with the given delay.
+    struct Policy
+    {
+        uint8_t retryCount = 0;
+        uint32_t delay = 100; // ms
+        uint8_t lockoutCount = 0;
+    };
+
+public:
+    void configure(const Policy& policy);
+    auto policy() const -> const Policy&;
+
+    void reset();
+
+    // Returns true if a reclose has been scheduled
+    auto onTrip(uint64_t timestamp) -> bool;
+    void onReclose(uint64_t timestamp);
+
+    // Drops a scheduled reclose, counters are kept
+    void cancel();
+
+    auto isDue(uint64_t timestamp) const -> bool;
+    auto isPending() const -> bool;
+    auto isLockedOut() const -> bool;
+
+    // True if the last trip left no retry, until the counters are reset
+    auto isExhausted() const -> bool;
+
+    auto tripCount() const -> uint16_t;
+    auto retryIndex() const -> uint8_t;
+
+private:
+    Policy m_policy;
+
+    uint16_t m_tripCount = 0;
+    uint8_t m_retryIndex = 0;
+    bool m_lockedOut = false;
+    bool m_exhausted = false;
+
+    bool m_pending = false;
+    uint64_t m_dueTime = 0;
+    uint64_t m_recloseTime = 0;
+};
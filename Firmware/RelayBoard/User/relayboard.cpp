@@ -22,36 +22,56 @@
 // ============================================================================================== //
 
 #include "config.h"
+#include "deviceclock.h"
+#include "journal.h"
 #include "main.h"
+#include "perfcounter.h"
 #include "relayboard.h"
 #include "timestamp.h"
 
 #include "usbd_desc.h"
 
+#include <algorithm>
+
 // ---------------------------------------------------------------------------------------------- //
 
 namespace {
-    constexpr char TokenSeparator = ' ';
+    using Protocol::Command;
+
+    constexpr char TokenSeparator = Protocol::TokenSeparator;
 
     constexpr uint32_t BootloaderMagic = 0xdeadbeef;
     volatile uint32_t g_bootloaderMagic __attribute__((section(".bootflags")));
-}
 
-// ---------------------------------------------------------------------------------------------- //
+    // newlib-nano's printf does not support 64-bit integers
+    auto toString(uint64_t value) -> String
+    {
+        std::array<char, 21> buffer;
 
-class MissingArgumentError : public std::exception
-{
-public:
-    auto what() const noexcept -> const char* { return "MISSING_ARGUMENT"; }
-};
+        char* digit = buffer.end();
+        *--digit = '\0';
+
+        do {
+            *--digit = '0' + (value % 10);
+            value /= 10;
+        }
+        while (value != 0);
+
+        return digit;
+    }
+}
 
 // ---------------------------------------------------------------------------------------------- //
 
-class InvalidArgumentError : public std::exception
-{
-public:
-    auto what() const noexcept -> const char* { return "INVALID_ARGUMENT"; }
-};
+namespace {
+    constexpr Error MissingArgumentError = Error("MISSING_ARGUMENT");
+    constexpr Error InvalidArgumentError = Error("INVALID_ARGUMENT");
+    constexpr Error UnknownCommandError = Error("UNKNOWN_COMMAND");
+    constexpr Error DataOverflowError = Error("DATA_OVERFLOW");
+    constexpr Error CaptureIncompleteError = Error("CAPTURE_INCOMPLETE");
+    constexpr Error ProfileEmptyError = Error("PROFILE_EMPTY");
+    constexpr Error NotCharacterizedError = Error("NOT_CHARACTERIZED");
+}
 
 // ---------------------------------------------------------------------------------------------- //
 
@@ -59,6 +79,13 @@ RelayBoard::RelayBoard()
     : m_hostInterface(this),
       m_relayManager(this)
 {
+    for (size_t i = 0; i < RelayManager::RelayCount; ++i)
+    {
+        m_profileBuffer.voltageLimits[i] = m_relayManager.getVoltageLimit(i);
+        m_profileBuffer.currentLimits[i] = m_relayManager.getCurrentLimit(i);
+    }
+
+    Journal::add(Journal::Event::Boot);
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -67,67 +94,242 @@ void RelayBoard::exec()
 {
     HAL_GPIO_WritePin(STATUS_GPIO_Port, STATUS_Pin, GPIO_PIN_SET);
 
+    m_loopStart = DWT->CYCCNT;
+
     while (true)
+        update();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBoard::update()
+{
+    // A response sent while a relay is being characterized stalls its sampling, which the
+    // resolution of the switch timing reports, but the host is never left waiting for it
     {
+        PerfScope scope(PerfCounter::Id::HostUpdate);
         m_hostInterface.update();
+    }
+
+    {
+        PerfScope scope(PerfCounter::Id::RelayUpdate);
         m_relayManager.update();
     }
+
+    const uint32_t loopEnd = DWT->CYCCNT;
+    PerfCounter::get(PerfCounter::Id::MainLoop).add(loopEnd - m_loopStart);
+    m_loopStart = loopEnd;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBoard::onHostDataReceived(const String& data)
 {
+    PerfScope scope(PerfCounter::Id::Command);
+    m_requestTime = DeviceClock::now();
+
     const size_t tokenCount = data.countTokens(TokenSeparator);
 
     if (tokenCount < 1)
         return;
 
-    const String tag = data.getToken(TokenSeparator, 0);
+    // Looked up in place, the tag is never copied out of the receive buffer
+    const auto tag = Protocol::tagOf({ data.data(), data.size() });
+    const Protocol::CommandInfo* command = Protocol::find(tag);
+
+    Result<> result;
 
-    if (tag == "<GET_FAULT_MASK>")
+    if (!command || !(command->modes & Protocol::FirmwareMode))
+        result = UnknownCommandError;
+    else if (tokenCount - 1 < command->minArguments)
+        result = MissingArgumentError;
+    else if (tokenCount - 1 > command->maxArguments)
+        result = InvalidArgumentError;
+    else
+        result = dispatch(command->command, data, tokenCount);
+
+    if (!result)
+        sendError(result.error());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+// Argument counts have been checked against the command table
+auto RelayBoard::dispatch(Command command, const String& data, size_t tokenCount) -> Result<>
+{
+    switch (command)
+    {
+    case Command::GetFaultMask:
         protocolGetFaultMask();
-    else if (tag == "<SET_RELAY_STATE>")
-        protocolSetRelayState(data, tokenCount);
-    else if (tag == "<GET_RELAY_STATE>")
-        protocolGetRelayState(data, tokenCount);
-    else if (tag == "<SET_STATE_MASK>")
-        protocolSetStateMask(data, tokenCount);
-    else if (tag == "<GET_STATE_MASK>")
+        return {};
+
+    case Command::SetRelayState:
+        return protocolSetRelayState(data);
+
+    case Command::GetRelayState:
+        return protocolGetRelayState(data);
+
+    case Command::SetStateMask:
+        return protocolSetStateMask(data);
+
+    case Command::GetStateMask:
         protocolGetStateMask();
-    else if (tag == "<GET_RELAY_POWER>")
-        protocolGetRelayPower(data, tokenCount);
-    else if (tag == "<SET_POWER_LIMIT>")
-        protocolSetPowerLimit(data, tokenCount);
-    else if (tag == "<GET_POWER_LIMIT>")
-        protocolGetPowerLimit(data, tokenCount);
-    else if (tag == "<SAVE_POWER_LIMITS>")
-        protocolSavePowerLimits();
-    else if (tag == "<RESET>")
+        return {};
+
+    case Command::GetRelayPower:
+        return protocolGetRelayPower(data);
+
+    case Command::GetRelayWattage:
+        return protocolGetRelayWattage(data);
+
+    case Command::GetEnergyCounters:
+        protocolGetEnergyCounters();
+        return {};
+
+    case Command::ResetEnergyCounters:
+        return protocolResetEnergyCounters(data, tokenCount);
+
+    case Command::ArmCapture:
+        return protocolArmCapture(data);
+
+    case Command::DisarmCapture:
+        return protocolDisarmCapture();
+
+    case Command::GetCaptureStatus:
+        protocolGetCaptureStatus();
+        return {};
+
+    case Command::ReadCapture:
+        return protocolReadCapture();
+
+    case Command::CharacterizeRelay:
+        return protocolCharacterizeRelay(data);
+
+    case Command::GetCharacterizationStatus:
+        protocolGetCharacterizationStatus();
+        return {};
+
+    case Command::GetSwitchTiming:
+        return protocolGetSwitchTiming(data);
+
+    case Command::ClearFault:
+        return protocolClearFault(data);
+
+    case Command::SetReclosePolicy:
+        return protocolSetReclosePolicy(data);
+
+    case Command::GetReclosePolicy:
+        return protocolGetReclosePolicy(data);
+
+    case Command::GetRecloseStatus:
+        return protocolGetRecloseStatus(data);
+
+    case Command::SetPowerLimit:
+        return protocolSetPowerLimit(data);
+
+    case Command::GetPowerLimit:
+        return protocolGetPowerLimit(data);
+
+    case Command::SavePowerLimits:
+        return protocolSavePowerLimits();
+
+    case Command::SetBusSpeed:
+        return protocolSetBusSpeed(data);
+
+    case Command::GetBusSpeed:
+        protocolGetBusSpeed();
+        return {};
+
+    case Command::SetFilter:
+        return protocolSetFilter(data);
+
+    case Command::GetFilter:
+        return protocolGetFilter(data);
+
+    case Command::SetProfileLimit:
+        return protocolSetProfileLimit(data);
+
+    case Command::StoreProfile:
+        return protocolStoreProfile(data);
+
+    case Command::GetProfiles:
+        protocolGetProfiles();
+        return {};
+
+    case Command::GetProfileLimits:
+        return protocolGetProfileLimits(data);
+
+    case Command::LoadProfile:
+        return protocolLoadProfile(data);
+
+    case Command::GetJournalStatus:
+        protocolGetJournalStatus();
+        return {};
+
+    case Command::ReadJournal:
+        return protocolReadJournal(data);
+
+    case Command::GetPerfCounters:
+        protocolGetPerfCounters();
+        return {};
+
+    case Command::GetPerfHistograms:
+        protocolGetPerfHistograms();
+        return {};
+
+    case Command::ResetPerfCounters:
+        protocolResetPerfCounters();
+        return {};
+
+    case Command::GetDeviceTime:
+        protocolGetDeviceTime();
+        return {};
+
+    case Command::SetTimestamps:
+        return protocolSetTimestamps(data);
+
+    case Command::Reset:
         protocolReset();
-    else if (tag == "<GET_BOOT_MODE>")
+        return {};
+
+    case Command::GetBootMode:
         protocolGetBootMode();
-    else if (tag == "<GET_BOARD_NAME>")
+        return {};
+
+    case Command::GetBoardName:
         protocolGetBoardName();
-    else if (tag == "<GET_HARDWARE_VERSION>")
+        return {};
+
+    case Command::GetHardwareVersion:
         protocolGetHardwareVersion();
-    else if (tag == "<GET_FIRMWARE_VERSION>")
+        return {};
+
+    case Command::GetFirmwareVersion:
         protocolGetFirmwareVersion();
-    else if (tag == "<GET_SERIAL_NUMBER>")
+        return {};
+
+    case Command::GetSerialNumber:
         protocolGetSerialNumber();
-    else if (tag == "<GET_BUILD_TIMESTAMP>")
+        return {};
+
+    case Command::GetBuildTimestamp:
         protocolGetBuildTimestamp();
-    else if (tag == "<LAUNCH_BOOTLOADER>")
+        return {};
+
+    case Command::LaunchBootloader:
         protocolLaunchBootloader();
-    else
-        sendError("UNKNOWN_COMMAND");
+        return {};
+
+    default:
+        return UnknownCommandError;
+    }
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBoard::onHostDataOverflow()
 {
-    sendError("DATA_OVERFLOW");
+    sendError(DataOverflowError);
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -139,156 +341,793 @@ void RelayBoard::onRelayFault()
 
 // ---------------------------------------------------------------------------------------------- //
 
+void RelayBoard::onRelayFaultsCleared()
+{
+    HAL_GPIO_WritePin(STATUS_GPIO_Port, STATUS_Pin, GPIO_PIN_SET);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void RelayBoard::protocolGetFaultMask()
 {
-    sendResponse(String::format("<FAULT_MASK> 0x%04x", m_relayManager.getFaultMask()));
+    sendResponse(Command::GetFaultMask, String::format("0x%04x", m_relayManager.getFaultMask()));
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayBoard::protocolSetRelayState(const String& data, size_t tokenCount)
+auto RelayBoard::protocolSetRelayState(const String& data) -> Result<>
 {
-    try {
-        checkTokenCount(tokenCount, 3);
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
 
-        const uint8_t index = toIndex(data.getToken(TokenSeparator, 1));
-        const RelayState state = toRelayState(data.getToken(TokenSeparator, 2));
+    const auto state = toRelayState(data.getToken(TokenSeparator, 2));
+    if (!state)
+        return state.error();
 
-        m_relayManager.setState(index, state);
-        sendResponse("<OK>");
-    }
-    catch (const std::exception& e) {
-        sendError(e.what());
-    }
+    m_relayManager.setState(index.value(), state.value());
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolGetRelayState(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    const RelayState state = m_relayManager.getState(index.value());
+    sendResponse(Command::GetRelayState, (state == RelayState::On) ? "ON" : "OFF");
+
+    return {};
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayBoard::protocolGetRelayState(const String& data, size_t tokenCount)
+auto RelayBoard::protocolSetStateMask(const String& data) -> Result<>
 {
-    try {
-        checkTokenCount(tokenCount, 2);
+    const auto mask = data.getToken(TokenSeparator, 1).toULong();
+
+    if (!mask || mask.value() > 0xffff)
+        return InvalidArgumentError;
+
+    m_relayManager.setStateMask(mask.value());
+    sendResponse("<OK>");
+
+    return {};
+}
 
-        const uint8_t index = toIndex(data.getToken(TokenSeparator, 1));
-        const RelayState state = m_relayManager.getState(index);
+// ---------------------------------------------------------------------------------------------- //
 
-        sendResponse("<RELAY_STATE>", (state == RelayState::On) ? "ON" : "OFF");
+void RelayBoard::protocolGetStateMask()
+{
+    sendResponse(Command::GetStateMask, String::format("0x%04x", m_relayManager.getStateMask()));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolGetRelayPower(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    const float voltage = m_relayManager.getVoltage(index.value());
+    const float current = m_relayManager.getCurrent(index.value());
+
+    sendResponse(Command::GetRelayPower, String::format("%.2f,%.3f", voltage, current));
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolGetRelayWattage(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    const float power = m_relayManager.getPower(index.value());
+    sendResponse(Command::GetRelayWattage, String::format("%.3f", power));
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBoard::protocolGetEnergyCounters()
+{
+    for (size_t i = 0; i < RelayManager::RelayCount; ++i)
+    {
+        const Accumulator& accumulator = m_relayManager.getAccumulator(i);
+
+        sendResponse(Command::GetEnergyCounters,
+                     String::format("%d %.6f,%.6f,%.3f",
+                                    static_cast<int>(i),
+                                    accumulator.charge(),
+                                    accumulator.energy(),
+                                    accumulator.duration()));
+    }
+
+    sendResponse("<OK>");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolResetEnergyCounters(const String& data, size_t tokenCount) -> Result<>
+{
+    if (tokenCount > 1)
+    {
+        const auto index = toIndex(data.getToken(TokenSeparator, 1));
+        if (!index)
+            return index.error();
+
+        m_relayManager.resetAccumulator(index.value());
     }
-    catch (const std::exception& e) {
-        sendError(e.what());
+    else
+    {
+        for (size_t i = 0; i < RelayManager::RelayCount; ++i)
+            m_relayManager.resetAccumulator(i);
     }
+
+    sendResponse("<OK>");
+
+    return {};
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayBoard::protocolSetStateMask(const String& data, size_t tokenCount)
+auto RelayBoard::protocolArmCapture(const String& data) -> Result<>
 {
-    try {
-        checkTokenCount(tokenCount, 2);
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
 
-        const auto mask = data.getToken(TokenSeparator, 1).toULong();
+    const String arguments = data.getToken(TokenSeparator, 2);
+    const size_t argumentCount = arguments.countTokens(',');
 
-        if (mask > 0xffff)
-            throw InvalidArgumentError();
+    const auto mask = arguments.getToken(',', 0).toULong();
 
-        m_relayManager.setStateMask(mask);
-        sendResponse("<OK>");
-    }
-    catch (const std::exception& e) {
-        sendError(e.what());
+    if (!mask || mask.value() == 0 || mask.value() > Capture::AllTriggers)
+        return InvalidArgumentError;
+
+    float threshold = 0.0F;
+
+    if (mask.value() & Capture::ThresholdTrigger)
+    {
+        if (auto result = checkTokenCount(argumentCount, 2); !result)
+            return result;
+
+        const auto value = arguments.getToken(',', 1).toFloat();
+
+        if (!value || value.value() <= 0.0F)
+            return InvalidArgumentError;
+
+        threshold = value.value();
     }
+
+    if (auto result = m_relayManager.armCapture(index.value(), mask.value(), threshold); !result)
+        return result;
+
+    Journal::add(Journal::Event::CaptureArmed, index.value(), mask.value(), threshold);
+    sendResponse("<OK>");
+
+    return {};
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayBoard::protocolGetStateMask()
+auto RelayBoard::protocolDisarmCapture() -> Result<>
+{
+    if (auto result = m_relayManager.disarmCapture(); !result)
+        return result;
+
+    Journal::add(Journal::Event::CaptureDisarmed);
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBoard::protocolGetCaptureStatus()
 {
-    sendResponse(String::format("<STATE_MASK> 0x%04x", m_relayManager.getStateMask()));
+    static constexpr std::array<const char*, 4> states = {
+        "IDLE", "ARMED", "TRIGGERED", "COMPLETE"
+    };
+
+    const Capture& capture = m_relayManager.getCapture();
+
+    sendResponse(Command::GetCaptureStatus,
+                 String::format("%s,%d,0x%02x,",
+                                states[static_cast<size_t>(capture.state())],
+                                static_cast<int>(capture.channel()),
+                                capture.triggerSource())
+                 + toString(capture.triggerTimestamp()));
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayBoard::protocolGetRelayPower(const String& data, size_t tokenCount)
+auto RelayBoard::protocolReadCapture() -> Result<>
 {
-    try {
-        checkTokenCount(tokenCount, 2);
+    const Capture& capture = m_relayManager.getCapture();
 
-        const uint8_t index = toIndex(data.getToken(TokenSeparator, 1));
+    if (capture.state() != Capture::State::Complete)
+        return CaptureIncompleteError;
 
-        const float voltage = m_relayManager.getVoltage(index);
-        const float current = m_relayManager.getCurrent(index);
+    for (size_t i = 0; i < capture.sampleCount(); ++i)
+    {
+        const Capture::Sample& sample = capture.sample(i);
 
-        sendResponse("<RELAY_POWER>", String::format("%.2f,%.3f", voltage, current));
-    }
-    catch (const std::exception& e) {
-        sendError(e.what());
+        // Time relative to the trigger, negative for pre-trigger samples
+        const auto trigger = static_cast<uint32_t>(capture.triggerTimestamp());
+        const auto time = static_cast<int32_t>(sample.timestamp - trigger);
+
+        sendResponse(Command::ReadCapture,
+                     String::format("%d %ld,%.2f,%.3f",
+                                    static_cast<int>(i),
+                                    static_cast<long>(time),
+                                    sample.voltage, sample.current));
     }
+
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolCharacterizeRelay(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    if (auto result = m_relayManager.startCharacterization(index.value()); !result)
+        return result;
+
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBoard::protocolGetCharacterizationStatus()
+{
+    static constexpr std::array<const char*, 4> states = {
+        "IDLE", "RUNNING", "COMPLETE", "FAILED"
+    };
+
+    const Characterizer& characterizer = m_relayManager.getCharacterizer();
+
+    sendResponse(Command::GetCharacterizationStatus,
+                 String::format("%s,%d", states[static_cast<size_t>(characterizer.state())],
+                                         static_cast<int>(characterizer.channel())));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolGetSwitchTiming(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    const Characterizer::Timing& timing = m_relayManager.getSwitchTiming(index.value());
+
+    if (!timing.valid)
+        return NotCharacterizedError;
+
+    sendResponse(Command::GetSwitchTiming,
+                 String::format("%lu,%lu,%lu,%lu,%lu",
+                                static_cast<unsigned long>(timing.onDelay),
+                                static_cast<unsigned long>(timing.onSettling),
+                                static_cast<unsigned long>(timing.offDelay),
+                                static_cast<unsigned long>(timing.offSettling),
+                                static_cast<unsigned long>(timing.resolution)));
+
+    return {};
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayBoard::protocolSetPowerLimit(const String& data, size_t tokenCount)
+auto RelayBoard::protocolClearFault(const String& data) -> Result<>
 {
-    try {
-        checkTokenCount(tokenCount, 3);
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
 
-        const uint8_t index = toIndex(data.getToken(TokenSeparator, 1));
+    m_relayManager.clearFault(index.value());
 
-        const String power = data.getToken(TokenSeparator, 2);
-        const size_t powerTokenCount = power.countTokens(',');
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolSetReclosePolicy(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    const String arguments = data.getToken(TokenSeparator, 2);
+
+    if (auto result = checkTokenCount(arguments.countTokens(','), 3); !result)
+        return result;
+
+    const auto retryCount = arguments.getToken(',', 0).toULong();
+    const auto delay = arguments.getToken(',', 1).toULong();
+    const auto lockoutCount = arguments.getToken(',', 2).toULong();
+
+    if (!retryCount || !delay || !lockoutCount)
+        return InvalidArgumentError;
+
+    const bool valid = retryCount.value() <= Recloser::MaximumRetryCount &&
+                       delay.value() >= Recloser::MinimumDelay &&
+                       delay.value() <= Recloser::MaximumDelay &&
+                       lockoutCount.value() <= UINT8_MAX;
+    if (!valid)
+        return InvalidArgumentError;
+
+    Recloser::Policy policy;
+    policy.retryCount = static_cast<uint8_t>(retryCount.value());
+    policy.delay = delay.value();
+    policy.lockoutCount = static_cast<uint8_t>(lockoutCount.value());
+
+    m_relayManager.setReclosePolicy(index.value(), policy);
 
-        checkTokenCount(powerTokenCount, 2);
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolGetReclosePolicy(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
 
-        const float voltage = power.getToken(',', 0).toFloat();
-        const float current = power.getToken(',', 1).toFloat();
+    const Recloser::Policy& policy = m_relayManager.getRecloser(index.value()).policy();
+
+    sendResponse(Command::GetReclosePolicy,
+                 String::format("%d,%lu,%d",
+                                static_cast<int>(policy.retryCount),
+                                static_cast<unsigned long>(policy.delay),
+                                static_cast<int>(policy.lockoutCount)));
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolGetRecloseStatus(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
 
-        const bool valid = voltage >= RelayManager::MinimumVoltageLimit &&
-                           voltage <= RelayManager::MaximumVoltageLimit &&
-                           current >= RelayManager::MinimumCurrentLimit &&
-                           current <= RelayManager::MaximumCurrentLimit;
-        if (!valid)
-            throw InvalidArgumentError();
+    const Recloser& recloser = m_relayManager.getRecloser(index.value());
 
-        m_relayManager.setVoltageLimit(index, voltage);
-        m_relayManager.setCurrentLimit(index, current);
+    const char* state = "ACTIVE";
 
-        sendResponse("<OK>");
+    if (recloser.isLockedOut())
+        state = "LOCKED";
+    else if (recloser.isPending())
+        state = "PENDING";
+    else if (recloser.isExhausted())
+        state = "EXHAUSTED";
+
+    sendResponse(Command::GetRecloseStatus,
+                 String::format("%d,%d,%s",
+                                static_cast<int>(recloser.tripCount()),
+                                static_cast<int>(recloser.retryIndex()),
+                                state));
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolSetPowerLimit(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    const auto power = toPowerLimit(data.getToken(TokenSeparator, 2));
+    if (!power)
+        return power.error();
+
+    const auto [voltage, current] = power.value();
+
+    const bool changed = voltage != m_relayManager.getVoltageLimit(index.value()) ||
+                         current != m_relayManager.getCurrentLimit(index.value());
+
+    m_relayManager.setVoltageLimit(index.value(), voltage);
+    m_relayManager.setCurrentLimit(index.value(), current);
+
+    if (changed)
+        Journal::add(Journal::Event::LimitChange, index.value(), voltage, current);
+
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolGetPowerLimit(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    const float voltage = m_relayManager.getVoltageLimit(index.value());
+    const float current = m_relayManager.getCurrentLimit(index.value());
+
+    sendResponse(Command::GetPowerLimit, String::format("%.2f,%.3f", voltage, current));
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolSavePowerLimits() -> Result<>
+{
+    if (auto result = m_relayManager.saveLimits(); !result)
+        return result;
+
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolSetBusSpeed(const String& data) -> Result<>
+{
+    const auto speed = toBusSpeed(data.getToken(TokenSeparator, 1));
+    if (!speed)
+        return speed.error();
+
+    m_relayManager.setBusSpeed(speed.value());
+
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBoard::protocolGetBusSpeed()
+{
+    sendResponse(Command::GetBusSpeed, I2cBus::nameOf(m_relayManager.getBusSpeed()));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolSetFilter(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    const String arguments = data.getToken(TokenSeparator, 2);
+
+    if (auto result = checkTokenCount(arguments.countTokens(','), 3); !result)
+        return result;
+
+    const auto target = toFilterTarget(arguments.getToken(',', 0));
+    if (!target)
+        return target.error();
+
+    const auto medianLength = arguments.getToken(',', 1).toLong();
+    const auto timeConstant = arguments.getToken(',', 2).toFloat();
+
+    if (!medianLength || !timeConstant)
+        return InvalidArgumentError;
+
+    const bool valid = medianLength.value() >= 1 &&
+                       medianLength.value() <= static_cast<long>(Filter::MaximumMedianLength) &&
+                       timeConstant.value() >= 0.0F &&
+                       timeConstant.value() <= Filter::MaximumTimeConstant;
+    if (!valid)
+        return InvalidArgumentError;
+
+    Filter::Settings settings;
+    settings.medianLength = static_cast<uint8_t>(medianLength.value());
+    settings.timeConstant = timeConstant.value();
+
+    m_relayManager.setFilter(index.value(), target.value(), settings);
+
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolGetFilter(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    const auto target = toFilterTarget(data.getToken(TokenSeparator, 2));
+    if (!target)
+        return target.error();
+
+    const Filter::Settings& settings = m_relayManager.getFilter(index.value(), target.value());
+
+    sendResponse(Command::GetFilter,
+                 String::format("%d,%.3f", static_cast<int>(settings.medianLength),
+                                           settings.timeConstant));
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolSetProfileLimit(const String& data) -> Result<>
+{
+    const auto index = toIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    const auto power = toPowerLimit(data.getToken(TokenSeparator, 2));
+    if (!power)
+        return power.error();
+
+    m_profileBuffer.voltageLimits[index.value()] = power.value().voltage;
+    m_profileBuffer.currentLimits[index.value()] = power.value().current;
+
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolStoreProfile(const String& data) -> Result<>
+{
+    const auto index = toProfileIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    const String name = data.getToken(TokenSeparator, 2);
+
+    if (name.empty() || name.size() > UserPage::MaximumNameLength)
+        return InvalidArgumentError;
+
+    // Names are sent back unquoted, so they must not contain separators
+    const bool valid = std::all_of(name.cbegin(), name.cend(), [](char c) {
+        return c > ' ' && c <= '~' && c != ',';
+    });
+
+    if (!valid)
+        return InvalidArgumentError;
+
+    UserPage::Profile profile = {};
+    std::copy(name.cbegin(), name.cend(), profile.name.begin());
+    profile.data = m_profileBuffer;
+
+    if (auto result = UserPage::setProfile(index.value(), profile); !result)
+        return result;
+
+    Journal::add(Journal::Event::ProfileStored, Journal::NoChannel, index.value());
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBoard::protocolGetProfiles()
+{
+    for (size_t i = 0; i < UserPage::ProfileCount; ++i)
+    {
+        const UserPage::Profile* profile = UserPage::profile(i);
+
+        if (profile)
+            sendResponse(Command::GetProfiles,
+                         String::format("%d ", static_cast<int>(i))
+                         + profile->name.data());
     }
-    catch (const std::exception& e) {
-        sendError(e.what());
+
+    sendResponse("<OK>");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolGetProfileLimits(const String& data) -> Result<>
+{
+    const auto index = toProfileIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
+
+    const UserPage::Profile* profile = UserPage::profile(index.value());
+
+    if (!profile)
+        return ProfileEmptyError;
+
+    for (size_t i = 0; i < RelayManager::RelayCount; ++i)
+    {
+        sendResponse(Command::GetProfileLimits,
+                     String::format("%d %.2f,%.3f", static_cast<int>(i),
+                                    profile->data.voltageLimits[i],
+                                    profile->data.currentLimits[i]));
     }
+
+    sendResponse("<OK>");
+
+    return {};
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayBoard::protocolGetPowerLimit(const String& data, size_t tokenCount)
+auto RelayBoard::protocolLoadProfile(const String& data) -> Result<>
 {
-    try {
-        checkTokenCount(tokenCount, 2);
+    const auto index = toProfileIndex(data.getToken(TokenSeparator, 1));
+    if (!index)
+        return index.error();
 
-        const uint8_t index = toIndex(data.getToken(TokenSeparator, 1));
+    const UserPage::Profile* profile = UserPage::profile(index.value());
 
-        const float voltage = m_relayManager.getVoltageLimit(index);
-        const float current = m_relayManager.getCurrentLimit(index);
+    if (!profile)
+        return ProfileEmptyError;
 
-        sendResponse("<POWER_LIMIT>", String::format("%.2f,%.3f", voltage, current));
+    // Takes effect with the next update of each relay, SAVE_POWER_LIMITS makes it persistent
+    for (size_t i = 0; i < RelayManager::RelayCount; ++i)
+    {
+        m_relayManager.setVoltageLimit(i, profile->data.voltageLimits[i]);
+        m_relayManager.setCurrentLimit(i, profile->data.currentLimits[i]);
     }
-    catch (const std::exception& e) {
-        sendError(e.what());
+
+    Journal::add(Journal::Event::ProfileLoaded, Journal::NoChannel, index.value());
+    sendResponse("<OK>");
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBoard::protocolGetJournalStatus()
+{
+    const auto first = static_cast<unsigned long>(Journal::firstSequence());
+    const auto next = static_cast<unsigned long>(Journal::nextSequence());
+
+    sendResponse(Command::GetJournalStatus, String::format("%lu,%lu", first, next));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolReadJournal(const String& data) -> Result<>
+{
+    static constexpr unsigned long DefaultCount = 16;
+    static constexpr unsigned long MaximumCount = 32;
+
+    const String arguments = data.getToken(TokenSeparator, 1);
+    const size_t argumentCount = arguments.countTokens(',');
+
+    const auto cursor = arguments.getToken(',', 0).toULong();
+    const auto count = (argumentCount > 1) ? arguments.getToken(',', 1).toULong()
+                                           : Result<unsigned long>(DefaultCount);
+
+    if (!cursor || !count || count.value() == 0 || count.value() > MaximumCount)
+        return InvalidArgumentError;
+
+    // Entries already overwritten are skipped, the host detects the gap from the sequence
+    uint32_t sequence = std::max<uint32_t>(cursor.value(), Journal::firstSequence());
+    const uint32_t end = std::min<uint32_t>(sequence + count.value(), Journal::nextSequence());
+
+    for (; sequence < end; ++sequence)
+    {
+        const Journal::Entry& entry = Journal::entry(sequence);
+        const int channel = (entry.channel == Journal::NoChannel) ? -1 : entry.channel;
+
+        sendResponse(Command::ReadJournal,
+                     String::format("%lu ",
+                                    static_cast<unsigned long>(sequence))
+                     + toString(entry.timestamp)
+                     + String::format(",%s,%d,%.3f,%.3f",
+                                      Journal::nameOf(entry.event),
+                                      channel, entry.value1, entry.value2));
     }
+
+    sendResponse("<OK>");
+
+    return {};
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayBoard::protocolSavePowerLimits()
+void RelayBoard::protocolGetPerfCounters()
 {
-    try {
-        m_relayManager.saveLimits();
-        sendResponse("<OK>");
+    for (size_t i = 0; i < PerfCounter::CounterCount; ++i)
+    {
+        const auto id = static_cast<PerfCounter::Id>(i);
+        const PerfCounter& counter = PerfCounter::get(id);
+
+        sendResponse(Command::GetPerfCounters,
+                     String::format("%d %s,%lu,%lu,%lu,%lu",
+                                    static_cast<int>(i),
+                                    PerfCounter::nameOf(id),
+                                    static_cast<unsigned long>(counter.count()),
+                                    static_cast<unsigned long>(counter.min()),
+                                    static_cast<unsigned long>(counter.max()),
+                                    static_cast<unsigned long>(counter.mean())));
     }
-    catch (const std::exception& e) {
-        sendError(e.what());
+
+    sendResponse("<OK>");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBoard::protocolGetPerfHistograms()
+{
+    for (size_t i = 0; i < PerfCounter::CounterCount; ++i)
+    {
+        const PerfCounter& counter = PerfCounter::get(static_cast<PerfCounter::Id>(i));
+
+        String bins = String::format("%d ", static_cast<int>(i));
+
+        for (size_t j = 0; j < PerfCounter::BinCount; ++j)
+        {
+            if (j > 0)
+                bins += ',';
+
+            bins += String::format("%u", counter.bin(j));
+        }
+
+        sendResponse(Command::GetPerfHistograms, bins);
     }
+
+    sendResponse("<OK>");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBoard::protocolResetPerfCounters()
+{
+    PerfCounter::resetAll();
+    sendResponse("<OK>");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBoard::protocolGetDeviceTime()
+{
+    // Reception and transmission time for round-trip compensation on the host
+    sendResponse(Command::GetDeviceTime,
+                 toString(m_requestTime) + "," + toString(DeviceClock::now()));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::protocolSetTimestamps(const String& data) -> Result<>
+{
+    const String state = data.getToken(TokenSeparator, 1);
+
+    if (state == "ON")
+        m_timestampsEnabled = true;
+    else if (state == "OFF")
+        m_timestampsEnabled = false;
+    else
+        return InvalidArgumentError;
+
+    Journal::add(Journal::Event::Timestamps, Journal::NoChannel, m_timestampsEnabled);
+    sendResponse("<OK>");
+
+    return {};
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -304,28 +1143,28 @@ void RelayBoard::protocolReset()
 
 void RelayBoard::protocolGetBootMode()
 {
-    sendResponse("<BOOT_MODE>", "FIRMWARE");
+    sendResponse(Command::GetBootMode, "FIRMWARE");
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBoard::protocolGetBoardName()
 {
-    sendResponse("<BOARD_NAME>", Config::BoardName);
+    sendResponse(Command::GetBoardName, Config::BoardName);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBoard::protocolGetHardwareVersion()
 {
-    sendResponse("<HARDWARE_VERSION>", Config::HardwareVersion);
+    sendResponse(Command::GetHardwareVersion, Config::HardwareVersion);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBoard::protocolGetFirmwareVersion()
 {
-    sendResponse("<FIRMWARE_VERSION>", Config::FirmwareVersion);
+    sendResponse(Command::GetFirmwareVersion, Config::FirmwareVersion);
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -342,14 +1181,14 @@ void RelayBoard::protocolGetSerialNumber()
     for (size_t i = 2; i < size; i += 2)
         serial += buffer[i];
 
-    sendResponse("<SERIAL_NUMBER>", serial);
+    sendResponse(Command::GetSerialNumber, serial);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayBoard::protocolGetBuildTimestamp()
 {
-    sendResponse("<BUILD_TIMESTAMP>", String::format("%d", BUILD_TIMESTAMP));
+    sendResponse(Command::GetBuildTimestamp, String::format("%d", BUILD_TIMESTAMP));
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -366,10 +1205,12 @@ void RelayBoard::protocolLaunchBootloader()
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayBoard::checkTokenCount(size_t tokenCount, size_t expectedCount)
+auto RelayBoard::checkTokenCount(size_t tokenCount, size_t expectedCount) -> Result<>
 {
     if (tokenCount < expectedCount)
-        throw MissingArgumentError();
+        return MissingArgumentError;
+
+    return {};
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -381,34 +1222,73 @@ void RelayBoard::sendResponse(const String& tag, const String& data)
     if (!data.empty())
         response += " " + data;
 
+    appendTimestamp(response);
+
+    PerfScope scope(PerfCounter::Id::SendData);
+    m_hostInterface.sendData(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBoard::sendResponse(Protocol::Command command, const String& data)
+{
+    sendResponse(Protocol::info(command).response.data(), data);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayBoard::sendError(const Error& error)
+{
+    String response = "<ERROR> " + String(error.code());
+    appendTimestamp(response);
+
+    PerfScope scope(PerfCounter::Id::SendData);
     m_hostInterface.sendData(response);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayBoard::sendError(const String& error)
+void RelayBoard::appendTimestamp(String& response)
 {
-    m_hostInterface.sendData("<ERROR> " + error);
+    if (!m_timestampsEnabled)
+        return;
+
+    const String timestamp = " @" + toString(DeviceClock::now());
+
+    // Dropped rather than overflowing the line, the host treats it as optional
+    const size_t size = response.size() + timestamp.size() + HostInterface::LineTerminatorSize;
+
+    if (size <= response.capacity())
+        response += timestamp;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto RelayBoard::toIndex(const String& s) -> uint8_t
+auto RelayBoard::toIndex(const String& s) -> Result<uint8_t>
 {
-    if (s.empty())
-        throw InvalidArgumentError();
+    const auto index = s.toLong();
+
+    if (!index || index.value() < 0 || index.value() >= 16)
+        return InvalidArgumentError;
+
+    return static_cast<uint8_t>(index.value());
+}
 
-    long index = s.toLong();
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::toProfileIndex(const String& s) -> Result<uint8_t>
+{
+    const auto index = s.toLong();
 
-    if (index < 0 || index >= 16)
-        throw InvalidArgumentError();
+    if (!index || index.value() < 0 || index.value() >= static_cast<long>(UserPage::ProfileCount))
+        return InvalidArgumentError;
 
-    return static_cast<uint8_t>(index);
+    return static_cast<uint8_t>(index.value());
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto RelayBoard::toRelayState(const String& s) -> RelayState
+auto RelayBoard::toRelayState(const String& s) -> Result<RelayState>
 {
     if (s == "ON")
         return RelayState::On;
@@ -416,7 +1296,58 @@ auto RelayBoard::toRelayState(const String& s) -> RelayState
     if (s == "OFF")
         return RelayState::Off;
 
-    throw InvalidArgumentError();
+    return InvalidArgumentError;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::toPowerLimit(const String& s) -> Result<PowerLimit>
+{
+    if (auto result = checkTokenCount(s.countTokens(','), 2); !result)
+        return result.error();
+
+    const auto voltage = s.getToken(',', 0).toFloat();
+    const auto current = s.getToken(',', 1).toFloat();
+
+    if (!voltage || !current)
+        return InvalidArgumentError;
+
+    const bool valid = voltage.value() >= RelayManager::MinimumVoltageLimit &&
+                       voltage.value() <= RelayManager::MaximumVoltageLimit &&
+                       current.value() >= RelayManager::MinimumCurrentLimit &&
+                       current.value() <= RelayManager::MaximumCurrentLimit;
+    if (!valid)
+        return InvalidArgumentError;
+
+    return PowerLimit { voltage.value(), current.value() };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::toFilterTarget(const String& s) -> Result<FilterTarget>
+{
+    if (s == "FAULT")
+        return FilterTarget::Fault;
+
+    if (s == "REPORT")
+        return FilterTarget::Report;
+
+    return InvalidArgumentError;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayBoard::toBusSpeed(const String& s) -> Result<I2cBus::Speed>
+{
+    for (size_t i = 0; i < I2cBus::SpeedCount; ++i)
+    {
+        const auto speed = static_cast<I2cBus::Speed>(i);
+
+        if (s == I2cBus::nameOf(speed))
+            return speed;
+    }
+
+    return InvalidArgumentError;
 }
 
 // ---------------------------------------------------------------------------------------------- //
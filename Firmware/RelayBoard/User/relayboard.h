@@ -24,35 +24,92 @@
 #pragma once
 
 #include "hostinterface.h"
+#include "protocol.h"
 #include "relaymanager.h"
+#include "result.h"
+#include "userpage.h"
 
 class RelayBoard : public HostInterface::Owner, public RelayManager::Owner
 {
+public:
+    struct PowerLimit
+    {
+        float voltage;
+        float current;
+    };
+
 public:
 	RelayBoard();
 
     void exec();
 
+    // A single pass of the main loop, exec() repeats it forever
+    void update();
+
 private:
     void onHostDataReceived(const String& data) override;
     void onHostDataOverflow() override;
 
     void onRelayFault() override;
+    void onRelayFaultsCleared() override;
+
+    auto dispatch(Protocol::Command command, const String& data, size_t tokenCount) -> Result<>;
 
     void protocolGetFaultMask();
 
-    void protocolSetRelayState(const String& data, size_t tokenCount);
-    void protocolGetRelayState(const String& data, size_t tokenCount);
+    auto protocolSetRelayState(const String& data) -> Result<>;
+    auto protocolGetRelayState(const String& data) -> Result<>;
 
-    void protocolSetStateMask(const String& data, size_t tokenCount);
+    auto protocolSetStateMask(const String& data) -> Result<>;
     void protocolGetStateMask();
 
-    void protocolGetRelayPower(const String& data, size_t tokenCount);
+    auto protocolGetRelayPower(const String& data) -> Result<>;
+    auto protocolGetRelayWattage(const String& data) -> Result<>;
+
+    void protocolGetEnergyCounters();
+    auto protocolResetEnergyCounters(const String& data, size_t tokenCount) -> Result<>;
+
+    auto protocolArmCapture(const String& data) -> Result<>;
+    auto protocolDisarmCapture() -> Result<>;
+    void protocolGetCaptureStatus();
+    auto protocolReadCapture() -> Result<>;
+
+    auto protocolCharacterizeRelay(const String& data) -> Result<>;
+    void protocolGetCharacterizationStatus();
+    auto protocolGetSwitchTiming(const String& data) -> Result<>;
+
+    auto protocolClearFault(const String& data) -> Result<>;
+
+    auto protocolSetReclosePolicy(const String& data) -> Result<>;
+    auto protocolGetReclosePolicy(const String& data) -> Result<>;
+    auto protocolGetRecloseStatus(const String& data) -> Result<>;
+
+    auto protocolSetPowerLimit(const String& data) -> Result<>;
+    auto protocolGetPowerLimit(const String& data) -> Result<>;
 
-    void protocolSetPowerLimit(const String& data, size_t tokenCount);
-    void protocolGetPowerLimit(const String& data, size_t tokenCount);
+    auto protocolSavePowerLimits() -> Result<>;
 
-    void protocolSavePowerLimits();
+    auto protocolSetBusSpeed(const String& data) -> Result<>;
+    void protocolGetBusSpeed();
+
+    auto protocolSetFilter(const String& data) -> Result<>;
+    auto protocolGetFilter(const String& data) -> Result<>;
+
+    auto protocolSetProfileLimit(const String& data) -> Result<>;
+    auto protocolStoreProfile(const String& data) -> Result<>;
+    void protocolGetProfiles();
+    auto protocolGetProfileLimits(const String& data) -> Result<>;
+    auto protocolLoadProfile(const String& data) -> Result<>;
+
+    void protocolGetJournalStatus();
+    auto protocolReadJournal(const String& data) -> Result<>;
+
+    void protocolGetPerfCounters();
+    void protocolGetPerfHistograms();
+    void protocolResetPerfCounters();
+
+    void protocolGetDeviceTime();
+    auto protocolSetTimestamps(const String& data) -> Result<>;
 
     void protocolReset();
 
@@ -66,15 +123,30 @@ private:
 
     void protocolLaunchBootloader();
 
-    void checkTokenCount(size_t tokenCount, size_t expectedCount);
+    auto checkTokenCount(size_t tokenCount, size_t expectedCount) -> Result<>;
 
     void sendResponse(const String& tag, const String& data = {});
-    void sendError(const String& error);
+    void sendResponse(Protocol::Command command, const String& data);
+    void sendError(const Error& error);
 
-    auto toIndex(const String& s) -> uint8_t;
-    auto toRelayState(const String& s) -> RelayState;
+    void appendTimestamp(String& response);
+
+    auto toIndex(const String& s) -> Result<uint8_t>;
+    auto toProfileIndex(const String& s) -> Result<uint8_t>;
+    auto toRelayState(const String& s) -> Result<RelayState>;
+    auto toPowerLimit(const String& s) -> Result<PowerLimit>;
+    auto toFilterTarget(const String& s) -> Result<FilterTarget>;
+    auto toBusSpeed(const String& s) -> Result<I2cBus::Speed>;
 
 private:
     HostInterface m_hostInterface;
     RelayManager m_relayManager;
+
+    // Staging area for limits uploaded with SET_PROFILE_LIMIT
+    UserPage::Data m_profileBuffer = {};
+
+    uint64_t m_requestTime = 0;
+    bool m_timestampsEnabled = false;
+
+    uint32_t m_loopStart = 0;
 };
@@ -22,6 +22,8 @@
 // ============================================================================================== //
 
 #include "assert.h"
+#include "deviceclock.h"
+#include "journal.h"
 #include "relaymanager.h"
 #include "userpage.h"
 
@@ -29,6 +31,12 @@
 
 // ---------------------------------------------------------------------------------------------- //
 
+namespace {
+    using SamplingRate = PowerMonitor::SamplingRate;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 RelayManager* RelayManager::s_instance = nullptr;
 
 // ---------------------------------------------------------------------------------------------- //
@@ -51,6 +59,9 @@ RelayManager::RelayManager(Owner* owner)
 
     for (auto& current : m_currentLimits)
         current = std::clamp(current, MinimumCurrentLimit, MaximumCurrentLimit);
+
+    for (auto& accumulator : m_accumulators)
+        accumulator.reset(DeviceClock::now());
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -63,54 +74,306 @@ RelayManager::~RelayManager()
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayManager::update()
+{
+    if (m_fastSampling && !m_capture.isSampling())
+    {
+        // Retried on the next pass if the chip did not respond
+        if (m_powerMonitors[m_capture.channel()].setSamplingRate(SamplingRate::Normal))
+            m_fastSampling = false;
+    }
+
+    if (m_characterizerSampling && !m_characterizer.isRunning())
+    {
+        const auto rate = SamplingRate::Normal;
+
+        if (m_powerMonitors[m_characterizer.channel()].setSamplingRate(rate))
+            m_characterizerSampling = false;
+    }
+
+    // While a relay is being characterized, its conversions are read as soon as they
+    // complete. Every other one leaves room for the next channel in the rotation, so no
+    // channel goes unprotected while an edge is recorded.
+    if (m_characterizer.isMeasuring())
+    {
+        if (updateCharacterization())
+        {
+            m_interleaveTurn = !m_interleaveTurn;
+
+            if (m_interleaveTurn)
+                updateNextChannel();
+        }
+
+        return;
+    }
+
+    // A channel being captured or characterized is sampled in between every other channel
+    if (m_capture.isSampling() || m_characterizer.isRunning())
+    {
+        m_interleaveTurn = !m_interleaveTurn;
+
+        if (m_interleaveTurn)
+        {
+            if (m_characterizer.isRunning())
+                updateCharacterization();
+            else
+                update(m_capture.channel());
+
+            return;
+        }
+    }
+
+    updateNextChannel();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayManager::updateNextChannel()
 {
     update(m_updateIndex);
 
     if (++m_updateIndex >= RelayCount)
+    {
         m_updateIndex = 0;
+        checkBusErrors();
+    }
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void RelayManager::update(size_t index)
 {
+    const uint64_t timestamp = DeviceClock::now();
+
+    if (getFault(index) == RelayFault::Set && m_reclosers[index].isDue(timestamp))
+        reclose(index, timestamp);
+
     if (getFault(index) == RelayFault::Set)
     {
         ASSERT(getState(index) == RelayState::Off);
+        m_accumulators[index].update(0.0F, 0.0F, timestamp);
+        updateCapture(index, timestamp);
         return;
     }
 
     static constexpr int RetryCount = 3;
 
+    int errorCount = 0;
+    bool valid = false;
+
+    float faultVoltage = m_voltages[index];
+    float faultCurrent = m_currents[index];
+
     for (int i = 1; i <= RetryCount; ++i)
     {
-        try {
-            m_voltages[index] = m_powerMonitors[index].getVoltage();
-            m_currents[index] = m_powerMonitors[index].getCurrent();
+        const auto voltage = m_powerMonitors[index].getVoltage();
+        const auto current = m_powerMonitors[index].getCurrent();
+        const auto power = m_powerMonitors[index].getPower();
+
+        if (!voltage || !current || !power)
+        {
+            ++errorCount;
+            continue;
+        }
 
-            const bool valid = m_voltages[index] <= m_voltageLimits[index] &&
-                               m_currents[index] <= m_currentLimits[index];
-            if (valid)
-                return;
+        ChannelFilters& filters = m_filters[index];
 
-            break;
-        }
-        catch (...) {
-        }
+        m_voltages[index] = filters.reportVoltage.update(voltage.value(), timestamp);
+        m_currents[index] = filters.reportCurrent.update(current.value(), timestamp);
+        m_powers[index] = power.value();
+
+        // Energy and captured waveforms are based on unfiltered readings
+        m_accumulators[index].update(current.value(), power.value(), timestamp);
+        m_capture.addSample(index, timestamp, voltage.value(), current.value());
+
+        faultVoltage = filters.faultVoltage.update(voltage.value(), timestamp);
+        faultCurrent = filters.faultCurrent.update(current.value(), timestamp);
+
+        valid = faultVoltage <= m_voltageLimits[index] && faultCurrent <= m_currentLimits[index];
+        break;
     }
 
+    if (errorCount > 0)
+    {
+        Journal::add(Journal::Event::I2cError, index, errorCount);
+        m_busErrorCount += errorCount;
+    }
+
+    if (!valid)
+        trip(index, faultVoltage, faultCurrent, timestamp);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayManager::trip(size_t index, float voltage, float current, uint64_t timestamp)
+{
+    m_capture.trigger(index, Capture::FaultTrigger, timestamp);
+    Journal::add(Journal::Event::Fault, index, voltage, current);
+
+    // The characterizer would otherwise switch the relay on again for its next phase
+    if (m_characterizer.isRunning() && m_characterizer.channel() == index)
+    {
+        m_characterizer.abort();
+        m_switchTimings[index] = {};
+    }
+
+    // Only a relay that was switched on by the host is switched on again
+    const bool wasOn = getState(index) == RelayState::On;
+
     setState(index, RelayState::Off);
     setFault(index, RelayFault::Set);
 
+    if (wasOn)
+    {
+        Recloser& recloser = m_reclosers[index];
+
+        if (!recloser.onTrip(timestamp) && recloser.isLockedOut())
+            Journal::add(Journal::Event::Lockout, index, recloser.tripCount());
+    }
+
     m_owner->onRelayFault();
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
+void RelayManager::reclose(size_t index, uint64_t timestamp)
+{
+    Recloser& recloser = m_reclosers[index];
+    recloser.onReclose(timestamp);
+
+    // Readings from before the trip would otherwise trip the relay again
+    resetFilters(index);
+
+    setFault(index, RelayFault::Unset);
+    setState(index, RelayState::On);
+
+    Journal::add(Journal::Event::Reclose, index, recloser.retryIndex());
+
+    if (m_faultMask == 0x0000)
+        m_owner->onRelayFaultsCleared();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayManager::updateCapture(size_t index, uint64_t timestamp)
+{
+    // Keeps recording the decay on a channel that was switched off by a fault
+    if (!m_capture.isSampling(index))
+        return;
+
+    const auto voltage = m_powerMonitors[index].getVoltage();
+    const auto current = m_powerMonitors[index].getCurrent();
+
+    if (voltage && current)
+        m_capture.addSample(index, timestamp, voltage.value(), current.value());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayManager::updateCharacterization() -> bool
+{
+    const size_t index = m_characterizer.channel();
+    const PowerMonitor& monitor = m_powerMonitors[index];
+
+    const uint64_t lastPollTime = m_conversionPollTime;
+
+    const auto ready = monitor.isConversionReady();
+    const uint64_t timestamp = DeviceClock::now();
+
+    m_conversionPollTime = timestamp;
+
+    // Only the current is read to keep the sampling interval short, and only once per
+    // conversion. The conversion completed since the flag was last polled, but no longer
+    // than one conversion ago, and is stamped with the middle of its averaging window.
+    if (ready && ready.value())
+    {
+        const uint32_t conversionTime = monitor.getConversionTime();
+        const uint64_t earliest = std::max(lastPollTime, timestamp - conversionTime);
+        const uint64_t middle = (earliest + timestamp) / 2 - conversionTime / 2;
+
+        if (const auto current = monitor.getCurrent(); current)
+        {
+            m_characterizer.addSample(middle, current.value());
+
+            // A short switched on by the characterizer must trip as quickly as it would
+            // outside a measurement, so every conversion is checked against the limits
+            if (!checkCharacterizedChannel(index, current.value(), timestamp))
+                return true;
+        }
+    }
+
+    // Taken again as the phase starts when the relay is switched right after
+    switch (m_characterizer.poll(DeviceClock::now()))
+    {
+    case Characterizer::Action::SwitchOn:
+        setState(index, RelayState::On);
+        break;
+
+    case Characterizer::Action::SwitchOff:
+        setState(index, RelayState::Off);
+        break;
+
+    case Characterizer::Action::Finish:
+        setState(index, RelayState::Off);
+        m_switchTimings[index] = m_characterizer.timing();
+        Journal::add(Journal::Event::Characterized, index, m_switchTimings[index].valid);
+        break;
+
+    case Characterizer::Action::None:
+        break;
+    }
+
+    // A failed poll leaves the bus to the other channels as well, instead of retrying at once
+    return !ready || ready.value();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayManager::checkCharacterizedChannel(size_t index, float current,
+                                             uint64_t timestamp) -> bool
+{
+    ChannelFilters& filters = m_filters[index];
+
+    // Read after the current so as not to delay its time stamp, a failed read is left to
+    // the channel's own turn in the rotation
+    float faultVoltage = 0.0F;
+
+    if (const auto voltage = m_powerMonitors[index].getVoltage(); voltage)
+        faultVoltage = filters.faultVoltage.update(voltage.value(), timestamp);
+    else
+    {
+        Journal::add(Journal::Event::I2cError, index, 1);
+        ++m_busErrorCount;
+    }
+
+    const float faultCurrent = filters.faultCurrent.update(current, timestamp);
+
+    if (faultVoltage <= m_voltageLimits[index] && faultCurrent <= m_currentLimits[index])
+        return true;
+
+    trip(index, faultVoltage, faultCurrent, timestamp);
+    return false;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void RelayManager::reset()
 {
+    Journal::add(Journal::Event::Reset, Journal::NoChannel, m_faultMask);
+
+    if (m_characterizer.isRunning())
+    {
+        m_characterizer.abort();
+        m_switchTimings[m_characterizer.channel()] = {};
+    }
+
     setStateMask(0x0000);
     setFaultMask(0x0000);
+
+    for (size_t i = 0; i < RelayCount; ++i)
+    {
+        resetFilters(i);
+        m_reclosers[i].reset();
+    }
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -156,9 +419,23 @@ void RelayManager::setState(size_t index, RelayState state)
 {
     ASSERT(index < RelayCount);
 
+    // Switching a tripped relay off tells it to stay off
+    if (state == RelayState::Off)
+        m_reclosers[index].cancel();
+
     if (m_faultMask & (1<<index))
         return;
 
+    if (state != getState(index))
+    {
+        m_capture.trigger(index, Capture::SwitchTrigger, DeviceClock::now());
+
+        const auto event = (state == RelayState::On) ? Journal::Event::RelayOn
+                                                     : Journal::Event::RelayOff;
+
+        Journal::add(event, index, m_voltages[index], m_currents[index]);
+    }
+
     const GPIO_PinState pinState = (state == RelayState::On) ? GPIO_PIN_SET : GPIO_PIN_RESET;
     HAL_GPIO_WritePin(port(index), pin(index), pinState);
 }
@@ -194,6 +471,42 @@ auto RelayManager::getFault(size_t index) const -> RelayFault
 
 // ---------------------------------------------------------------------------------------------- //
 
+void RelayManager::clearFault(size_t index)
+{
+    ASSERT(index < RelayCount);
+
+    m_reclosers[index].reset();
+
+    if (getFault(index) == RelayFault::Unset)
+        return;
+
+    resetFilters(index);
+    setFault(index, RelayFault::Unset);
+
+    Journal::add(Journal::Event::FaultCleared, index);
+
+    if (m_faultMask == 0x0000)
+        m_owner->onRelayFaultsCleared();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayManager::setReclosePolicy(size_t index, const Recloser::Policy& policy)
+{
+    ASSERT(index < RelayCount);
+    m_reclosers[index].configure(policy);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayManager::getRecloser(size_t index) const -> const Recloser&
+{
+    ASSERT(index < RelayCount);
+    return m_reclosers[index];
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 auto RelayManager::getVoltage(size_t index) const -> float
 {
     ASSERT(index < RelayCount);
@@ -210,6 +523,199 @@ auto RelayManager::getCurrent(size_t index) const -> float
 
 // ---------------------------------------------------------------------------------------------- //
 
+auto RelayManager::getPower(size_t index) const -> float
+{
+    ASSERT(index < RelayCount);
+    return m_powers[index];
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayManager::checkBusErrors()
+{
+    static constexpr int ErrorThreshold = 4;
+
+    const int errorCount = m_busErrorCount;
+    m_busErrorCount = 0;
+
+    if (errorCount < ErrorThreshold || m_bus.speed() == I2cBus::Speed::Standard)
+        return;
+
+    const auto speed = static_cast<I2cBus::Speed>(static_cast<uint8_t>(m_bus.speed()) - 1);
+    m_bus.setSpeed(speed);
+
+    Journal::add(Journal::Event::BusSpeed, Journal::NoChannel, static_cast<uint8_t>(speed),
+                 errorCount);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayManager::setBusSpeed(I2cBus::Speed speed)
+{
+    if (speed == m_bus.speed())
+        return;
+
+    m_bus.setSpeed(speed);
+    m_busErrorCount = 0;
+
+    Journal::add(Journal::Event::BusSpeed, Journal::NoChannel, static_cast<uint8_t>(speed));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayManager::getBusSpeed() const -> I2cBus::Speed
+{
+    return m_bus.speed();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayManager::setFilter(size_t index, FilterTarget target, const Filter::Settings& settings)
+{
+    ASSERT(index < RelayCount);
+
+    ChannelFilters& filters = m_filters[index];
+
+    if (target == FilterTarget::Fault)
+    {
+        filters.faultVoltage.configure(settings);
+        filters.faultCurrent.configure(settings);
+    }
+    else
+    {
+        filters.reportVoltage.configure(settings);
+        filters.reportCurrent.configure(settings);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayManager::getFilter(size_t index, FilterTarget target) const -> const Filter::Settings&
+{
+    ASSERT(index < RelayCount);
+
+    const ChannelFilters& filters = m_filters[index];
+
+    return (target == FilterTarget::Fault) ? filters.faultVoltage.settings()
+                                           : filters.reportVoltage.settings();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayManager::resetFilters(size_t index)
+{
+    ChannelFilters& filters = m_filters[index];
+
+    filters.faultVoltage.reset();
+    filters.faultCurrent.reset();
+    filters.reportVoltage.reset();
+    filters.reportCurrent.reset();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayManager::getAccumulator(size_t index) const -> const Accumulator&
+{
+    ASSERT(index < RelayCount);
+    return m_accumulators[index];
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void RelayManager::resetAccumulator(size_t index)
+{
+    ASSERT(index < RelayCount);
+    m_accumulators[index].reset(DeviceClock::now());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayManager::armCapture(size_t index, uint8_t triggerMask, float threshold) -> Result<>
+{
+    ASSERT(index < RelayCount);
+
+    if (m_characterizer.isRunning() || m_characterizerSampling)
+        return SamplingBusyError;
+
+    if (auto result = disarmCapture(); !result)
+        return result;
+
+    if (auto result = m_powerMonitors[index].setSamplingRate(SamplingRate::Fast); !result)
+        return result;
+
+    m_fastSampling = true;
+    m_capture.arm(index, triggerMask, threshold);
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayManager::disarmCapture() -> Result<>
+{
+    m_capture.disarm();
+
+    if (m_fastSampling)
+    {
+        const auto rate = SamplingRate::Normal;
+
+        if (auto result = m_powerMonitors[m_capture.channel()].setSamplingRate(rate); !result)
+            return result;
+
+        m_fastSampling = false;
+    }
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayManager::getCapture() const -> const Capture&
+{
+    return m_capture;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayManager::startCharacterization(size_t index) -> Result<>
+{
+    ASSERT(index < RelayCount);
+
+    // Both need the interleaved sampling slot and a reconfigured power monitor
+    if (m_characterizer.isRunning() || m_characterizerSampling || m_capture.isSampling())
+        return SamplingBusyError;
+
+    if (getFault(index) == RelayFault::Set)
+        return RelayFaultError;
+
+    if (auto result = m_powerMonitors[index].setSamplingRate(SamplingRate::Fastest); !result)
+        return result;
+
+    m_characterizerSampling = true;
+
+    setState(index, RelayState::Off);
+    m_characterizer.start(index, DeviceClock::now());
+
+    return {};
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayManager::getCharacterizer() const -> const Characterizer&
+{
+    return m_characterizer;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto RelayManager::getSwitchTiming(size_t index) const -> const Characterizer::Timing&
+{
+    ASSERT(index < RelayCount);
+    return m_switchTimings[index];
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void RelayManager::setVoltageLimit(size_t index, float voltage)
 {
     ASSERT(index < RelayCount);
@@ -252,7 +758,7 @@ auto RelayManager::getCurrentLimit(size_t index) const -> float
 
 // ---------------------------------------------------------------------------------------------- //
 
-void RelayManager::saveLimits()
+auto RelayManager::saveLimits() -> Result<>
 {
     if (m_limitsDirty)
     {
@@ -260,9 +766,15 @@ void RelayManager::saveLimits()
             m_voltageLimits, m_currentLimits
         };
 
-        UserPage::setData(data);
+        if (auto result = UserPage::setData(data); !result)
+            return result;
+
         m_limitsDirty = false;
+
+        Journal::add(Journal::Event::LimitsSaved);
     }
+
+    return {};
 }
 
 // ---------------------------------------------------------------------------------------------- //
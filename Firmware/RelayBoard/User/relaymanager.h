@@ -23,8 +23,13 @@
 
 #pragma once
 
+#include "accumulator.h"
+#include "capture.h"
+#include "characterizer.h"
 #include "config.h"
+#include "filter.h"
 #include "powermonitor.h"
+#include "recloser.h"
 
 #include <array>
 
@@ -40,6 +45,12 @@ enum class RelayFault
     Set
 };
 
+enum class FilterTarget
+{
+    Fault,
+    Report
+};
+
 class RelayManager
 {
 public:
@@ -51,10 +62,14 @@ public:
     static constexpr float MinimumCurrentLimit =  0.0F;
     static constexpr float MaximumCurrentLimit =  2.0F;
 
+    static constexpr Error SamplingBusyError = Error("SAMPLING_BUSY");
+    static constexpr Error RelayFaultError = Error("RELAY_FAULT");
+
     class Owner
     {
         friend class RelayManager;
         virtual void onRelayFault() = 0;
+        virtual void onRelayFaultsCleared() = 0;
     };
 
 public:
@@ -75,8 +90,35 @@ public:
 
     auto getFault(size_t index) const -> RelayFault;
 
+    // Leaves the relay switched off and all other relays untouched
+    void clearFault(size_t index);
+
+    void setReclosePolicy(size_t index, const Recloser::Policy& policy);
+    auto getRecloser(size_t index) const -> const Recloser&;
+
     auto getVoltage(size_t index) const -> float;
     auto getCurrent(size_t index) const -> float;
+    auto getPower(size_t index) const -> float;
+
+    // Fault checks and reported readings are filtered independently
+    void setFilter(size_t index, FilterTarget target, const Filter::Settings& settings);
+    auto getFilter(size_t index, FilterTarget target) const -> const Filter::Settings&;
+
+    // Drops to the next lower speed by itself if a sweep sees repeated bus errors
+    void setBusSpeed(I2cBus::Speed speed);
+    auto getBusSpeed() const -> I2cBus::Speed;
+
+    auto getAccumulator(size_t index) const -> const Accumulator&;
+    void resetAccumulator(size_t index);
+
+    auto armCapture(size_t index, uint8_t triggerMask, float threshold) -> Result<>;
+    auto disarmCapture() -> Result<>;
+    auto getCapture() const -> const Capture&;
+
+    // Leaves the relay switched off, results are kept until the next run on the channel
+    auto startCharacterization(size_t index) -> Result<>;
+    auto getCharacterizer() const -> const Characterizer&;
+    auto getSwitchTiming(size_t index) const -> const Characterizer::Timing&;
 
     void setVoltageLimit(size_t index, float voltage);
     auto getVoltageLimit(size_t index) const -> float;
@@ -84,14 +126,25 @@ public:
     void setCurrentLimit(size_t index, float current);
     auto getCurrentLimit(size_t index) const -> float;
 
-    void saveLimits();
+    auto saveLimits() -> Result<>;
 
 private:
     void update(size_t index);
+    void updateNextChannel();
+    void trip(size_t index, float voltage, float current, uint64_t timestamp);
+    void checkBusErrors();
+    void reclose(size_t index, uint64_t timestamp);
+    void updateCapture(size_t index, uint64_t timestamp);
+
+    // Returns true once a conversion has been handled or the poll failed
+    auto updateCharacterization() -> bool;
+    auto checkCharacterizedChannel(size_t index, float current, uint64_t timestamp) -> bool;
 
     void setFaultMask(uint16_t mask);
     void setFault(size_t index, RelayFault fault);
 
+    void resetFilters(size_t index);
+
     static auto port(size_t index) -> GPIO_TypeDef*;
     static auto pin(size_t index) -> uint16_t;
 
@@ -119,8 +172,37 @@ private:
         { Config::PowerMonitorHandle, Ina226::Address::A15 }
     }};
 
+    // Switched only after the power monitors have been configured at the reset speed
+    I2cBus m_bus = { Config::PowerMonitorHandle, Config::PowerMonitorBusSpeed };
+    int m_busErrorCount = 0;
+
     std::array<float, RelayCount> m_voltages = {};
     std::array<float, RelayCount> m_currents = {};
+    std::array<float, RelayCount> m_powers = {};
+
+    struct ChannelFilters
+    {
+        Filter faultVoltage;
+        Filter faultCurrent;
+        Filter reportVoltage;
+        Filter reportCurrent;
+    };
+
+    std::array<ChannelFilters, RelayCount> m_filters = {};
+
+    std::array<Recloser, RelayCount> m_reclosers = {};
+
+    std::array<Accumulator, RelayCount> m_accumulators = {};
+
+    Capture m_capture;
+    bool m_fastSampling = false;
+
+    Characterizer m_characterizer;
+    bool m_characterizerSampling = false;
+    uint64_t m_conversionPollTime = 0;
+    std::array<Characterizer::Timing, RelayCount> m_switchTimings = {};
+
+    bool m_interleaveTurn = false;
 
     std::array<float, RelayCount> m_voltageLimits = {};
     std::array<float, RelayCount> m_currentLimits = {};
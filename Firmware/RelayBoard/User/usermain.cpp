@@ -9,6 +9,7 @@
  *                                                      *
  ********************************************************/
 
+#include "deviceclock.h"
 #include "main.h"
 #include "relayboard.h"
 #include "usermain.h"
@@ -36,6 +37,8 @@ void user_main()
 {
     HAL_Delay(100); // Wait for isolated power to start up
 
+    DeviceClock::init();
+
     RelayBoard* relay = new (g_relayBuffer.data()) RelayBoard();
     relay->exec();
 }
@@ -21,15 +21,19 @@
 //                                                                                                //
 // ============================================================================================== //
 
+#include "assert.h"
+#include "crc32.h"
 #include "userpage.h"
 
+#include <cstddef>
+
 // ---------------------------------------------------------------------------------------------- //
 
 namespace {
     constexpr float MaximumVoltageLimit = RelayManager::MaximumVoltageLimit;
     constexpr float MaximumCurrentLimit = RelayManager::MaximumCurrentLimit;
 
-    UserPage::Data g_data __attribute__((section(".userpage"))) =
+    constexpr UserPage::Data DefaultData =
     {
         {
             MaximumVoltageLimit, MaximumVoltageLimit, MaximumVoltageLimit, MaximumVoltageLimit,
@@ -44,56 +48,246 @@ namespace {
             MaximumCurrentLimit, MaximumCurrentLimit, MaximumCurrentLimit, MaximumCurrentLimit
         }
     };
-}
 
-// ---------------------------------------------------------------------------------------------- //
+    constexpr size_t PageSize = 2048;
+    constexpr uint64_t ErasedWord = 0xffffffffffffffff;
+    constexpr uint32_t CrcInitializer = 0xffffffff;
 
-void UserPage::setData(const Data& data)
-{
-    static_assert(sizeof(data) % sizeof(uint64_t) == 0);
+    // Key 0 holds the limits in use, keys 1 to ProfileCount the stored profiles
+    constexpr uint32_t DataKey = 0;
+    constexpr size_t KeyCount = UserPage::ProfileCount + 1;
 
-    HAL_FLASH_Unlock();
+    // Records are appended in order, the last valid one of each key holds the current data
+    struct Record
+    {
+        uint32_t sequence;
+        uint32_t checksum;
+        uint32_t key;
+        UserPage::Profile profile;
+    };
 
-    FLASH_EraseInitTypeDef eraseInit = {};
-    uint32_t sectorError = 0;
+    static_assert(sizeof(Record) % sizeof(uint64_t) == 0);
 
-    eraseInit.TypeErase    = FLASH_TYPEERASE_PAGES;
-    eraseInit.Banks        = FLASH_BANK_1;
-    eraseInit.Page         = Config::UserPage;
-    eraseInit.NbPages      = 1;
+    constexpr size_t RecordCount = PageSize / sizeof(Record);
+    constexpr size_t WordCount = sizeof(Record) / sizeof(uint64_t);
 
-    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&eraseInit, &sectorError);
+    static_assert(RecordCount > KeyCount);
 
-    if (status != HAL_OK)
+    constexpr auto makeErasedPage()
     {
-        HAL_FLASH_Lock();
-        throw EraseError();
+        std::array<uint64_t, PageSize / sizeof(uint64_t)> page = {};
+        page.fill(ErasedWord);
+        return page;
+    }
+
+    // Shipped erased so a freshly flashed board starts with default limits
+    std::array<uint64_t, PageSize / sizeof(uint64_t)> g_page __attribute__((section(".userpage")))
+        = makeErasedPage();
+
+    std::array<const Record*, KeyCount> g_latest = {};
+    size_t g_nextSlot = 0;
+    uint32_t g_nextSequence = 0;
+    bool g_scanned = false;
+
+    // Latest record of each key while the page is erased. Records that could not be written
+    // back stay in use from here until a later compaction succeeds.
+    std::array<Record, KeyCount> g_compactionBuffer;
+    bool g_compactionFailed = false;
+
+    auto recordAt(size_t slot) -> const Record*
+    {
+        return reinterpret_cast<const Record*>(g_page.data()) + slot;
     }
 
-    const auto buffer = reinterpret_cast<const uint64_t*>(&data);
-    const auto flashStart = reinterpret_cast<uint32_t>(&g_data);
+    auto isErased(size_t slot) -> bool
+    {
+        return *reinterpret_cast<const volatile uint64_t*>(recordAt(slot)) == ErasedWord;
+    }
 
-    const size_t wordCount = sizeof(data) / sizeof(uint64_t);
+    auto computeChecksum(const Record& record) -> uint32_t
+    {
+        // Everything but the checksum itself
+        const auto sequence = reinterpret_cast<const uint8_t*>(&record.sequence);
+        const auto key = reinterpret_cast<const uint8_t*>(&record.key);
 
-    for (size_t i = 0; i < wordCount; ++i)
+        uint32_t crc = crc32_update_buffer(CrcInitializer, sequence, sizeof(record.sequence));
+        return crc32_update_buffer(crc, key, sizeof(Record) - offsetof(Record, key));
+    }
+
+    auto isValid(const Record& record) -> bool
     {
-        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD,
-                                   flashStart + i*sizeof(uint64_t), buffer[i]);
+        return record.key < KeyCount && record.checksum == computeChecksum(record);
+    }
+
+    void scanPage()
+    {
+        // Free slots only ever follow used ones, a torn record is skipped but not reused
+        for (g_nextSlot = 0; g_nextSlot < RecordCount && !isErased(g_nextSlot); ++g_nextSlot)
+        {
+            const Record* record = recordAt(g_nextSlot);
+
+            if (isValid(*record))
+            {
+                g_latest[record->key] = record;
+                g_nextSequence = record->sequence + 1;
+            }
+        }
+
+        g_scanned = true;
+    }
+
+    auto program(const Record& record) -> Result<>
+    {
+        const size_t slot = g_nextSlot++;
+
+        const auto buffer = reinterpret_cast<const uint64_t*>(&record);
+        const auto flashStart = reinterpret_cast<uintptr_t>(recordAt(slot));
+
+        for (size_t i = 0; i < WordCount; ++i)
+        {
+            const HAL_StatusTypeDef status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD,
+                                                               flashStart + i*sizeof(uint64_t),
+                                                               buffer[i]);
+            if (status != HAL_OK)
+            {
+                // A slot left erased would end the scan and hide the records after it
+                if (isErased(slot))
+                    HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, flashStart, 0);
+
+                return UserPage::WriteError;
+            }
+        }
+
+        if (!isValid(*recordAt(slot)))
+            return UserPage::WriteError;
+
+        g_latest[record.key] = recordAt(slot);
+
+        return {};
+    }
+
+    auto compact(const Record& record) -> Result<>
+    {
+        for (uint32_t key = 0; key < KeyCount; ++key)
+        {
+            Record& buffered = g_compactionBuffer[key];
+
+            if (key == record.key)
+                buffered = record;
+            else if (!g_latest[key])
+                continue;
+            else if (g_latest[key] != &buffered)
+                buffered = *g_latest[key];
+
+            g_latest[key] = &buffered;
+        }
+
+        FLASH_EraseInitTypeDef eraseInit = {};
+        uint32_t sectorError = 0;
+
+        eraseInit.TypeErase    = FLASH_TYPEERASE_PAGES;
+        eraseInit.Banks        = FLASH_BANK_1;
+        eraseInit.Page         = Config::UserPage;
+        eraseInit.NbPages      = 1;
+
+        const HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&eraseInit, &sectorError);
+
+        g_nextSlot = 0;
+
         if (status != HAL_OK)
-            break;
+        {
+            g_compactionFailed = true;
+            return UserPage::EraseError;
+        }
+
+        // Limits in effect come first to keep them at risk for as short as possible, and a
+        // failed record does not keep the others from being written back
+        Result<> result;
+
+        for (uint32_t key = 0; key < KeyCount; ++key)
+        {
+            if (!g_latest[key])
+                continue;
+
+            if (auto written = program(g_compactionBuffer[key]); !written)
+                result = written;
+        }
+
+        g_compactionFailed = !result;
+
+        return result;
     }
 
-    HAL_FLASH_Lock();
+    auto append(uint32_t key, const UserPage::Profile& profile) -> Result<>
+    {
+        if (!g_scanned)
+            scanPage();
+
+        Record record = {};
+        record.sequence = g_nextSequence++;
+        record.key = key;
+        record.profile = profile;
+        record.checksum = computeChecksum(record);
+
+        HAL_FLASH_Unlock();
 
-    if (status != HAL_OK)
-        throw WriteError();
+        Result<> result;
+
+        // The page is only erased once every slot has been used, or again after a compaction
+        // that left records in RAM
+        if (g_nextSlot >= RecordCount || g_compactionFailed)
+            result = compact(record);
+        else
+            result = program(record);
+
+        HAL_FLASH_Lock();
+
+        return result;
+    }
+
+    auto latest(uint32_t key) -> const Record*
+    {
+        if (!g_scanned)
+            scanPage();
+
+        return g_latest[key];
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto UserPage::setData(const Data& data) -> Result<>
+{
+    Profile profile = {};
+    profile.data = data;
+
+    return append(DataKey, profile);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 auto UserPage::data() -> const Data&
 {
-    return g_data;
+    const Record* record = latest(DataKey);
+    return record ? record->profile.data : DefaultData;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto UserPage::setProfile(size_t index, const Profile& profile) -> Result<>
+{
+    ASSERT(index < ProfileCount);
+    return append(index + 1, profile);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto UserPage::profile(size_t index) -> const Profile*
+{
+    ASSERT(index < ProfileCount);
+
+    const Record* record = latest(index + 1);
+    return record ? &record->profile : nullptr;
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -24,6 +24,7 @@
 #pragma once
 
 #include "relaymanager.h"
+#include "result.h"
 
 #include <array>
 
@@ -38,28 +39,26 @@ public:
         std::array<float, RelayManager::RelayCount> currentLimits;
     };
 
-    class EraseError;
-    class WriteError;
+    static constexpr size_t ProfileCount = 4;
+    static constexpr size_t MaximumNameLength = 11;
 
-public:
-    static void setData(const Data& data);
-    static auto data() -> const Data&;
-};
+    using Name = std::array<char, MaximumNameLength + 1>;
 
-// ---------------------------------------------------------------------------------------------- //
-
-class UserPage::EraseError : public std::exception
-{
-public:
-    auto what() const noexcept -> const char* { return "ERASE_FAILED"; }
-};
+    struct Profile
+    {
+        Name name;
+        Data data;
+    };
 
-// ---------------------------------------------------------------------------------------------- //
+    static constexpr Error EraseError = Error("ERASE_FAILED");
+    static constexpr Error WriteError = Error("WRITE_FAILED");
 
-class UserPage::WriteError : public std::exception
-{
 public:
-    auto what() const noexcept -> const char* { return "WRITE_FAILED"; }
+    static auto setData(const Data& data) -> Result<>;
+    static auto data() -> const Data&;
+
+    static auto setProfile(size_t index, const Profile& profile) -> Result<>;
+    static auto profile(size_t index) -> const Profile*;
 };
 
 // ---------------------------------------------------------------------------------------------- //
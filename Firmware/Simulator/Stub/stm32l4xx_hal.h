@@ -0,0 +1,236 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+// Minimal replacement for the STM32L4 HAL, covering what RelayBoard/User and Bootloader/User use
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    HAL_OK      = 0x00,
+    HAL_ERROR   = 0x01,
+    HAL_BUSY    = 0x02,
+    HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+extern uint32_t SystemCoreClock;
+
+void HAL_Delay(uint32_t delay);
+uint32_t HAL_GetTick(void);
+void HAL_NVIC_SystemReset(void);
+
+// The bootloader only sets the stack pointer right before jumping to the firmware
+static inline void __set_MSP(uint32_t topOfMainStack) { (void) topOfMainStack; }
+
+// Core debug and cycle counter
+
+typedef struct
+{
+    uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct
+{
+    uint32_t CTRL;
+    uint32_t CYCCNT;
+} DWT_Type;
+
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk     (1UL << 0)
+
+// CYCCNT is refreshed from the host clock on every access
+CoreDebug_Type* sim_core_debug(void);
+DWT_Type* sim_dwt(void);
+
+#define CoreDebug (sim_core_debug())
+#define DWT       (sim_dwt())
+
+// GPIO
+
+typedef struct
+{
+    uint32_t index;
+} GPIO_TypeDef;
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+extern GPIO_TypeDef sim_gpio_ports[3];
+
+#define GPIOA (&sim_gpio_ports[0])
+#define GPIOB (&sim_gpio_ports[1])
+#define GPIOC (&sim_gpio_ports[2])
+
+#define GPIO_PIN_0  ((uint16_t)0x0001)
+#define GPIO_PIN_1  ((uint16_t)0x0002)
+#define GPIO_PIN_2  ((uint16_t)0x0004)
+#define GPIO_PIN_3  ((uint16_t)0x0008)
+#define GPIO_PIN_4  ((uint16_t)0x0010)
+#define GPIO_PIN_5  ((uint16_t)0x0020)
+#define GPIO_PIN_6  ((uint16_t)0x0040)
+#define GPIO_PIN_7  ((uint16_t)0x0080)
+#define GPIO_PIN_8  ((uint16_t)0x0100)
+#define GPIO_PIN_9  ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin);
+
+// I2C
+
+typedef struct
+{
+    uint32_t CR1;
+    uint32_t TIMINGR;
+} I2C_TypeDef;
+
+typedef struct
+{
+    uint32_t Timing;
+} I2C_InitTypeDef;
+
+typedef struct
+{
+    I2C_TypeDef* Instance;
+    I2C_InitTypeDef Init;
+} I2C_HandleTypeDef;
+
+#define I2C_CR1_PE (1UL << 0)
+
+#define __HAL_I2C_ENABLE(handle)  ((handle)->Instance->CR1 |= I2C_CR1_PE)
+#define __HAL_I2C_DISABLE(handle) ((handle)->Instance->CR1 &= ~I2C_CR1_PE)
+
+#define I2C_MEMADD_SIZE_8BIT  0x00000001U
+#define I2C_MEMADD_SIZE_16BIT 0x00000002U
+
+#define I2C_FASTMODEPLUS_I2C1 (1UL << 20)
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef* handle, uint16_t address,
+                                    uint16_t memAddress, uint16_t memAddressSize,
+                                    uint8_t* data, uint16_t size, uint32_t timeout);
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef* handle, uint16_t address,
+                                   uint16_t memAddress, uint16_t memAddressSize,
+                                   uint8_t* data, uint16_t size, uint32_t timeout);
+
+void HAL_I2CEx_EnableFastModePlus(uint32_t config);
+void HAL_I2CEx_DisableFastModePlus(uint32_t config);
+
+// Flash
+
+#define FLASH_BASE      0x08000000UL
+#define FLASH_SIZE      0x00020000UL
+#define FLASH_PAGE_SIZE 0x00000800UL
+
+#define FLASH_BANK_1 0x00000001U
+
+#define FLASH_TYPEERASE_PAGES 0x00000000U
+#define FLASH_TYPEERASE_MASSERASE 0x00000001U
+
+#define FLASH_TYPEPROGRAM_DOUBLEWORD 0x00000000U
+
+typedef struct
+{
+    uint32_t TypeErase;
+    uint32_t Banks;
+    uint32_t Page;
+    uint32_t NbPages;
+} FLASH_EraseInitTypeDef;
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t typeProgram, uint32_t address, uint64_t data);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef* eraseInit, uint32_t* pageError);
+
+#ifdef __cplusplus
+} // "C"
+#endif
+
+// CRC unit, modelled by VirtualCrc. DR and CR act on every access, so they cannot be plain fields
+// and the unit is only available to C++. Data is written as 32-bit words with a 32-bit polynomial.
+
+#ifdef __cplusplus
+
+#define CRC_CR_RESET    (1UL << 0)
+#define CRC_CR_REV_IN_0 (1UL << 5)
+#define CRC_CR_REV_IN_1 (1UL << 6)
+#define CRC_CR_REV_IN   (CRC_CR_REV_IN_0 | CRC_CR_REV_IN_1)
+#define CRC_CR_REV_OUT  (1UL << 7)
+
+struct CRC_TypeDef
+{
+    struct DataRegister
+    {
+        auto operator=(uint32_t value) -> DataRegister&;
+        operator uint32_t() const;
+    };
+
+    struct ControlRegister
+    {
+        auto operator=(uint32_t value) -> ControlRegister&;
+        operator uint32_t() const;
+    };
+
+    DataRegister DR;
+    ControlRegister CR;
+    uint32_t INIT;
+    uint32_t POL;
+};
+
+// main.h may include the HAL from within an extern "C" block
+extern "C" auto sim_crc() -> CRC_TypeDef*;
+extern "C" void sim_crc_set_clock(bool enabled);
+
+#define CRC (sim_crc())
+
+#define __HAL_RCC_CRC_CLK_ENABLE()  sim_crc_set_clock(true)
+#define __HAL_RCC_CRC_CLK_DISABLE() sim_crc_set_clock(false)
+
+static inline auto __RBIT(uint32_t value) -> uint32_t
+{
+    uint32_t result = 0;
+
+    for (int i = 0; i < 32; ++i, value >>= 1)
+        result = (result << 1) | (value & 1);
+
+    return result;
+}
+
+#endif
@@ -0,0 +1,45 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+// USB CDC interface of RelayBoard/USB_DEVICE, backed by a pseudo-terminal. Like the
+// generated header it pulls in the HAL.
+
+#include "stm32l4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint8_t CDC_Transmit(uint8_t* buffer, uint16_t size);
+
+typedef void (*CDC_ReceiveCallback)(uint8_t *buffer, uint32_t size);
+void CDC_RegisterReceiveCallback(CDC_ReceiveCallback callback);
+
+typedef void (*CDC_TxCompleteCallback)(void);
+void CDC_RegisterTxCompleteCallback(CDC_TxCompleteCallback callback);
+
+#ifdef __cplusplus
+} // "C"
+#endif
@@ -0,0 +1,50 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+// Device descriptors of RelayBoard/USB_DEVICE, only the serial number string is provided
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    USBD_SPEED_HIGH = 0,
+    USBD_SPEED_FULL = 1,
+    USBD_SPEED_LOW  = 2
+} USBD_SpeedTypeDef;
+
+typedef struct
+{
+    uint8_t* (*GetSerialStrDescriptor)(USBD_SpeedTypeDef speed, uint16_t* length);
+} USBD_DescriptorsTypeDef;
+
+extern USBD_DescriptorsTypeDef FS_Desc;
+
+#ifdef __cplusplus
+} // "C"
+#endif
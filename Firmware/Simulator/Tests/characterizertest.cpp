@@ -0,0 +1,187 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+// Switching times the characterizer derives from current samples of a relay that ramps
+// linearly, taken at the rate and with the time stamps the relay manager uses.
+
+#include "characterizer.h"
+#include "check.h"
+
+#include <cstdlib>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr float LoadCurrent = 0.5F; // A
+
+    struct Relay
+    {
+        uint32_t onDelay;  // us
+        uint32_t offDelay; // us
+        uint32_t riseTime; // us, same for both edges
+    };
+
+    // Fraction of the step reached at the given time after the GPIO write
+    auto rampFraction(const Relay& relay, uint32_t delay, int64_t time) -> float
+    {
+        const int64_t elapsed = time - delay;
+
+        if (elapsed <= 0)
+            return 0.0F;
+
+        if (elapsed >= static_cast<int64_t>(relay.riseTime))
+            return 1.0F;
+
+        return static_cast<float>(elapsed) / static_cast<float>(relay.riseTime);
+    }
+
+    // Runs a whole characterization, a sample is taken every interval and stamped with the
+    // middle of its conversion, offset shifts the samples against the switching
+    auto characterize(const Relay& relay, float load, uint32_t interval,
+                      uint32_t offset) -> Characterizer
+    {
+        Characterizer characterizer;
+
+        uint64_t time = 1000000;
+        characterizer.start(0, time);
+
+        bool on = false;
+        uint64_t switchTime = 0;
+
+        while (characterizer.isRunning())
+        {
+            time += interval;
+
+            const uint64_t stamp = time - interval / 2 - offset;
+            const auto elapsed = static_cast<int64_t>(stamp - switchTime);
+
+            float current = 0.0F;
+
+            if (switchTime != 0)
+            {
+                current = on ? rampFraction(relay, relay.onDelay, elapsed)
+                             : 1.0F - rampFraction(relay, relay.offDelay, elapsed);
+            }
+
+            characterizer.addSample(stamp, current * load);
+
+            switch (characterizer.poll(time))
+            {
+            case Characterizer::Action::SwitchOn:
+                on = true;
+                switchTime = time;
+                break;
+
+            case Characterizer::Action::SwitchOff:
+                on = false;
+                switchTime = time;
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        return characterizer;
+    }
+
+    auto isNear(uint32_t value, uint32_t expected, uint32_t tolerance) -> bool
+    {
+        return static_cast<uint32_t>(std::abs(static_cast<int64_t>(value) - expected))
+                    <= tolerance;
+    }
+
+    void checkTiming(const Relay& relay, uint32_t interval, uint32_t offset)
+    {
+        const Characterizer characterizer = characterize(relay, LoadCurrent, interval, offset);
+        CHECK(characterizer.state() == Characterizer::State::Complete);
+
+        const Characterizer::Timing& timing = characterizer.timing();
+        CHECK(timing.valid);
+        CHECK(timing.resolution == interval);
+
+        // Both samples around the half-way point lie on the ramp, so the delay is exact
+        CHECK(isNear(timing.onDelay, relay.onDelay + relay.riseTime / 2, 2));
+        CHECK(isNear(timing.offDelay, relay.offDelay + relay.riseTime / 2, 2));
+
+        // Settling interpolates across the end of the ramp, within one sample interval
+        const uint32_t settling = relay.riseTime - relay.riseTime * 5 / 100;
+        CHECK(isNear(timing.onSettling, relay.onDelay + settling, timing.resolution));
+        CHECK(isNear(timing.offSettling, relay.offDelay + settling, timing.resolution));
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testTiming()
+{
+    const Relay relay = { 2000, 1000, 1200 };
+
+    // Fastest and fast sampling, at different phases against the switching
+    for (uint32_t offset = 0; offset < 280; offset += 35)
+        checkTiming(relay, 280, offset);
+
+    for (uint32_t offset = 0; offset < 664; offset += 83)
+        checkTiming(relay, 664, offset);
+
+    // Slow relay with a longer ramp
+    checkTiming({ 8000, 4000, 3000 }, 280, 100);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testNoLoad()
+{
+    const Relay relay = { 2000, 1000, 1200 };
+
+    const Characterizer characterizer = characterize(relay, 0.0F, 280, 0);
+    CHECK(characterizer.state() == Characterizer::State::Failed);
+    CHECK(!characterizer.timing().valid);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testAbort()
+{
+    Characterizer characterizer;
+    characterizer.start(3, 0);
+    CHECK(characterizer.isRunning());
+    CHECK(!characterizer.isMeasuring());
+
+    characterizer.abort();
+    CHECK(characterizer.state() == Characterizer::State::Failed);
+    CHECK(characterizer.channel() == 3);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main() -> int
+{
+    testTiming();
+    testNoLoad();
+    testAbort();
+
+    return failures();
+}
+
+// ---------------------------------------------------------------------------------------------- //
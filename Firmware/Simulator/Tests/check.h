@@ -0,0 +1,44 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <cstdio>
+
+// Checks keep going after a failure so that a single run lists every broken case, main()
+// returns failures() to let CTest pick up the result
+inline int g_failedChecks = 0;
+
+#define CHECK(condition) \
+    do { if (!(condition)) checkFailed(#condition, __FILE__, __LINE__); } while (false)
+
+inline void checkFailed(const char* condition, const char* file, int line)
+{
+    std::fprintf(stderr, "%s:%d: Check failed: %s\n", file, line, condition);
+    ++g_failedChecks;
+}
+
+inline auto failures() -> int
+{
+    return g_failedChecks > 0 ? 1 : 0;
+}
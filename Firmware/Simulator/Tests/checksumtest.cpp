@@ -0,0 +1,259 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+// Image checksum the programmer keeps while writing, which must match the checksum of the
+// image as sent no matter how the sectors are erased and in which order blocks arrive. The
+// checksum itself is computed with the modelled CRC unit and must match the table in crc32.c.
+
+#include "check.h"
+#include "checksum.h"
+#include "config.h"
+#include "crc32.h"
+#include "programmer.h"
+#include "virtualcrc.h"
+#include "virtualflash.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr uint32_t ImageSize = Config::FirmwareEndAddress - Config::FirmwareStartAddress;
+
+    // Placed at FLASH_BASE by the linker like in the bootloader simulator
+    std::array<uint64_t, FLASH_SIZE / sizeof(uint64_t)> g_flash __attribute__((section(".flash")));
+
+    std::minstd_rand g_random;
+
+    // Firmware of the given size padded with 0xFF up to the checksum like the erased flash
+    auto createImage(size_t size) -> std::vector<uint8_t>
+    {
+        std::uniform_int_distribution<unsigned int> distribution(0, 255);
+
+        std::vector<uint8_t> image(ImageSize, 0xff);
+
+        for (size_t i = 0; i < size; ++i)
+            image[i] = static_cast<uint8_t>(distribution(g_random));
+
+        return image;
+    }
+
+    auto imageChecksum(const std::vector<uint8_t>& image) -> uint32_t
+    {
+        return Checksum::compute(image.data(), static_cast<uint32_t>(image.size()));
+    }
+
+    auto writeImage(Programmer& programmer, const std::vector<uint8_t>& image, size_t size,
+                    size_t blockSize, bool descending = false) -> bool
+    {
+        const size_t count = (size + blockSize - 1) / blockSize;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const size_t index = descending ? count - 1 - i : i;
+            const size_t offset = index * blockSize;
+            const size_t length = std::min(blockSize, size - offset);
+
+            const auto address = static_cast<uint32_t>(Config::FirmwareStartAddress + offset);
+
+            if (!programmer.writeBlock(address, image.data() + offset, length))
+                return false;
+        }
+
+        return true;
+    }
+
+    auto finish(Programmer& programmer) -> bool
+    {
+        const auto record = HexRecord::fromString(":00000001FF");
+        return record && programmer.processRecord(record.value());
+    }
+
+    void eraseFlash()
+    {
+        g_flash.fill(0xffffffffffffffff);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testAscending()
+{
+    eraseFlash();
+
+    const std::vector<uint8_t> image = createImage(20000);
+
+    Programmer programmer;
+    CHECK(writeImage(programmer, image, 20000, Config::SectorSize));
+    CHECK(finish(programmer));
+
+    CHECK(Checksum::read() == imageChecksum(image));
+    CHECK(Checksum::verify());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testUserPageErased()
+{
+    eraseFlash();
+
+    const std::vector<uint8_t> image = createImage(12345);
+
+    // Clearing the user page before the image must not drop the running checksum, which is
+    // the only one catching a cell that flips after it was read back
+    Programmer programmer;
+    CHECK(programmer.eraseSector(0));
+    CHECK(writeImage(programmer, image, 12345, 1024));
+
+    CHECK(VirtualFlash::corrupt(Config::FirmwareStartAddress + 100, 3));
+    CHECK(finish(programmer));
+
+    CHECK(Checksum::read() == imageChecksum(image));
+    CHECK(!Checksum::verify());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testKeptSectors()
+{
+    eraseFlash();
+
+    constexpr size_t Size = 30000;
+    std::vector<uint8_t> image = createImage(Size);
+
+    {
+        Programmer programmer;
+        CHECK(writeImage(programmer, image, Size, Config::SectorSize));
+        CHECK(finish(programmer));
+    }
+
+    // Delta update writing every other block only, the gaps are summed up from the flash
+    for (size_t i = 0; i < Size; i += 2*Config::SectorSize)
+        image[i] ^= 0x5a;
+
+    Programmer programmer;
+
+    for (size_t offset = 0; offset < Size; offset += 2*Config::SectorSize)
+    {
+        const auto address = static_cast<uint32_t>(Config::FirmwareStartAddress + offset);
+        const size_t length = std::min<size_t>(Config::SectorSize, Size - offset);
+
+        CHECK(programmer.writeBlock(address, image.data() + offset, length));
+    }
+
+    // Sectors past the image still hold the old checksum, the image starts in sector 1
+    CHECK(programmer.eraseTail(1 + (Size + Config::SectorSize - 1) / Config::SectorSize));
+    CHECK(finish(programmer));
+
+    CHECK(Checksum::read() == imageChecksum(image));
+    CHECK(Checksum::verify());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testOutOfOrder()
+{
+    eraseFlash();
+
+    const std::vector<uint8_t> image = createImage(16000);
+
+    Programmer programmer;
+    CHECK(writeImage(programmer, image, 16000, 512, true));
+    CHECK(finish(programmer));
+
+    CHECK(Checksum::read() == Checksum::compute());
+    CHECK(Checksum::read() == imageChecksum(image));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testSummedSectorErased()
+{
+    eraseFlash();
+
+    const std::vector<uint8_t> image = createImage(8000);
+
+    // Erasing data already summed up leaves only the flash to compute the checksum from
+    Programmer programmer;
+    CHECK(writeImage(programmer, image, 8000, Config::SectorSize));
+    CHECK(programmer.eraseSector(2));
+    CHECK(finish(programmer));
+
+    CHECK(Checksum::read() == Checksum::compute());
+    CHECK(Checksum::read() != imageChecksum(image));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testCrcUnit()
+{
+    const std::vector<uint8_t> data = createImage(256);
+
+    std::uniform_int_distribution<uint32_t> distribution;
+
+    // Every alignment of both ends, with and without whole words left for the CRC unit
+    for (uint32_t offset = 0; offset < 8; ++offset)
+    {
+        for (uint32_t length = 0; length <= 40; ++length)
+        {
+            const uint32_t crc = (length % 2 == 0) ? 0 : distribution(g_random);
+            const uint64_t words = VirtualCrc::wordCount();
+
+            CHECK(Checksum::update(crc, data.data() + offset, length) ==
+                  crc32_update_buffer(crc, data.data() + offset, length));
+
+            const auto misalignment = reinterpret_cast<uintptr_t>(data.data() + offset) % 4;
+            const uint32_t head = (misalignment != 0) ? 4 - misalignment : 0;
+            const uint32_t expectedWords = (length > head) ? (length - head) / 4 : 0;
+
+            CHECK(VirtualCrc::wordCount() - words == expectedWords);
+            CHECK(!VirtualCrc::isClockEnabled());
+        }
+    }
+
+    CHECK(Checksum::compute(data.data() + 1, 255) == crc32_update_buffer(0, data.data() + 1, 255));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main() -> int
+{
+    eraseFlash();
+
+    const uint32_t regionAddress = Programmer::sectorAddress(0);
+    VirtualFlash::addRegion(regionAddress, Config::FirmwareSectorCount * Config::SectorSize);
+
+    testAscending();
+    testUserPageErased();
+    testKeptSectors();
+    testOutOfOrder();
+    testSummedSectorErased();
+    testCrcUnit();
+
+    return failures();
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,172 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+// Round trip of blocks packed by libIRB for WRITE_PACKED_BLOCK through the decoder of the
+// bootloader, which must restore every block exactly and refuse damaged ones.
+
+#include "check.h"
+#include "lzss.h"
+#include "lzssencoder.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using irb::Private::LzssEncoder;
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    std::minstd_rand g_random;
+
+    auto randomBytes(size_t size, unsigned int range) -> std::vector<uint8_t>
+    {
+        std::uniform_int_distribution<unsigned int> distribution(0, range - 1);
+
+        std::vector<uint8_t> data(size);
+
+        for (uint8_t& byte : data)
+            byte = static_cast<uint8_t>(distribution(g_random));
+
+        return data;
+    }
+
+    void checkRoundTrip(const std::vector<uint8_t>& data)
+    {
+        const std::vector<uint8_t> packed = LzssEncoder::encode(data);
+
+        std::vector<uint8_t> unpacked(data.size());
+        const auto result = Lzss::decode(packed.data(), packed.size(),
+                                         unpacked.data(), unpacked.size());
+        CHECK(result);
+
+        if (result)
+        {
+            CHECK(result.value() == data.size());
+            CHECK(unpacked == data);
+        }
+    }
+
+    void checkTruncated(const std::vector<uint8_t>& data)
+    {
+        const std::vector<uint8_t> packed = LzssEncoder::encode(data);
+
+        for (size_t size = 0; size < packed.size(); ++size)
+        {
+            std::vector<uint8_t> unpacked(data.size());
+            const auto result = Lzss::decode(packed.data(), size, unpacked.data(), unpacked.size());
+
+            // Cut between two items the output is merely short, which the size check catches
+            CHECK(!result || result.value() < data.size());
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testRoundTrip()
+{
+    checkRoundTrip({ 0x42 });
+    checkRoundTrip({ 1, 2 });
+    checkRoundTrip({ 1, 2, 3 });
+
+    checkRoundTrip(std::vector<uint8_t>(2048, 0x00));
+    checkRoundTrip(std::vector<uint8_t>(2048, 0xff));
+
+    // Maximum block size, every reference distance may occur
+    checkRoundTrip(randomBytes(2048, 256));
+    checkRoundTrip(randomBytes(2048, 4));
+
+    for (size_t size = 1; size <= 300; size += 7)
+        checkRoundTrip(randomBytes(size, 3));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testRepetitive()
+{
+    // Period shorter than the match, so references overlap the bytes they produce
+    for (size_t period = 1; period <= 40; ++period)
+    {
+        std::vector<uint8_t> data(1024);
+
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<uint8_t>(i % period);
+
+        checkRoundTrip(data);
+    }
+
+    // Same pattern repeated at the far end of the window
+    std::vector<uint8_t> data = randomBytes(2048, 256);
+    std::copy(data.begin(), data.begin() + 64, data.end() - 64);
+    checkRoundTrip(data);
+
+    // Short matches with literals in between
+    const std::vector<uint8_t> text = { 'a', 'b', 'c', 'x', 'a', 'b', 'c', 'y', 'a', 'b', 'c',
+                                        'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b', 'c', 'z' };
+    checkRoundTrip(text);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testCompression()
+{
+    const std::vector<uint8_t> zeros(2048, 0x00);
+    CHECK(LzssEncoder::encode(zeros).size() < zeros.size() / 8);
+
+    // Incompressible data grows by one flag byte per eight literals
+    const std::vector<uint8_t> noise = randomBytes(2048, 256);
+    CHECK(LzssEncoder::encode(noise).size() <= noise.size() + (noise.size() + 7) / 8);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testInvalidData()
+{
+    checkTruncated(randomBytes(512, 256));
+    checkTruncated(randomBytes(512, 2));
+
+    // Reference into data not written yet
+    const std::vector<uint8_t> early = { 0x00, 0x00, 0x00 };
+    std::vector<uint8_t> unpacked(16);
+    CHECK(!Lzss::decode(early.data(), early.size(), unpacked.data(), unpacked.size()));
+
+    // Output larger than the target
+    const std::vector<uint8_t> data(64, 0x55);
+    const std::vector<uint8_t> packed = LzssEncoder::encode(data);
+    CHECK(!Lzss::decode(packed.data(), packed.size(), unpacked.data(), unpacked.size()));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main() -> int
+{
+    testRoundTrip();
+    testRepetitive();
+    testCompression();
+    testInvalidData();
+
+    return failures();
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,224 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+// Reclose sequence of a single channel from the first trip to lockout, with the states that
+// GET_RECLOSE_STATUS reports.
+
+#include "check.h"
+#include "recloser.h"
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr uint64_t Millisecond = 1000; // us
+
+    auto createRecloser(uint8_t retryCount, uint32_t delay, uint8_t lockoutCount) -> Recloser
+    {
+        Recloser recloser;
+        recloser.configure({ retryCount, delay, lockoutCount });
+
+        return recloser;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testDisabled()
+{
+    Recloser recloser = createRecloser(0, 100, 0);
+
+    CHECK(!recloser.onTrip(0));
+    CHECK(!recloser.isPending());
+    CHECK(recloser.isExhausted());
+    CHECK(!recloser.isLockedOut());
+    CHECK(recloser.tripCount() == 1);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testRetries()
+{
+    Recloser recloser = createRecloser(2, 100, 0);
+
+    CHECK(!recloser.isPending());
+    CHECK(!recloser.isExhausted());
+
+    // First retry after the configured delay
+    CHECK(recloser.onTrip(0));
+    CHECK(recloser.isPending());
+    CHECK(!recloser.isExhausted());
+    CHECK(!recloser.isDue(100*Millisecond - 1));
+    CHECK(recloser.isDue(100*Millisecond));
+
+    recloser.onReclose(100*Millisecond);
+    CHECK(!recloser.isPending());
+    CHECK(!recloser.isDue(100*Millisecond));
+    CHECK(recloser.retryIndex() == 1);
+
+    // Second one waits twice as long
+    CHECK(recloser.onTrip(200*Millisecond));
+    CHECK(recloser.isPending());
+    CHECK(!recloser.isDue(400*Millisecond - 1));
+    CHECK(recloser.isDue(400*Millisecond));
+
+    recloser.onReclose(400*Millisecond);
+    CHECK(recloser.retryIndex() == 2);
+
+    // No retry left, the relay stays off
+    CHECK(!recloser.onTrip(500*Millisecond));
+    CHECK(!recloser.isPending());
+    CHECK(recloser.isExhausted());
+    CHECK(!recloser.isLockedOut());
+    CHECK(!recloser.isDue(UINT64_MAX));
+    CHECK(recloser.tripCount() == 3);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testMaximumDelay()
+{
+    Recloser recloser = createRecloser(3, Recloser::MaximumDelay, 0);
+
+    CHECK(recloser.onTrip(0));
+    recloser.onReclose(Recloser::MaximumDelay * Millisecond);
+
+    const uint64_t trip = 2 * Recloser::MaximumDelay * Millisecond;
+    CHECK(recloser.onTrip(trip));
+    CHECK(!recloser.isDue(trip + Recloser::MaximumDelay * Millisecond - 1));
+    CHECK(recloser.isDue(trip + Recloser::MaximumDelay * Millisecond));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testRecovery()
+{
+    Recloser recloser = createRecloser(1, 100, 0);
+
+    CHECK(recloser.onTrip(0));
+    recloser.onReclose(100*Millisecond);
+
+    // Tripping again too early uses up the only retry
+    CHECK(!recloser.onTrip(100*Millisecond + Recloser::RecoveryTime - 1));
+    CHECK(recloser.isExhausted());
+
+    // Switched on by the host and held long enough, the sequence starts over
+    CHECK(recloser.onTrip(100*Millisecond + Recloser::RecoveryTime));
+    CHECK(!recloser.isExhausted());
+    CHECK(recloser.isPending());
+    CHECK(recloser.retryIndex() == 0);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testLockout()
+{
+    Recloser recloser = createRecloser(5, 100, 3);
+
+    uint64_t time = 0;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        CHECK(recloser.onTrip(time));
+        CHECK(!recloser.isLockedOut());
+
+        time += 1000*Millisecond;
+        recloser.onReclose(time);
+    }
+
+    // Lockout takes precedence over the retries left
+    CHECK(!recloser.onTrip(time));
+    CHECK(recloser.isLockedOut());
+    CHECK(!recloser.isPending());
+    CHECK(!recloser.isExhausted());
+
+    // Stays locked out even once recovered
+    CHECK(!recloser.onTrip(time + Recloser::RecoveryTime));
+    CHECK(recloser.isLockedOut());
+    CHECK(recloser.tripCount() == 4);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testCancel()
+{
+    Recloser recloser = createRecloser(2, 100, 0);
+
+    CHECK(recloser.onTrip(0));
+    recloser.cancel();
+
+    CHECK(!recloser.isPending());
+    CHECK(!recloser.isDue(UINT64_MAX));
+    CHECK(!recloser.isExhausted());
+    CHECK(recloser.tripCount() == 1);
+    CHECK(recloser.retryIndex() == 0);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testReset()
+{
+    Recloser recloser = createRecloser(1, 100, 2);
+
+    CHECK(recloser.onTrip(0));
+    recloser.onReclose(100*Millisecond);
+    CHECK(!recloser.onTrip(200*Millisecond));
+    CHECK(recloser.isLockedOut());
+
+    recloser.reset();
+    CHECK(!recloser.isLockedOut());
+    CHECK(!recloser.isExhausted());
+    CHECK(!recloser.isPending());
+    CHECK(recloser.tripCount() == 0);
+    CHECK(recloser.retryIndex() == 0);
+
+    CHECK(recloser.onTrip(300*Millisecond));
+    recloser.onReclose(400*Millisecond);
+    CHECK(!recloser.onTrip(500*Millisecond));
+    CHECK(recloser.isLockedOut());
+
+    // Reconfiguring starts over as well, exhausted included
+    recloser.configure({ 0, 100, 0 });
+    CHECK(!recloser.onTrip(600*Millisecond));
+    CHECK(recloser.isExhausted());
+
+    recloser.configure({ 1, 100, 0 });
+    CHECK(!recloser.isExhausted());
+    CHECK(recloser.tripCount() == 0);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main() -> int
+{
+    testDisabled();
+    testRetries();
+    testMaximumDelay();
+    testRecovery();
+    testLockout();
+    testCancel();
+    testReset();
+
+    return failures();
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,165 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+// Limits and profiles on the user page when compacting it fails, none of them may be lost
+// and the next save has to write them back.
+
+#include "check.h"
+#include "config.h"
+#include "userpage.h"
+#include "virtualflash.h"
+
+#include <cstring>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr uintptr_t PageAddress = FLASH_BASE + Config::UserPage * FLASH_PAGE_SIZE;
+
+    // Records hold a sequence number, checksum and key besides the profile
+    constexpr size_t RecordSize = sizeof(UserPage::Profile) + 3 * sizeof(uint32_t);
+    constexpr size_t SlotCount = FLASH_PAGE_SIZE / RecordSize;
+    constexpr size_t KeyCount = UserPage::ProfileCount + 1;
+
+    auto isOnPage(const void* pointer) -> bool
+    {
+        const auto address = reinterpret_cast<uintptr_t>(pointer);
+        return address >= PageAddress && address < PageAddress + FLASH_PAGE_SIZE;
+    }
+
+    auto createData(float current) -> UserPage::Data
+    {
+        UserPage::Data data = {};
+        data.voltageLimits.fill(12.0F);
+        data.currentLimits.fill(current);
+
+        return data;
+    }
+
+    auto createProfile(size_t index) -> UserPage::Profile
+    {
+        UserPage::Profile profile = {};
+        profile.name = { 'P', static_cast<char>('0' + index) };
+        profile.data = createData(0.1F * static_cast<float>(index + 1));
+
+        return profile;
+    }
+
+    auto erases() -> uint64_t
+    {
+        return VirtualFlash::statistics().erases;
+    }
+
+    void checkData(float current, bool onPage)
+    {
+        const UserPage::Data& data = UserPage::data();
+
+        CHECK(data.currentLimits[0] == current);
+        CHECK(isOnPage(&data) == onPage);
+    }
+
+    void checkProfiles(bool onPage)
+    {
+        for (size_t i = 0; i < UserPage::ProfileCount; ++i)
+        {
+            const UserPage::Profile* profile = UserPage::profile(i);
+            CHECK(profile != nullptr);
+
+            if (!profile)
+                continue;
+
+            const UserPage::Profile expected = createProfile(i);
+
+            CHECK(std::strcmp(profile->name.data(), expected.name.data()) == 0);
+            CHECK(profile->data.currentLimits[0] == expected.data.currentLimits[0]);
+            CHECK(isOnPage(profile) == onPage);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testWriteFailure()
+{
+    for (size_t i = 0; i < UserPage::ProfileCount; ++i)
+        CHECK(UserPage::setProfile(i, createProfile(i)));
+
+    for (size_t i = UserPage::ProfileCount; i < SlotCount; ++i)
+        CHECK(UserPage::setData(createData(0.5F)));
+
+    const uint64_t erasesBefore = erases();
+
+    // The page is full, the limits are written back first and fail
+    VirtualFlash::failPrograms(1);
+    CHECK(!UserPage::setData(createData(0.7F)));
+    CHECK(erases() == erasesBefore + 1);
+
+    // The new limits remain in effect from RAM, the profiles made it back all the same
+    checkData(0.7F, false);
+    checkProfiles(true);
+
+    // Compacted again on the next save, even though there are free slots
+    CHECK(UserPage::setProfile(0, createProfile(0)));
+    CHECK(erases() == erasesBefore + 2);
+
+    checkData(0.7F, true);
+    checkProfiles(true);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void testEraseFailure()
+{
+    // The previous test left the latest record of each key only
+    for (size_t i = KeyCount; i < SlotCount; ++i)
+        CHECK(UserPage::setData(createData(0.8F)));
+
+    const uint64_t erasesBefore = erases();
+
+    VirtualFlash::failErases(1);
+    CHECK(!UserPage::setData(createData(0.9F)));
+    CHECK(erases() == erasesBefore + 1);
+
+    checkData(0.9F, false);
+    checkProfiles(false);
+
+    CHECK(UserPage::setData(createData(1.0F)));
+    CHECK(erases() == erasesBefore + 2);
+
+    checkData(1.0F, true);
+    checkProfiles(true);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main() -> int
+{
+    VirtualFlash::addRegion(PageAddress, FLASH_PAGE_SIZE);
+
+    testWriteFailure();
+    testEraseFailure();
+
+    return failures();
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,521 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+// Host benchmark of StaticString and of every protocol command, from the bytes arriving over
+// USB to the response handed back to the CDC layer. Times are measured on the host. The
+// host-cyc column is the same host time counted in 80 MHz core cycles and scaled by
+// --slowdown. It only estimates device cycles once --slowdown has been calibrated by comparing
+// COMMAND from GET_PERF_COUNTERS on a board with this benchmark.
+
+#include "config.h"
+#include "defaultstring.h"
+#include "deviceclock.h"
+#include "hostclock.h"
+#include "perfcounter.h"
+#include "relayboard.h"
+#include "usbd_cdc_if.h"
+#include "usbd_desc.h"
+#include "virtualboard.h"
+#include "virtualflash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <ucontext.h>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr size_t PacketSize = 64;
+
+    CDC_ReceiveCallback g_receiveCallback = nullptr;
+    CDC_TxCompleteCallback g_txCompleteCallback = nullptr;
+    size_t g_transmittedBytes = 0;
+
+    struct Measurement
+    {
+        std::string name;
+        double nanoseconds;
+        double copies;
+        double bytes;
+        size_t stack;
+        double waitTime;
+        double transmittedBytes;
+    };
+
+    struct Options
+    {
+        size_t iterations = 1000;
+        double slowdown = 1.0;
+        double tolerance = 0.25;
+        std::string saveFile;
+        std::string compareFile;
+    };
+
+    // Runs a function on a painted stack of its own and reports the deepest byte it touched
+    class StackProbe
+    {
+    public:
+        static constexpr size_t StackSize = 1024 * 1024;
+        static constexpr uint8_t Pattern = 0xa5;
+
+    public:
+        static auto run(const std::function<void()>& function) -> size_t
+        {
+            static std::vector<uint8_t> stack(StackSize);
+            std::fill(stack.begin(), stack.end(), Pattern);
+
+            s_function = &function;
+
+            ucontext_t callee = {};
+            ::getcontext(&callee);
+            callee.uc_stack.ss_sp = stack.data();
+            callee.uc_stack.ss_size = stack.size();
+            callee.uc_link = &s_caller;
+            ::makecontext(&callee, &StackProbe::trampoline, 0);
+            ::swapcontext(&s_caller, &callee);
+
+            const auto touched = std::find_if(stack.begin(), stack.end(),
+                                              [](uint8_t byte) { return byte != Pattern; });
+
+            return stack.end() - touched;
+        }
+
+    private:
+        static void trampoline() { (*s_function)(); }
+
+        static inline ucontext_t s_caller = {};
+        static inline const std::function<void()>* s_function = nullptr;
+    };
+
+    template <typename T>
+    void keep(const T& value)
+    {
+        asm volatile("" : : "r"(&value) : "memory");
+    }
+
+    auto nanosecondsSince(std::chrono::steady_clock::time_point start) -> double
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count();
+    }
+
+    auto measure(const std::string& name, size_t iterations,
+                 const std::function<void()>& operation) -> Measurement
+    {
+        // Stack used by the probe itself and the loop below
+        static const size_t overhead = StackProbe::run([] {});
+
+        double nanoseconds = 0.0;
+
+        StaticStringStatistics::reset();
+
+        const size_t stack = StackProbe::run([&] {
+            const auto start = std::chrono::steady_clock::now();
+
+            for (size_t i = 0; i < iterations; ++i)
+                operation();
+
+            nanoseconds = nanosecondsSince(start);
+        });
+
+        return {
+            name,
+            nanoseconds / iterations,
+            static_cast<double>(StaticStringStatistics::copies) / iterations,
+            static_cast<double>(StaticStringStatistics::bytes) / iterations,
+            stack - std::min(stack, overhead),
+            0.0,
+            0.0
+        };
+    }
+
+    void sendCommand(const std::string& command)
+    {
+        std::string line = command + HostInterface::LineTerminator;
+
+        for (size_t offset = 0; offset < line.size(); offset += PacketSize)
+        {
+            const size_t size = std::min(PacketSize, line.size() - offset);
+            g_receiveCallback(reinterpret_cast<uint8_t*>(line.data() + offset), size);
+        }
+    }
+
+    auto measureCommand(RelayBoard& board, const std::string& command,
+                        size_t iterations) -> Measurement
+    {
+        static const size_t overhead = StackProbe::run([] {});
+
+        PerfCounter& counter = PerfCounter::get(PerfCounter::Id::Command);
+        uint64_t cycles = 0;
+
+        StaticStringStatistics::reset();
+        HostClock::resetSkippedDelay();
+        g_transmittedBytes = 0;
+
+        // Each pass also updates one relay channel, only the command itself is timed
+        const size_t stack = StackProbe::run([&] {
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                sendCommand(command);
+
+                counter.reset();
+                board.update();
+                cycles += counter.max();
+            }
+        });
+
+        const double cyclesPerNanosecond = HostClock::CoreClock / 1e9;
+
+        return {
+            command,
+            static_cast<double>(cycles) / cyclesPerNanosecond / iterations,
+            static_cast<double>(StaticStringStatistics::copies) / iterations,
+            static_cast<double>(StaticStringStatistics::bytes) / iterations,
+            stack - std::min(stack, overhead),
+            HostClock::skippedDelay() / 1000.0 / iterations,
+            static_cast<double>(g_transmittedBytes) / iterations
+        };
+    }
+
+    auto benchmarkStrings(size_t iterations) -> std::vector<Measurement>
+    {
+        const String command = "<SET_POWER_LIMIT> 3 16.00,1.000";
+        const String arguments = "16.00,1.000";
+        const String tag = "<SET_POWER_LIMIT>";
+
+        std::vector<Measurement> results;
+
+        const auto add = [&](const std::string& name, const std::function<void()>& operation) {
+            results.push_back(measure(name, iterations, operation));
+        };
+
+        add("String(const char*)", [&] { keep(String("<SET_POWER_LIMIT> 3 16.00,1.000")); });
+        add("String(const String&)", [&] { keep(String(command)); });
+        add("operator==(const char*)", [&] { keep(tag == "<GET_POWER_LIMIT>"); });
+        add("operator+=(const String&)", [&] { String s = tag; s += arguments; keep(s); });
+        add("endsWith(const char*)", [&] { keep(command.endsWith("\r\n")); });
+        add("countTokens(' ')", [&] { keep(command.countTokens(' ')); });
+        add("getToken(' ', 0)", [&] { keep(command.getToken(' ', 0)); });
+        add("getToken(' ', 2)", [&] { keep(command.getToken(' ', 2)); });
+        add("getTokens(' ', 1, 2)", [&] { keep(command.getTokens(' ', 1, 2)); });
+        add("getToken(',', 1).toFloat()", [&] { keep(arguments.getToken(',', 1).toFloat()); });
+        add("toLong()", [&] { keep(String("15").toLong()); });
+        add("toULong() hex", [&] { keep(String("0xaaaa").toULong()); });
+        add("toFloat()", [&] { keep(String("16.00").toFloat()); });
+        add("format(\"%d\")", [&] { keep(String::format("%d", 1618493589)); });
+        add("format(\"%.3f,%.3f\")", [&] { keep(String::format("%.3f,%.3f", 12.34, 1.234)); });
+
+        return results;
+    }
+
+    auto benchmarkCommands(size_t iterations) -> std::vector<Measurement>
+    {
+        // Everything but LAUNCH_BOOTLOADER, which would end the program
+        static const std::vector<std::string> commands = {
+            "<GET_FAULT_MASK>",
+            "<SET_RELAY_STATE> 0 ON",
+            "<GET_RELAY_STATE> 0",
+            "<SET_STATE_MASK> 0xaaaa",
+            "<GET_STATE_MASK>",
+            "<GET_RELAY_POWER> 0",
+            "<GET_RELAY_WATTAGE> 0",
+            "<GET_ENERGY_COUNTERS>",
+            "<RESET_ENERGY_COUNTERS> 0",
+            "<ARM_CAPTURE> 0 0x3",
+            "<GET_CAPTURE_STATUS>",
+            "<READ_CAPTURE>",
+            "<DISARM_CAPTURE>",
+            "<CHARACTERIZE_RELAY> 1",
+            "<GET_CHARACTERIZATION_STATUS>",
+            "<GET_SWITCH_TIMING> 1",
+            "<CLEAR_FAULT> 0",
+            "<SET_RECLOSE_POLICY> 0 3,100,10",
+            "<GET_RECLOSE_POLICY> 0",
+            "<GET_RECLOSE_STATUS> 0",
+            "<SET_POWER_LIMIT> 0 16.00,1.000",
+            "<GET_POWER_LIMIT> 0",
+            "<SAVE_POWER_LIMITS>",
+            "<SET_BUS_SPEED> FAST",
+            "<GET_BUS_SPEED>",
+            "<SET_FILTER> 0 FAULT,3,0.050",
+            "<GET_FILTER> 0 FAULT",
+            "<SET_PROFILE_LIMIT> 0 16.00,1.000",
+            "<STORE_PROFILE> 0 Recipe-A",
+            "<GET_PROFILES>",
+            "<GET_PROFILE_LIMITS> 0",
+            "<LOAD_PROFILE> 0",
+            "<GET_JOURNAL_STATUS>",
+            "<READ_JOURNAL> 0,32",
+            "<GET_PERF_COUNTERS>",
+            "<GET_PERF_HISTOGRAMS>",
+            "<RESET_PERF_COUNTERS>",
+            "<GET_DEVICE_TIME>",
+            "<SET_TIMESTAMPS> OFF",
+            "<GET_BOOT_MODE>",
+            "<GET_BOARD_NAME>",
+            "<GET_HARDWARE_VERSION>",
+            "<GET_FIRMWARE_VERSION>",
+            "<GET_SERIAL_NUMBER>",
+            "<GET_BUILD_TIMESTAMP>",
+            "<RESET>",
+            "<GET_RELAY_STATE> 16",
+            "<NO_SUCH_COMMAND>"
+        };
+
+        VirtualBoard board(0);
+
+        DeviceClock::init();
+        RelayBoard relayBoard;
+
+        std::vector<Measurement> results;
+
+        for (const std::string& command : commands)
+            results.push_back(measureCommand(relayBoard, command, iterations));
+
+        return results;
+    }
+
+    void printResults(const std::string& title, const std::vector<Measurement>& results,
+                      const Options& options)
+    {
+        std::printf("\n%-36s %9s %10s %7s %7s %7s %9s %8s\n", title.c_str(), "ns/op", "host-cyc",
+                    "copies", "bytes", "stack", "wait/us", "tx/B");
+
+        const double cyclesPerNanosecond = HostClock::CoreClock / 1e9 * options.slowdown;
+
+        for (const Measurement& m : results)
+        {
+            std::printf("%-36s %9.1f %10.0f %7.2f %7.1f %7zu %9.1f %8.1f\n", m.name.c_str(),
+                        m.nanoseconds, m.nanoseconds * cyclesPerNanosecond, m.copies, m.bytes,
+                        m.stack, m.waitTime, m.transmittedBytes);
+        }
+    }
+
+    auto save(const std::string& filename, const std::vector<Measurement>& results) -> bool
+    {
+        std::ofstream file(filename);
+
+        // Semicolons, command arguments contain commas
+        for (const Measurement& m : results)
+            file << m.name << ';' << m.nanoseconds << ';' << m.copies << ';' << m.bytes << ';'
+                 << m.stack << '\n';
+
+        return file.good();
+    }
+
+    // Copies and stack are deterministic and must not grow, copied bytes get 1 % slack for
+    // readings formatted with varying length, times may vary within tolerance
+    auto compare(const std::string& filename, const std::vector<Measurement>& results,
+                 double tolerance) -> bool
+    {
+        std::ifstream file(filename);
+
+        if (!file)
+        {
+            std::fprintf(stderr, "Unable to read baseline %s\n", filename.c_str());
+            return false;
+        }
+
+        std::map<std::string, Measurement> baseline;
+        std::string line;
+
+        while (std::getline(file, line))
+        {
+            std::istringstream stream(line);
+            Measurement m = {};
+            std::string field;
+
+            std::getline(stream, m.name, ';');
+            std::getline(stream, field, ';');
+            m.nanoseconds = std::atof(field.c_str());
+            std::getline(stream, field, ';');
+            m.copies = std::atof(field.c_str());
+            std::getline(stream, field, ';');
+            m.bytes = std::atof(field.c_str());
+            std::getline(stream, field, ';');
+            m.stack = std::strtoul(field.c_str(), nullptr, 10);
+
+            baseline[m.name] = m;
+        }
+
+        bool passed = true;
+
+        for (const Measurement& m : results)
+        {
+            const auto it = baseline.find(m.name);
+
+            if (it == baseline.end())
+                continue;
+
+            const Measurement& b = it->second;
+
+            const bool regressed = m.copies > b.copies + 0.005 ||
+                                   m.bytes > b.bytes * 1.01 + 0.05 ||
+                                   m.stack > b.stack ||
+                                   m.nanoseconds > b.nanoseconds * (1.0 + tolerance);
+            if (regressed)
+            {
+                std::printf("REGRESSION %s: %.1f ns, %.2f copies, %.1f bytes, %zu stack "
+                            "(baseline %.1f ns, %.2f copies, %.1f bytes, %zu stack)\n",
+                            m.name.c_str(), m.nanoseconds, m.copies, m.bytes, m.stack,
+                            b.nanoseconds, b.copies, b.bytes, b.stack);
+                passed = false;
+            }
+        }
+
+        return passed;
+    }
+
+    auto parseOptions(int argc, char* argv[], Options* options) -> bool
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string option = argv[i];
+
+            if (i + 1 >= argc)
+                return false;
+
+            if (option == "--iterations")
+                options->iterations = std::max(1UL, std::strtoul(argv[++i], nullptr, 10));
+            else if (option == "--slowdown")
+                options->slowdown = std::atof(argv[++i]);
+            else if (option == "--tolerance")
+                options->tolerance = std::atof(argv[++i]) / 100.0;
+            else if (option == "--save")
+                options->saveFile = argv[++i];
+            else if (option == "--compare")
+                options->compareFile = argv[++i];
+            else
+                return false;
+        }
+
+        return true;
+    }
+
+    auto getSerialStrDescriptor(USBD_SpeedTypeDef, uint16_t* length) -> uint8_t*
+    {
+        static uint8_t descriptor[] = { 10, 0x03, 'B', 0, 'E', 0, 'N', 0, 'C', 0 };
+
+        *length = sizeof(descriptor);
+        return descriptor;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+USBD_DescriptorsTypeDef FS_Desc = { &getSerialStrDescriptor };
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HAL_NVIC_SystemReset()
+{
+    std::fprintf(stderr, "Unexpected system reset\n");
+    std::abort();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto CDC_Transmit(uint8_t*, uint16_t size) -> uint8_t
+{
+    g_transmittedBytes += size;
+
+    if (g_txCompleteCallback)
+        g_txCompleteCallback();
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void CDC_RegisterReceiveCallback(CDC_ReceiveCallback callback)
+{
+    g_receiveCallback = callback;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void CDC_RegisterTxCompleteCallback(CDC_TxCompleteCallback callback)
+{
+    g_txCompleteCallback = callback;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main(int argc, char* argv[]) -> int
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, &options))
+    {
+        std::printf("Usage: %s [options]\n"
+                    "  --iterations <n>   Repetitions per operation (default 1000)\n"
+                    "  --slowdown <x>     Device cycles per host-cyc, uncalibrated (default 1)\n"
+                    "  --save <file>      Stores the results as baseline\n"
+                    "  --compare <file>   Fails if results are worse than the baseline\n"
+                    "  --tolerance <pct>  Allowed increase of times over the baseline (25)\n",
+                    argv[0]);
+        return 2;
+    }
+
+    // Bus transfers take place in real time, HAL_Delay() is only added up as wait time
+    HostClock::setDelaysSkipped(true);
+
+    VirtualFlash::addRegion(FLASH_BASE + Config::UserPage * FLASH_PAGE_SIZE, FLASH_PAGE_SIZE);
+
+    const auto strings = benchmarkStrings(options.iterations);
+    const auto commands = benchmarkCommands(options.iterations);
+
+    std::printf("Host times, host-cyc is host time in %u MHz cycles x %.2f (not measured on a\n"
+                "board), copies and bytes copied of StaticString, stack in bytes on the host,\n"
+                "wait and transmitted bytes per command\n",
+                HostClock::CoreClock / 1000000, options.slowdown);
+
+    printResults("StaticString<100>", strings, options);
+    printResults("Command", commands, options);
+
+    std::vector<Measurement> results = strings;
+    results.insert(results.end(), commands.begin(), commands.end());
+
+    if (!options.saveFile.empty() && !save(options.saveFile, results))
+    {
+        std::fprintf(stderr, "Unable to write %s\n", options.saveFile.c_str());
+        return 1;
+    }
+
+    if (!options.compareFile.empty() && !compare(options.compareFile, results, options.tolerance))
+        return 1;
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
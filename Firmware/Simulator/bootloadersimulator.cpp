@@ -0,0 +1,242 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "bootmanager.h"
+#include "config.h"
+#include "pseudoterminal.h"
+#include "usermain.h"
+#include "virtualflash.h"
+
+#include <array>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr uint32_t FirmwareRegionAddress = Config::FlashStartAddress +
+                                               Config::FirmwareStartSector * Config::SectorSize;
+    constexpr uint32_t FirmwareRegionSize = Config::FirmwareSectorCount * Config::SectorSize;
+
+    // Placed at FLASH_BASE by the linker, see CMakeLists.txt. Only the firmware sectors are added
+    // as region, so the bootloader's own pages read as erased and cannot be written.
+    std::array<uint64_t, FLASH_SIZE / sizeof(uint64_t)> g_flash __attribute__((section(".flash")));
+
+    void printHelp(FILE* stream)
+    {
+        std::fprintf(stream,
+            "  timed on|off               Flash and USB take as long as on the board\n"
+            "  failprogram <count>        The next doubleword programming operations fail\n"
+            "  failerase <count>          The next page erases fail\n"
+            "  biterror <rate>            Chance of a doubleword reading back wrong, 0 to 1\n"
+            "  corrupt <address> <bit>    Flips a bit in the firmware sectors\n"
+            "  status                     Prints flash statistics\n"
+            "  quit                       Saves the flash and exits like a power loss\n");
+    }
+
+    void printUsage(const char* program)
+    {
+        std::printf("Usage: %s [options]\n"
+                    "  --flash <file>   Keeps the firmware sectors in the given file across runs\n"
+                    "  --timed          Same as the console command 'timed on'\n"
+                    "  --exec <cmd>     Runs a console command before the bootloader starts\n"
+                    "  --help           Prints this text and the console commands\n\n",
+                    program);
+
+        printHelp(stdout);
+    }
+
+    void printStatus()
+    {
+        const VirtualFlash::Statistics statistics = VirtualFlash::statistics();
+
+        std::printf("Flash: %" PRIu64 " programmed, %" PRIu64 " erased, %" PRIu64 " errors "
+                    "(%" PRIu64 " injected), busy for %.1f ms\n",
+                    statistics.programs, statistics.erases, statistics.errors,
+                    statistics.injectedErrors, statistics.busyTime / 1e6);
+
+        std::printf("Firmware image: %s\n", BootManager::getFirmwareValid() ? "valid" : "invalid");
+        std::fflush(stdout);
+    }
+
+    template <typename... Args>
+    auto parseArguments(std::istringstream& stream, Args&... args) -> bool
+    {
+        (stream >> ... >> args);
+
+        std::string rest;
+        return !stream.fail() && !(stream >> rest);
+    }
+
+    auto execute(const std::string& line) -> bool
+    {
+        std::istringstream stream(line);
+
+        std::string command;
+        if (!(stream >> command))
+            return true;
+
+        bool valid = true;
+
+        if (command == "help")
+            printHelp(stdout);
+        else if (command == "status")
+            printStatus();
+        else if (command == "quit")
+        {
+            VirtualFlash::saveImages();
+            std::exit(0);
+        }
+        else if (command == "timed")
+        {
+            std::string state;
+            valid = parseArguments(stream, state) && (state == "on" || state == "off");
+
+            if (valid)
+            {
+                const bool timed = (state == "on");
+
+                VirtualFlash::setTimed(timed);
+                PseudoTerminal::setPacketInterval(timed ? PseudoTerminal::FullSpeedPacketInterval
+                                                        : 0);
+            }
+        }
+        else if (command == "failprogram" || command == "failerase")
+        {
+            uint32_t count = 0;
+            valid = parseArguments(stream, count);
+
+            if (valid && command == "failprogram")
+                VirtualFlash::failPrograms(count);
+            else if (valid)
+                VirtualFlash::failErases(count);
+        }
+        else if (command == "biterror")
+        {
+            float rate = 0.0F;
+            valid = parseArguments(stream, rate);
+
+            if (valid)
+                VirtualFlash::setBitErrorRate(rate);
+        }
+        else if (command == "corrupt")
+        {
+            std::string address;
+            unsigned bit = 0;
+
+            valid = parseArguments(stream, address, bit) &&
+                    VirtualFlash::corrupt(std::strtoul(address.c_str(), nullptr, 0), bit);
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown command '%s', try 'help'\n", command.c_str());
+            return false;
+        }
+
+        if (!valid)
+            std::fprintf(stderr, "Invalid arguments in '%s', try 'help'\n", line.c_str());
+
+        return valid;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HAL_NVIC_SystemReset()
+{
+    // The firmware cannot run here, so launching it ends the simulation
+    std::printf("Bootloader requested a system reset, exiting\n");
+
+    VirtualFlash::saveImages();
+    std::exit(0);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main(int argc, char* argv[]) -> int
+{
+    std::string flashFile;
+    std::vector<std::string> commands;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string option = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (option == "--flash" && hasValue)
+            flashFile = argv[++i];
+        else if (option == "--timed")
+            commands.push_back("timed on");
+        else if (option == "--exec" && hasValue)
+            commands.push_back(argv[++i]);
+        else
+        {
+            printUsage(argv[0]);
+            return (option == "--help") ? 0 : 2;
+        }
+    }
+
+    g_flash.fill(0xffffffffffffffff);
+    VirtualFlash::addRegion(FirmwareRegionAddress, FirmwareRegionSize, flashFile);
+
+    for (const std::string& command : commands)
+    {
+        if (!execute(command))
+            return 2;
+    }
+
+    const std::string port = PseudoTerminal::open();
+
+    if (port.empty())
+    {
+        std::fprintf(stderr, "Unable to create pseudo-terminal: %s\n", std::strerror(errno));
+        return 1;
+    }
+
+    // libIRB expects port names relative to /dev
+    std::printf("RelayBoard bootloader simulator listening on %s (port name %s)\n",
+                port.c_str(), port.substr(std::strlen("/dev/")).c_str());
+
+    printStatus();
+
+    std::thread([] {
+        std::string line;
+
+        while (std::getline(std::cin, line))
+            execute(line);
+    }).detach();
+
+    user_main();
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,262 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "console.h"
+#include "virtuali2c.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    const std::array<std::string, 7> ChannelCommands = {
+        "load", "supply", "timing", "noise", "spike", "stuck", "fail"
+    };
+
+    auto parseChannels(const std::string& token, std::vector<size_t>* channels) -> bool
+    {
+        if (token == "all")
+        {
+            for (size_t i = 0; i < VirtualBoard::ChannelCount; ++i)
+                channels->push_back(i);
+
+            return true;
+        }
+
+        char* end = nullptr;
+        const unsigned long index = std::strtoul(token.c_str(), &end, 10);
+
+        if (token.empty() || *end != '\0' || index >= VirtualBoard::ChannelCount)
+            return false;
+
+        channels->push_back(index);
+        return true;
+    }
+
+    auto printUsage(const std::string& line) -> bool
+    {
+        std::fprintf(stderr, "Invalid arguments in '%s', try 'help'\n", line.c_str());
+        return false;
+    }
+
+    template <typename... Args>
+    auto parseArguments(std::istringstream& stream, Args&... args) -> bool
+    {
+        (stream >> ... >> args);
+
+        std::string rest;
+        return !stream.fail() && !(stream >> rest);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+Console::Console(VirtualBoard& board)
+    : m_board(board)
+{
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Console::execute(const std::string& line) -> bool
+{
+    std::istringstream stream(line);
+
+    std::string command;
+    if (!(stream >> command))
+        return true;
+
+    if (command == "help")
+    {
+        printHelp(stdout);
+        return true;
+    }
+
+    if (command == "status")
+    {
+        m_board.printStatus(stdout);
+        return true;
+    }
+
+    if (command == "quit")
+        std::exit(0);
+
+    if (command == "nack")
+    {
+        float rate = 0.0F;
+
+        if (!parseArguments(stream, rate))
+            return printUsage(line);
+
+        VirtualI2cBus::setErrorRate(rate);
+        return true;
+    }
+
+    const auto known = std::find(ChannelCommands.begin(), ChannelCommands.end(), command);
+
+    if (known == ChannelCommands.end())
+    {
+        std::fprintf(stderr, "Unknown command '%s', try 'help'\n", command.c_str());
+        return false;
+    }
+
+    std::string token;
+    std::vector<size_t> channels;
+
+    if (!(stream >> token) || !parseChannels(token, &channels))
+    {
+        std::fprintf(stderr, "Invalid or missing channel in '%s'\n", line.c_str());
+        return false;
+    }
+
+    const auto apply = [&](auto function) {
+        for (size_t index : channels)
+            function(m_board.channel(index));
+    };
+
+    if (command == "load")
+    {
+        std::string value;
+        if (!parseArguments(stream, value))
+            return printUsage(line);
+
+        // Anything but a number, such as "open", disconnects the load
+        const float resistance = std::strtof(value.c_str(), nullptr);
+
+        apply([&](Ina226Model& channel) {
+            Ina226Model::Load load = channel.load();
+            load.resistance = resistance;
+            channel.setLoad(load);
+        });
+    }
+    else if (command == "supply")
+    {
+        float voltage = 0.0F;
+        if (!parseArguments(stream, voltage))
+            return printUsage(line);
+
+        apply([&](Ina226Model& channel) {
+            Ina226Model::Load load = channel.load();
+            load.supplyVoltage = voltage;
+            channel.setLoad(load);
+        });
+    }
+    else if (command == "timing")
+    {
+        uint32_t onDelay = 0;
+        uint32_t offDelay = 0;
+        uint32_t riseTime = 0;
+        if (!parseArguments(stream, onDelay, offDelay, riseTime))
+            return printUsage(line);
+
+        apply([&](Ina226Model& channel) {
+            Ina226Model::Load load = channel.load();
+            load.onDelay = onDelay;
+            load.offDelay = offDelay;
+            load.riseTime = riseTime;
+            channel.setLoad(load);
+        });
+    }
+    else if (command == "noise")
+    {
+        Ina226Model::Noise noise;
+        if (!parseArguments(stream, noise.current, noise.voltage))
+            return printUsage(line);
+
+        apply([&](Ina226Model& channel) { channel.setNoise(noise); });
+    }
+    else if (command == "spike")
+    {
+        float current = 0.0F;
+        uint32_t duration = 0;
+        if (!parseArguments(stream, current, duration))
+            return printUsage(line);
+
+        apply([&](Ina226Model& channel) { channel.injectSpike(current, duration); });
+    }
+    else if (command == "stuck")
+    {
+        std::string state;
+        if (!parseArguments(stream, state))
+            return printUsage(line);
+
+        Ina226Model::Stuck stuck = Ina226Model::Stuck::None;
+
+        if (state == "open")
+            stuck = Ina226Model::Stuck::Open;
+        else if (state == "closed")
+            stuck = Ina226Model::Stuck::Closed;
+        else if (state != "none")
+            return printUsage(line);
+
+        apply([&](Ina226Model& channel) { channel.setStuck(stuck); });
+    }
+    else if (command == "fail")
+    {
+        std::string state;
+        if (!parseArguments(stream, state) || (state != "on" && state != "off"))
+            return printUsage(line);
+
+        apply([&](Ina226Model& channel) { channel.setFailed(state == "on"); });
+    }
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Console::start()
+{
+    std::thread([this] {
+        std::string line;
+
+        while (std::getline(std::cin, line))
+            execute(line);
+    }).detach();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Console::printHelp(FILE* stream)
+{
+    std::fprintf(stream,
+        "Channels are 0 to 15 or 'all'.\n"
+        "  load <ch> <ohms|open>          Load resistance, 'open' disconnects it\n"
+        "  supply <ch> <volts>            Supply voltage behind the relay\n"
+        "  timing <ch> <on> <off> <rise>  Relay delays and rise time in microseconds\n"
+        "  noise <ch> <amps> <volts>      Noise of a single conversion\n"
+        "  spike <ch> <amps> <ms>         Adds a current spike on top of the load\n"
+        "  stuck <ch> open|closed|none    Relay ignores its gate signal\n"
+        "  fail <ch> on|off               INA226 stops responding\n"
+        "  nack <rate>                    Probability of a NACKed I2C transfer, 0 to 1\n"
+        "  status                         Prints all channels and bus statistics\n"
+        "  quit                           Terminates the simulator\n");
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,125 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "hostclock.h"
+#include "stm32l4xx_hal.h"
+
+#include <chrono>
+#include <thread>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point g_startTime = Clock::now();
+
+    CoreDebug_Type g_coreDebug = {};
+    DWT_Type g_dwt = {};
+
+    bool g_delaysSkipped = false;
+    uint64_t g_skippedDelay = 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+uint32_t SystemCoreClock = HostClock::CoreClock;
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HostClock::now() -> uint64_t
+{
+    const auto elapsed = Clock::now() - g_startTime;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HostClock::spin(uint64_t nanoseconds)
+{
+    const uint64_t end = now() + nanoseconds;
+
+    while (now() < end)
+        continue;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HostClock::setDelaysSkipped(bool skipped)
+{
+    g_delaysSkipped = skipped;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HostClock::skippedDelay() -> uint64_t
+{
+    return g_skippedDelay;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HostClock::resetSkippedDelay()
+{
+    g_skippedDelay = 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto sim_core_debug() -> CoreDebug_Type*
+{
+    return &g_coreDebug;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto sim_dwt() -> DWT_Type*
+{
+    // Wraps like the real 32-bit counter, which is all DeviceClock and PerfCounter rely on
+    const uint64_t cycles = HostClock::now() * (HostClock::CoreClock / 1000000) / 1000;
+    g_dwt.CYCCNT = static_cast<uint32_t>(cycles);
+
+    return &g_dwt;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HAL_Delay(uint32_t delay)
+{
+    if (g_delaysSkipped)
+    {
+        g_skippedDelay += delay * 1000000ULL;
+        return;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HAL_GetTick() -> uint32_t
+{
+    return static_cast<uint32_t>(HostClock::now() / 1000000);
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,44 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <cstdint>
+
+// Host time base standing in for SysTick and the DWT cycle counter
+class HostClock
+{
+public:
+    static constexpr uint32_t CoreClock = 80000000;
+
+    // Nanoseconds since the simulator was started
+    static auto now() -> uint64_t;
+
+    // Busy-waits, sleeping would overshoot sub-millisecond bus transfers
+    static void spin(uint64_t nanoseconds);
+
+    // Makes HAL_Delay() return at once, the requested time is only added up
+    static void setDelaysSkipped(bool skipped);
+    static auto skippedDelay() -> uint64_t;
+    static void resetSkippedDelay();
+};
@@ -0,0 +1,427 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "hostclock.h"
+#include "ina226model.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr uint8_t ConfigurationRegister = 0x00;
+    constexpr uint8_t ShuntVoltageRegister  = 0x01;
+    constexpr uint8_t BusVoltageRegister    = 0x02;
+    constexpr uint8_t PowerRegister         = 0x03;
+    constexpr uint8_t CurrentRegister       = 0x04;
+    constexpr uint8_t CalibrationRegister   = 0x05;
+    constexpr uint8_t MaskEnableRegister    = 0x06;
+    constexpr uint8_t AlertLimitRegister    = 0x07;
+    constexpr uint8_t ManufacturerIdRegister = 0xfe;
+    constexpr uint8_t DieIdRegister          = 0xff;
+
+    constexpr uint16_t DefaultConfiguration = 0x4127;
+    constexpr uint16_t ResetBit = 0x8000;
+    constexpr uint16_t ConversionReadyFlag = 0x0008;
+    constexpr uint16_t ManufacturerId = 0x5449;
+    constexpr uint16_t DieId = 0x2260;
+
+    constexpr float ShuntVoltageLsb = 2.5e-6F;
+    constexpr float BusVoltageLsb = 1.25e-3F;
+
+    // Indexed by the AVG, VBUSCT and VSHCT fields of the configuration register
+    constexpr std::array<uint32_t, 8> AverageCounts = { 1, 4, 16, 64, 128, 256, 512, 1024 };
+    constexpr std::array<uint32_t, 8> ConversionTimes = {
+        140, 204, 332, 588, 1100, 2116, 4156, 8244
+    };
+
+    // Points per averaging window, enough to catch spikes shorter than a conversion
+    constexpr int WindowPoints = 8;
+
+    auto splitMix(uint64_t x) -> uint64_t
+    {
+        x += 0x9e3779b97f4a7c15;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+        return x ^ (x >> 31);
+    }
+
+    auto toUniform(uint64_t x) -> float
+    {
+        return static_cast<float>((x >> 40) + 1) / static_cast<float>(1ULL << 24);
+    }
+
+    // Same conversion always yields the same noise, however often it is read
+    auto gaussianPair(uint64_t seed) -> std::array<float, 2>
+    {
+        const uint64_t first = splitMix(seed);
+        const uint64_t second = splitMix(first);
+
+        const float radius = std::sqrt(-2.0F * std::log(toUniform(first)));
+        const float angle = 6.2831853F * toUniform(second);
+
+        return { radius * std::cos(angle), radius * std::sin(angle) };
+    }
+
+    template <typename T>
+    auto saturate(float value) -> T
+    {
+        const float minimum = std::numeric_limits<T>::min();
+        const float maximum = std::numeric_limits<T>::max();
+
+        return static_cast<T>(std::lround(std::clamp(value, minimum, maximum)));
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+Ina226Model::Ina226Model(float shuntResistance, uint64_t seed)
+    : m_shuntResistance(shuntResistance),
+      m_seed(seed)
+{
+    reset();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Ina226Model::setLoad(const Load& load)
+{
+    std::lock_guard lock(m_mutex);
+    m_load = load;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::load() const -> Load
+{
+    std::lock_guard lock(m_mutex);
+    return m_load;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Ina226Model::setNoise(const Noise& noise)
+{
+    std::lock_guard lock(m_mutex);
+    m_noise = noise;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::noise() const -> Noise
+{
+    std::lock_guard lock(m_mutex);
+    return m_noise;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Ina226Model::setStuck(Stuck stuck)
+{
+    std::lock_guard lock(m_mutex);
+    m_stuck = stuck;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::stuck() const -> Stuck
+{
+    std::lock_guard lock(m_mutex);
+    return m_stuck;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Ina226Model::injectSpike(float current, uint32_t duration)
+{
+    std::lock_guard lock(m_mutex);
+
+    m_spikeCurrent = current;
+    m_spikeStart = HostClock::now();
+    m_spikeEnd = m_spikeStart + duration * 1000ULL;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Ina226Model::setFailed(bool failed)
+{
+    std::lock_guard lock(m_mutex);
+    m_failed = failed;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::failed() const -> bool
+{
+    std::lock_guard lock(m_mutex);
+    return m_failed;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Ina226Model::setRelayState(bool on)
+{
+    std::lock_guard lock(m_mutex);
+
+    const uint64_t now = HostClock::now();
+
+    m_switchCurrent = currentAt(now);
+    m_switchTime = now;
+    m_relayOn = on;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::relayState() const -> bool
+{
+    std::lock_guard lock(m_mutex);
+    return m_relayOn;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::current() const -> float
+{
+    std::lock_guard lock(m_mutex);
+    return currentAt(HostClock::now());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::writeRegister(uint8_t reg, const uint8_t* data, size_t size) -> bool
+{
+    std::lock_guard lock(m_mutex);
+
+    if (m_failed || size != 2)
+        return false;
+
+    const auto value = static_cast<uint16_t>((data[0] << 8) | data[1]);
+
+    switch (reg)
+    {
+    case ConfigurationRegister:
+        if (value & ResetBit)
+            reset();
+        else
+            m_configuration = value;
+        return true;
+
+    case CalibrationRegister:
+        m_calibration = value & 0x7fff;
+        return true;
+
+    case MaskEnableRegister:
+        m_maskEnable = value;
+        return true;
+
+    case AlertLimitRegister:
+        m_alertLimit = value;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::readRegister(uint8_t reg, uint8_t* data, size_t size) -> bool
+{
+    std::lock_guard lock(m_mutex);
+
+    uint16_t value = 0;
+
+    if (m_failed || size != 2 || !readValue(reg, &value))
+        return false;
+
+    // Reading the register clears the flag until the next conversion completes
+    if (reg == MaskEnableRegister)
+    {
+        const uint64_t conversions = HostClock::now() / conversionTime();
+
+        if (conversions > m_readConversions)
+            value |= ConversionReadyFlag;
+
+        m_readConversions = conversions;
+    }
+
+    data[0] = static_cast<uint8_t>(value >> 8);
+    data[1] = static_cast<uint8_t>(value);
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Ina226Model::reset()
+{
+    m_configuration = DefaultConfiguration;
+    m_calibration = 0;
+    m_maskEnable = 0;
+    m_alertLimit = 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::currentAt(uint64_t time) const -> float
+{
+    const float loadCurrent = (m_load.resistance > 0.0F)
+            ? m_load.supplyVoltage / (m_load.resistance + m_shuntResistance)
+            : 0.0F;
+
+    float current = 0.0F;
+
+    if (m_stuck == Stuck::Closed)
+        current = loadCurrent;
+    else if (m_stuck == Stuck::None)
+    {
+        const uint64_t delay = (m_relayOn ? m_load.onDelay : m_load.offDelay) * 1000ULL;
+        const uint64_t riseTime = std::max<uint64_t>(m_load.riseTime * 1000ULL, 1);
+
+        const float target = m_relayOn ? loadCurrent : 0.0F;
+
+        if (time < m_switchTime + delay)
+            current = m_switchCurrent;
+        else
+        {
+            const uint64_t elapsed = std::min(time - m_switchTime - delay, riseTime);
+            const float progress = static_cast<float>(elapsed) / static_cast<float>(riseTime);
+            current = m_switchCurrent + (target - m_switchCurrent) * progress;
+        }
+    }
+
+    if (time >= m_spikeStart && time < m_spikeEnd)
+        current += m_spikeCurrent;
+
+    return current;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::conversionTime() const -> uint64_t
+{
+    const uint32_t bus = ConversionTimes[(m_configuration >> 6) & 0x07];
+    const uint32_t shunt = ConversionTimes[(m_configuration >> 3) & 0x07];
+
+    return (bus + shunt) * averageCount() * 1000ULL;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::averageCount() const -> uint32_t
+{
+    return AverageCounts[(m_configuration >> 9) & 0x07];
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::sampleAt(uint64_t time) const -> Sample
+{
+    // Registers hold the average over the last completed conversion window
+    const uint64_t window = conversionTime();
+    const uint64_t index = time / window;
+    const uint64_t start = (index > 0) ? (index - 1) * window : 0;
+
+    float current = 0.0F;
+
+    for (int i = 0; i < WindowPoints; ++i)
+        current += currentAt(start + (2*i + 1) * window / (2*WindowPoints));
+
+    current /= WindowPoints;
+
+    const auto noise = gaussianPair(m_seed ^ index);
+    const float scale = 1.0F / std::sqrt(static_cast<float>(averageCount()));
+
+    current += noise[0] * m_noise.current * scale;
+
+    const float voltage = m_load.supplyVoltage - current * m_shuntResistance
+                          + noise[1] * m_noise.voltage * scale;
+
+    return { current, voltage };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Ina226Model::readValue(uint8_t reg, uint16_t* value) const -> bool
+{
+    switch (reg)
+    {
+    case ConfigurationRegister:
+        *value = m_configuration;
+        return true;
+
+    case CalibrationRegister:
+        *value = m_calibration;
+        return true;
+
+    case MaskEnableRegister:
+        *value = m_maskEnable;
+        return true;
+
+    case AlertLimitRegister:
+        *value = m_alertLimit;
+        return true;
+
+    case ManufacturerIdRegister:
+        *value = ManufacturerId;
+        return true;
+
+    case DieIdRegister:
+        *value = DieId;
+        return true;
+
+    case ShuntVoltageRegister:
+    case BusVoltageRegister:
+    case PowerRegister:
+    case CurrentRegister:
+        break;
+
+    default:
+        return false;
+    }
+
+    const Sample sample = sampleAt(HostClock::now());
+
+    const auto shunt = saturate<int16_t>(sample.current * m_shuntResistance / ShuntVoltageLsb);
+    const auto bus = saturate<int16_t>(std::max(sample.voltage, 0.0F) / BusVoltageLsb);
+
+    // Derived from the shunt and bus registers as described in the datasheet
+    const auto current = static_cast<int16_t>(shunt * m_calibration / 2048);
+    const auto power = static_cast<uint16_t>(std::abs(current) * bus / 20000);
+
+    if (reg == ShuntVoltageRegister)
+        *value = static_cast<uint16_t>(shunt);
+    else if (reg == BusVoltageRegister)
+        *value = static_cast<uint16_t>(bus);
+    else if (reg == PowerRegister)
+        *value = power;
+    else
+        *value = static_cast<uint16_t>(current);
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
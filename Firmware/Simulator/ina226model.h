@@ -0,0 +1,130 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "virtuali2c.h"
+
+#include <mutex>
+
+// Register-level INA226 model measuring the load switched by one relay
+class Ina226Model : public I2cDevice
+{
+public:
+    struct Load
+    {
+        float supplyVoltage = 24.0F;
+        float resistance = 48.0F; // Zero or less leaves the output open
+
+        // Solid-state relay response to the gate signal, in microseconds
+        uint32_t onDelay = 500;
+        uint32_t offDelay = 200;
+        uint32_t riseTime = 100;
+    };
+
+    // Standard deviation of a single conversion, averaging reduces it like on the chip
+    struct Noise
+    {
+        float current = 0.5e-3F;
+        float voltage = 2.0e-3F;
+    };
+
+    enum class Stuck
+    {
+        None,
+        Open,
+        Closed
+    };
+
+public:
+    Ina226Model(float shuntResistance, uint64_t seed);
+
+    void setLoad(const Load& load);
+    auto load() const -> Load;
+
+    void setNoise(const Noise& noise);
+    auto noise() const -> Noise;
+
+    // A stuck relay ignores its gate signal, like a welded or burnt-out switch
+    void setStuck(Stuck stuck);
+    auto stuck() const -> Stuck;
+
+    // Adds a current step on top of the load for the given time
+    void injectSpike(float current, uint32_t duration);
+
+    // A failed chip NACKs every register access
+    void setFailed(bool failed);
+    auto failed() const -> bool;
+
+    void setRelayState(bool on);
+    auto relayState() const -> bool;
+
+    // True current through the shunt, without conversion or noise
+    auto current() const -> float;
+
+    auto writeRegister(uint8_t reg, const uint8_t* data, size_t size) -> bool override;
+    auto readRegister(uint8_t reg, uint8_t* data, size_t size) -> bool override;
+
+private:
+    struct Sample
+    {
+        float current;
+        float voltage;
+    };
+
+    void reset();
+
+    auto currentAt(uint64_t time) const -> float;
+    auto conversionTime() const -> uint64_t;
+    auto averageCount() const -> uint32_t;
+    auto sampleAt(uint64_t time) const -> Sample;
+
+    auto readValue(uint8_t reg, uint16_t* value) const -> bool;
+
+private:
+    mutable std::mutex m_mutex;
+
+    const float m_shuntResistance;
+    const uint64_t m_seed;
+
+    Load m_load;
+    Noise m_noise;
+    Stuck m_stuck = Stuck::None;
+    bool m_failed = false;
+
+    bool m_relayOn = false;
+    uint64_t m_switchTime = 0;
+    float m_switchCurrent = 0.0F;
+
+    float m_spikeCurrent = 0.0F;
+    uint64_t m_spikeStart = 0;
+    uint64_t m_spikeEnd = 0;
+
+    uint16_t m_configuration = 0;
+    uint16_t m_calibration = 0;
+    uint16_t m_maskEnable = 0;
+    uint16_t m_alertLimit = 0;
+
+    // Conversions completed when the ready flag was last read
+    uint64_t m_readConversions = 0;
+};
@@ -0,0 +1,181 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "config.h"
+#include "console.h"
+#include "protocol.h"
+#include "pseudoterminal.h"
+#include "usbd_desc.h"
+#include "usermain.h"
+#include "virtualflash.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    std::vector<uint8_t> g_serialDescriptor;
+
+    auto getSerialStrDescriptor(USBD_SpeedTypeDef, uint16_t* length) -> uint8_t*
+    {
+        *length = static_cast<uint16_t>(g_serialDescriptor.size());
+        return g_serialDescriptor.data();
+    }
+
+    void setSerialNumber(const std::string& serial)
+    {
+        // String descriptor: length, type, then UTF-16LE
+        g_serialDescriptor = { static_cast<uint8_t>(2 + 2*serial.size()), 0x03 };
+
+        for (char c : serial)
+            g_serialDescriptor.insert(g_serialDescriptor.end(), { static_cast<uint8_t>(c), 0 });
+    }
+
+    void printUsage(const char* program)
+    {
+        std::printf("Usage: %s [options]\n"
+                    "  --seed <n>       Seed for measurement noise and injected bus errors\n"
+                    "  --serial <text>  Serial number reported by the board\n"
+                    "  --flash <file>   Keeps the user page in the given file across runs\n"
+                    "  --exec <cmd>     Runs a console command before the firmware starts\n"
+                    "  --protocol       Prints the command summary of Protocol.txt\n"
+                    "  --help           Prints this text and the console commands\n\n",
+                    program);
+
+        Console::printHelp(stdout);
+    }
+
+    // Generates the summary in Protocol.txt so it cannot drift from the table
+    void printProtocol()
+    {
+        std::printf("%-31s %-9s %-31s %s\n", "Command", "Arguments", "Response", "Mode");
+
+        for (const Protocol::CommandInfo& info : Protocol::Commands)
+        {
+            std::string arguments = std::to_string(info.minArguments);
+
+            if (info.maxArguments != info.minArguments)
+                arguments += "-" + std::to_string(info.maxArguments);
+
+            std::string response(info.response);
+
+            if (info.reply == Protocol::Reply::Ok)
+                response = Protocol::OkTag;
+            else if (info.reply == Protocol::Reply::List)
+                response += " ... <OK>";
+
+            const char* mode = (info.modes == Protocol::AnyMode) ? "ANY"
+                             : (info.modes & Protocol::FirmwareMode) ? "FIRMWARE" : "BOOTLOADER";
+
+            std::printf("%-31.*s %-9s %-31s %s\n", static_cast<int>(info.tag.size()),
+                        info.tag.data(), arguments.c_str(), response.c_str(), mode);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+USBD_DescriptorsTypeDef FS_Desc = { &getSerialStrDescriptor };
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HAL_NVIC_SystemReset()
+{
+    std::printf("Firmware requested a system reset, exiting\n");
+    std::exit(0);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main(int argc, char* argv[]) -> int
+{
+    uint64_t seed = 0;
+    std::string serial = "SIMULATOR";
+    std::string flashFile;
+    std::vector<std::string> commands;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string option = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (option == "--seed" && hasValue)
+            seed = std::strtoull(argv[++i], nullptr, 0);
+        else if (option == "--serial" && hasValue)
+            serial = argv[++i];
+        else if (option == "--flash" && hasValue)
+            flashFile = argv[++i];
+        else if (option == "--exec" && hasValue)
+            commands.push_back(argv[++i]);
+        else if (option == "--protocol")
+        {
+            printProtocol();
+            return 0;
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return (option == "--help") ? 0 : 2;
+        }
+    }
+
+    setSerialNumber(serial);
+
+    // Placed at its real address by the linker, see CMakeLists.txt
+    VirtualFlash::addRegion(FLASH_BASE + Config::UserPage * FLASH_PAGE_SIZE, FLASH_PAGE_SIZE,
+                            flashFile);
+
+    VirtualBoard board(seed);
+    Console console(board);
+
+    for (const std::string& command : commands)
+    {
+        if (!console.execute(command))
+            return 2;
+    }
+
+    const std::string port = PseudoTerminal::open();
+
+    if (port.empty())
+    {
+        std::fprintf(stderr, "Unable to create pseudo-terminal: %s\n", std::strerror(errno));
+        return 1;
+    }
+
+    // libIRB expects port names relative to /dev
+    std::printf("RelayBoard simulator listening on %s (port name %s)\n",
+                port.c_str(), port.substr(std::strlen("/dev/")).c_str());
+    std::fflush(stdout);
+
+    console.start();
+
+    user_main();
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
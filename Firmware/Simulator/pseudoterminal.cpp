@@ -0,0 +1,143 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "hostclock.h"
+#include "pseudoterminal.h"
+#include "usbd_cdc_if.h"
+
+#include <atomic>
+#include <cerrno>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    // Full-speed bulk endpoints deliver at most one packet per callback
+    constexpr size_t PacketSize = 64;
+
+    int g_master = -1;
+    int g_slave = -1;
+
+    std::atomic<CDC_ReceiveCallback> g_receiveCallback = nullptr;
+    std::atomic<CDC_TxCompleteCallback> g_txCompleteCallback = nullptr;
+
+    std::atomic<uint64_t> g_packetInterval = 0;
+
+    // Plays the part of the USB interrupt
+    void receive()
+    {
+        uint8_t buffer[PacketSize];
+
+        while (true)
+        {
+            pollfd pfd = { g_master, POLLIN, 0 };
+
+            if (::poll(&pfd, 1, -1) < 0 && errno != EINTR)
+                break;
+
+            const ssize_t count = ::read(g_master, buffer, sizeof(buffer));
+
+            if (count <= 0)
+                continue;
+
+            if (CDC_ReceiveCallback callback = g_receiveCallback)
+                callback(buffer, static_cast<uint32_t>(count));
+
+            if (const uint64_t interval = g_packetInterval)
+                HostClock::spin(interval);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto PseudoTerminal::open() -> std::string
+{
+    g_master = ::posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (g_master < 0 || ::grantpt(g_master) != 0 || ::unlockpt(g_master) != 0)
+        return {};
+
+    const std::string path = ::ptsname(g_master);
+
+    // Kept open so the master never sees a hangup while no host is connected
+    g_slave = ::open(path.c_str(), O_RDWR | O_NOCTTY);
+
+    if (g_slave < 0)
+        return {};
+
+    termios settings = {};
+    ::tcgetattr(g_slave, &settings);
+    ::cfmakeraw(&settings);
+    ::tcsetattr(g_slave, TCSANOW, &settings);
+
+    // Responses are dropped rather than blocking the main loop if nobody reads them
+    ::fcntl(g_master, F_SETFL, ::fcntl(g_master, F_GETFL) | O_NONBLOCK);
+
+    std::thread(receive).detach();
+
+    return path;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void PseudoTerminal::setPacketInterval(uint64_t interval)
+{
+    g_packetInterval = interval;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto CDC_Transmit(uint8_t* buffer, uint16_t size) -> uint8_t
+{
+    const ssize_t count = ::write(g_master, buffer, size);
+
+    if (count != size)
+        return 1; // USBD_BUSY
+
+    if (CDC_TxCompleteCallback callback = g_txCompleteCallback)
+        callback();
+
+    return 0; // USBD_OK
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void CDC_RegisterReceiveCallback(CDC_ReceiveCallback callback)
+{
+    g_receiveCallback = callback;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void CDC_RegisterTxCompleteCallback(CDC_TxCompleteCallback callback)
+{
+    g_txCompleteCallback = callback;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,41 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Carries the USB CDC traffic, the slave side opens like the board's serial port
+class PseudoTerminal
+{
+public:
+    // A full-speed frame carries at most 19 bulk packets of 64 bytes per millisecond
+    static constexpr uint64_t FullSpeedPacketInterval = 1000000 / 19;
+
+    // Returns the slave path or an empty string if no terminal could be created
+    static auto open() -> std::string;
+
+    // Spaces received packets in nanoseconds like the bus would, 0 delivers them at once
+    static void setPacketInterval(uint64_t interval);
+};
@@ -0,0 +1,143 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "config.h"
+#include "ina226.h"
+#include "main.h"
+#include "virtualboard.h"
+#include "virtualgpio.h"
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    // Same wiring as RelayManager, channel i is monitored by the chip at address A0 + i
+    const std::array<GPIO_TypeDef*, VirtualBoard::ChannelCount> Ports = {
+        RELAY01_GPIO_Port, RELAY02_GPIO_Port, RELAY03_GPIO_Port, RELAY04_GPIO_Port,
+        RELAY05_GPIO_Port, RELAY06_GPIO_Port, RELAY07_GPIO_Port, RELAY08_GPIO_Port,
+        RELAY09_GPIO_Port, RELAY10_GPIO_Port, RELAY11_GPIO_Port, RELAY12_GPIO_Port,
+        RELAY13_GPIO_Port, RELAY14_GPIO_Port, RELAY15_GPIO_Port, RELAY16_GPIO_Port
+    };
+
+    constexpr std::array<uint16_t, VirtualBoard::ChannelCount> Pins = {
+        RELAY01_Pin, RELAY02_Pin, RELAY03_Pin, RELAY04_Pin,
+        RELAY05_Pin, RELAY06_Pin, RELAY07_Pin, RELAY08_Pin,
+        RELAY09_Pin, RELAY10_Pin, RELAY11_Pin, RELAY12_Pin,
+        RELAY13_Pin, RELAY14_Pin, RELAY15_Pin, RELAY16_Pin
+    };
+
+    auto addressOf(size_t index) -> uint16_t
+    {
+        return static_cast<uint16_t>(Ina226::Address::A0) + static_cast<uint16_t>(2*index);
+    }
+
+    auto nameOf(Ina226Model::Stuck stuck) -> const char*
+    {
+        switch (stuck)
+        {
+        case Ina226Model::Stuck::Open:
+            return "OPEN";
+
+        case Ina226Model::Stuck::Closed:
+            return "CLOSED";
+
+        default:
+            return "-";
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+VirtualBoard::VirtualBoard(uint64_t seed)
+{
+    for (size_t i = 0; i < ChannelCount; ++i)
+    {
+        m_channels[i] = std::make_unique<Ina226Model>(Config::ShuntResistance, seed + i);
+        VirtualI2cBus::attach(addressOf(i), m_channels[i].get());
+    }
+
+    VirtualGpio::setListener([this](GPIO_TypeDef* port, uint16_t pin, bool state) {
+        const size_t index = channelOf(port, pin);
+
+        if (index < ChannelCount)
+            m_channels[index]->setRelayState(state);
+    });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+VirtualBoard::~VirtualBoard()
+{
+    VirtualGpio::setListener({});
+
+    for (size_t i = 0; i < ChannelCount; ++i)
+        VirtualI2cBus::attach(addressOf(i), nullptr);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto VirtualBoard::channel(size_t index) -> Ina226Model&
+{
+    return *m_channels.at(index);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void VirtualBoard::printStatus(FILE* stream) const
+{
+    std::fprintf(stream, "CH  RELAY  STUCK   CHIP  SUPPLY/V   LOAD/OHM  CURRENT/A\n");
+
+    for (size_t i = 0; i < ChannelCount; ++i)
+    {
+        const Ina226Model& channel = *m_channels[i];
+        const Ina226Model::Load load = channel.load();
+
+        std::fprintf(stream, "%2zu  %-5s  %-6s  %-4s  %8.3f  %9.2f  %9.4f\n",
+                     i, channel.relayState() ? "ON" : "OFF", nameOf(channel.stuck()),
+                     channel.failed() ? "FAIL" : "OK", load.supplyVoltage, load.resistance,
+                     channel.current());
+    }
+
+    const VirtualI2cBus::Statistics statistics = VirtualI2cBus::statistics();
+
+    std::fprintf(stream, "I2C: %u bit/s, %llu transfers, %llu errors (%llu injected)\n",
+                 VirtualI2cBus::bitRate(),
+                 static_cast<unsigned long long>(statistics.transfers),
+                 static_cast<unsigned long long>(statistics.errors),
+                 static_cast<unsigned long long>(statistics.injectedErrors));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto VirtualBoard::channelOf(GPIO_TypeDef* port, uint16_t pin) const -> size_t
+{
+    for (size_t i = 0; i < ChannelCount; ++i)
+    {
+        if (Ports[i] == port && Pins[i] == pin)
+            return i;
+    }
+
+    return ChannelCount;
+}
+
+// ---------------------------------------------------------------------------------------------- //
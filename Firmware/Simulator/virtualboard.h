@@ -0,0 +1,51 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "ina226model.h"
+
+#include <array>
+#include <cstdio>
+#include <memory>
+
+// Sixteen relay channels, each with its INA226 on the virtual bus and its gate on a GPIO pin
+class VirtualBoard
+{
+public:
+    static constexpr size_t ChannelCount = 16;
+
+public:
+    explicit VirtualBoard(uint64_t seed);
+    ~VirtualBoard();
+
+    auto channel(size_t index) -> Ina226Model&;
+
+    void printStatus(FILE* stream) const;
+
+private:
+    auto channelOf(GPIO_TypeDef* port, uint16_t pin) const -> size_t;
+
+private:
+    std::array<std::unique_ptr<Ina226Model>, ChannelCount> m_channels;
+};
@@ -0,0 +1,137 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "virtualcrc.h"
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    // Reset values from the STM32L4 reference manual
+    CRC_TypeDef g_registers = { {}, {}, 0xffffffff, 0x04c11db7 };
+
+    uint32_t g_control = 0;
+    uint32_t g_crc = 0xffffffff;
+
+    bool g_clockEnabled = false;
+    uint64_t g_wordCount = 0;
+
+    // REV_IN reverses the bits of each byte, each half-word or the whole word
+    auto reverseInput(uint32_t value) -> uint32_t
+    {
+        switch (g_control & CRC_CR_REV_IN)
+        {
+        case CRC_CR_REV_IN_0:
+            return __builtin_bswap32(__RBIT(value));
+
+        case CRC_CR_REV_IN_1:
+            value = __RBIT(value);
+            return (value >> 16) | (value << 16);
+
+        case CRC_CR_REV_IN:
+            return __RBIT(value);
+
+        default:
+            return value;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto CRC_TypeDef::DataRegister::operator=(uint32_t value) -> DataRegister&
+{
+    if (!g_clockEnabled)
+        return *this;
+
+    g_crc ^= reverseInput(value);
+
+    for (int i = 0; i < 32; ++i)
+        g_crc = (g_crc & 0x80000000) ? (g_crc << 1) ^ g_registers.POL : g_crc << 1;
+
+    ++g_wordCount;
+
+    return *this;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+CRC_TypeDef::DataRegister::operator uint32_t() const
+{
+    if (!g_clockEnabled)
+        return 0;
+
+    return (g_control & CRC_CR_REV_OUT) ? __RBIT(g_crc) : g_crc;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto CRC_TypeDef::ControlRegister::operator=(uint32_t value) -> ControlRegister&
+{
+    if (!g_clockEnabled)
+        return *this;
+
+    // RESET loads INIT and always reads back as zero
+    if (value & CRC_CR_RESET)
+        g_crc = g_registers.INIT;
+
+    g_control = value & ~CRC_CR_RESET;
+
+    return *this;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+CRC_TypeDef::ControlRegister::operator uint32_t() const
+{
+    return g_clockEnabled ? g_control : 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto sim_crc() -> CRC_TypeDef*
+{
+    return &g_registers;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void sim_crc_set_clock(bool enabled)
+{
+    g_clockEnabled = enabled;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto VirtualCrc::wordCount() -> uint64_t
+{
+    return g_wordCount;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto VirtualCrc::isClockEnabled() -> bool
+{
+    return g_clockEnabled;
+}
+
+// ---------------------------------------------------------------------------------------------- //
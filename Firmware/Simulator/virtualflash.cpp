@@ -0,0 +1,307 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "hostclock.h"
+#include "virtualflash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr uint64_t ErasedWord = 0xffffffffffffffff;
+
+    struct Region
+    {
+        uintptr_t address;
+        size_t size;
+        std::string imageFile;
+    };
+
+    std::vector<Region> g_regions;
+    bool g_locked = true;
+
+    std::atomic<bool> g_timed = false;
+    std::atomic<uint32_t> g_failingPrograms = 0;
+    std::atomic<uint32_t> g_failingErases = 0;
+    std::atomic<float> g_bitErrorRate = 0.0F;
+    std::minstd_rand g_random;
+
+    std::atomic<uint64_t> g_programs = 0;
+    std::atomic<uint64_t> g_erases = 0;
+    std::atomic<uint64_t> g_errors = 0;
+    std::atomic<uint64_t> g_injectedErrors = 0;
+    std::atomic<uint64_t> g_busyTime = 0;
+
+    auto regionOf(uintptr_t address, size_t size) -> Region*
+    {
+        for (Region& region : g_regions)
+        {
+            if (address >= region.address && address + size <= region.address + region.size)
+                return &region;
+        }
+
+        return nullptr;
+    }
+
+    void loadImage(const Region& region)
+    {
+        FILE* file = std::fopen(region.imageFile.c_str(), "rb");
+
+        if (!file)
+            return;
+
+        std::vector<uint8_t> buffer(region.size);
+
+        if (std::fread(buffer.data(), 1, buffer.size(), file) == buffer.size())
+            std::memcpy(reinterpret_cast<void*>(region.address), buffer.data(), buffer.size());
+        else
+            std::fprintf(stderr, "Ignoring incomplete flash image %s\n", region.imageFile.c_str());
+
+        std::fclose(file);
+    }
+
+    void wait(uint64_t nanoseconds)
+    {
+        g_busyTime += nanoseconds;
+
+        if (g_timed)
+            HostClock::spin(nanoseconds);
+    }
+
+    // Consumes one of the requested failures, if any are left
+    auto injectFailure(std::atomic<uint32_t>& remaining) -> bool
+    {
+        uint32_t count = remaining;
+
+        while (count > 0 && !remaining.compare_exchange_weak(count, count - 1))
+            continue;
+
+        if (count == 0)
+            return false;
+
+        ++g_injectedErrors;
+        ++g_errors;
+        return true;
+    }
+
+    // A weak cell leaves one of the bits that should have been cleared set
+    auto injectBitError(uint64_t data) -> uint64_t
+    {
+        const float rate = g_bitErrorRate;
+        const uint64_t cleared = ~data;
+
+        if (rate <= 0.0F || cleared == 0)
+            return data;
+
+        std::uniform_real_distribution<float> distribution(0.0F, 1.0F);
+
+        if (distribution(g_random) >= rate)
+            return data;
+
+        std::uniform_int_distribution<int> bitDistribution(0, std::popcount(cleared) - 1);
+        uint64_t bits = cleared;
+
+        for (int i = bitDistribution(g_random); i > 0; --i)
+            bits &= bits - 1;
+
+        ++g_injectedErrors;
+        return data | (bits & -bits);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void VirtualFlash::addRegion(uintptr_t address, size_t size, const std::string& imageFile)
+{
+    const Region region = { address, size, imageFile };
+
+    if (!imageFile.empty())
+        loadImage(region);
+
+    g_regions.push_back(region);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void VirtualFlash::saveImages()
+{
+    for (const Region& region : g_regions)
+    {
+        if (region.imageFile.empty())
+            continue;
+
+        FILE* file = std::fopen(region.imageFile.c_str(), "wb");
+
+        if (!file)
+        {
+            std::fprintf(stderr, "Unable to write flash image %s\n", region.imageFile.c_str());
+            continue;
+        }
+
+        std::fwrite(reinterpret_cast<const void*>(region.address), 1, region.size, file);
+        std::fclose(file);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void VirtualFlash::setTimed(bool timed)
+{
+    g_timed = timed;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void VirtualFlash::failPrograms(uint32_t count)
+{
+    g_failingPrograms = count;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void VirtualFlash::failErases(uint32_t count)
+{
+    g_failingErases = count;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void VirtualFlash::setBitErrorRate(float rate)
+{
+    g_bitErrorRate = std::clamp(rate, 0.0F, 1.0F);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto VirtualFlash::corrupt(uintptr_t address, uint8_t bit) -> bool
+{
+    if (!regionOf(address, 1) || bit >= 8)
+        return false;
+
+    auto byte = reinterpret_cast<volatile uint8_t*>(address);
+    *byte = *byte ^ static_cast<uint8_t>(1 << bit);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto VirtualFlash::statistics() -> Statistics
+{
+    return { g_programs, g_erases, g_errors, g_injectedErrors, g_busyTime };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HAL_FLASH_Unlock() -> HAL_StatusTypeDef
+{
+    g_locked = false;
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HAL_FLASH_Lock() -> HAL_StatusTypeDef
+{
+    // Images are only written back once the firmware is done programming
+    if (!g_locked)
+        VirtualFlash::saveImages();
+
+    g_locked = true;
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HAL_FLASH_Program(uint32_t typeProgram, uint32_t address, uint64_t data) -> HAL_StatusTypeDef
+{
+    ++g_programs;
+
+    const bool valid = !g_locked && typeProgram == FLASH_TYPEPROGRAM_DOUBLEWORD &&
+                       address % sizeof(uint64_t) == 0 && regionOf(address, sizeof(uint64_t));
+
+    // A doubleword can only be programmed once after an erase
+    auto word = reinterpret_cast<volatile uint64_t*>(static_cast<uintptr_t>(address));
+
+    if (!valid || *word != ErasedWord)
+    {
+        ++g_errors;
+        return HAL_ERROR;
+    }
+
+    wait(VirtualFlash::ProgramTime);
+
+    if (injectFailure(g_failingPrograms))
+        return HAL_ERROR;
+
+    *word = injectBitError(data);
+
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef* eraseInit, uint32_t* pageError) -> HAL_StatusTypeDef
+{
+    *pageError = 0xffffffff;
+
+    if (g_locked || eraseInit->TypeErase != FLASH_TYPEERASE_PAGES)
+    {
+        ++g_errors;
+        return HAL_ERROR;
+    }
+
+    for (uint32_t page = eraseInit->Page; page < eraseInit->Page + eraseInit->NbPages; ++page)
+    {
+        const uintptr_t address = FLASH_BASE + page * FLASH_PAGE_SIZE;
+
+        ++g_erases;
+
+        if (!regionOf(address, FLASH_PAGE_SIZE))
+        {
+            ++g_errors;
+            *pageError = page;
+            return HAL_ERROR;
+        }
+
+        wait(VirtualFlash::PageEraseTime);
+
+        if (injectFailure(g_failingErases))
+        {
+            *pageError = page;
+            return HAL_ERROR;
+        }
+
+        std::memset(reinterpret_cast<void*>(address), 0xff, FLASH_PAGE_SIZE);
+    }
+
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,70 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "stm32l4xx_hal.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Flash controller model, programs and erases the host memory the firmware reads back directly
+class VirtualFlash
+{
+public:
+    // Typical values from the STM32L412 datasheet, in nanoseconds
+    static constexpr uint64_t ProgramTime = 81690;
+    static constexpr uint64_t PageEraseTime = 22020000;
+
+    struct Statistics
+    {
+        uint64_t programs;
+        uint64_t erases;
+        uint64_t errors;
+        uint64_t injectedErrors;
+        uint64_t busyTime;
+    };
+
+public:
+    // The region must be page aligned, writes outside all regions fail like protected pages
+    static void addRegion(uintptr_t address, size_t size, const std::string& imageFile = {});
+
+    // Writes back all regions with an image file, also done whenever the flash is locked
+    static void saveImages();
+
+    // Makes programming and erasing take as long as on the chip, off by default
+    static void setTimed(bool timed);
+
+    // The next count operations of that kind fail as if the controller reported an error
+    static void failPrograms(uint32_t count);
+    static void failErases(uint32_t count);
+
+    // Probability of a programmed doubleword keeping one of its cleared bits set, 0 to 1
+    static void setBitErrorRate(float rate);
+
+    // Flips a bit as if a cell had lost its charge, fails outside all regions
+    static auto corrupt(uintptr_t address, uint8_t bit) -> bool;
+
+    static auto statistics() -> Statistics;
+};
@@ -0,0 +1,81 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "virtualgpio.h"
+
+#include <array>
+#include <atomic>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    constexpr size_t PortCount = 3;
+
+    std::array<std::atomic<uint16_t>, PortCount> g_outputs = {};
+    VirtualGpio::Listener g_listener;
+
+    auto outputOf(GPIO_TypeDef* port) -> std::atomic<uint16_t>&
+    {
+        return g_outputs.at(port->index);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+GPIO_TypeDef sim_gpio_ports[PortCount] = { { 0 }, { 1 }, { 2 } };
+
+// ---------------------------------------------------------------------------------------------- //
+
+void VirtualGpio::setListener(Listener listener)
+{
+    g_listener = std::move(listener);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto VirtualGpio::state(GPIO_TypeDef* port, uint16_t pin) -> bool
+{
+    return (outputOf(port) & pin) != 0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state)
+{
+    const uint16_t previous = (state == GPIO_PIN_SET) ? outputOf(port).fetch_or(pin)
+                                                      : outputOf(port).fetch_and(~pin);
+
+    const bool changed = ((previous & pin) != 0) != (state == GPIO_PIN_SET);
+
+    if (changed && g_listener)
+        g_listener(port, pin, state == GPIO_PIN_SET);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin) -> GPIO_PinState
+{
+    return VirtualGpio::state(port, pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,208 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "hostclock.h"
+#include "virtuali2c.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <random>
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    // Every byte is followed by an ACK bit, each address byte is preceded by a (repeated) start
+    constexpr uint32_t AddressBits = 1 + 9;
+    constexpr uint32_t RegisterBits = 9;
+    constexpr uint32_t DataBits = 9;
+    constexpr uint32_t StopBits = 1;
+
+    constexpr size_t AddressCount = 128;
+
+    // Standard mode and enabled, as left behind by MX_I2C1_Init() in Core/Src/main.c
+    constexpr uint32_t ResetTiming = 0x10909CEC;
+
+    I2C_TypeDef g_i2c1 = { I2C_CR1_PE, ResetTiming };
+
+    std::array<I2cDevice*, AddressCount> g_devices = {};
+
+    std::atomic<float> g_errorRate = 0.0F;
+    std::minstd_rand g_random;
+
+    std::atomic<uint64_t> g_transfers = 0;
+    std::atomic<uint64_t> g_errors = 0;
+    std::atomic<uint64_t> g_injectedErrors = 0;
+
+    auto deviceAt(uint16_t address) -> I2cDevice*
+    {
+        return g_devices.at((address >> 1) % AddressCount);
+    }
+
+    void waitForBits(uint32_t bits)
+    {
+        HostClock::spin(bits * 1000000000ULL / VirtualI2cBus::bitRate());
+    }
+
+    auto injectError() -> bool
+    {
+        const float rate = g_errorRate;
+
+        if (rate <= 0.0F)
+            return false;
+
+        std::uniform_real_distribution<float> distribution(0.0F, 1.0F);
+        return distribution(g_random) < rate;
+    }
+
+    auto beginTransfer(I2C_HandleTypeDef* handle, uint16_t address) -> I2cDevice*
+    {
+        ++g_transfers;
+
+        if ((handle->Instance->CR1 & I2C_CR1_PE) == 0)
+        {
+            ++g_errors;
+            return nullptr;
+        }
+
+        I2cDevice* device = deviceAt(address);
+
+        if (device && injectError())
+        {
+            ++g_injectedErrors;
+            device = nullptr;
+        }
+
+        if (!device)
+        {
+            // Address byte is NACKed, the master sends a stop right away
+            waitForBits(AddressBits + StopBits);
+            ++g_errors;
+        }
+
+        return device;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+I2C_HandleTypeDef hi2c1 = { &g_i2c1, { ResetTiming } };
+
+// ---------------------------------------------------------------------------------------------- //
+
+void VirtualI2cBus::attach(uint16_t address, I2cDevice* device)
+{
+    g_devices.at((address >> 1) % AddressCount) = device;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void VirtualI2cBus::setErrorRate(float rate)
+{
+    g_errorRate = std::clamp(rate, 0.0F, 1.0F);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto VirtualI2cBus::errorRate() -> float
+{
+    return g_errorRate;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto VirtualI2cBus::bitRate() -> uint32_t
+{
+    const uint32_t timing = g_i2c1.TIMINGR;
+
+    const uint32_t prescaler = (timing >> 28) & 0x0f;
+    const uint32_t high = (timing >> 8) & 0xff;
+    const uint32_t low = timing & 0xff;
+
+    const uint32_t clocks = (prescaler + 1) * (high + 1 + low + 1);
+    return HostClock::CoreClock / clocks;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto VirtualI2cBus::statistics() -> Statistics
+{
+    return { g_transfers, g_errors, g_injectedErrors };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HAL_I2C_Mem_Write(I2C_HandleTypeDef* handle, uint16_t address, uint16_t memAddress,
+                       uint16_t, uint8_t* data, uint16_t size, uint32_t) -> HAL_StatusTypeDef
+{
+    I2cDevice* device = beginTransfer(handle, address);
+
+    if (!device)
+        return HAL_ERROR;
+
+    waitForBits(AddressBits + RegisterBits + size*DataBits + StopBits);
+
+    if (!device->writeRegister(static_cast<uint8_t>(memAddress), data, size))
+    {
+        ++g_errors;
+        return HAL_ERROR;
+    }
+
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto HAL_I2C_Mem_Read(I2C_HandleTypeDef* handle, uint16_t address, uint16_t memAddress,
+                      uint16_t, uint8_t* data, uint16_t size, uint32_t) -> HAL_StatusTypeDef
+{
+    I2cDevice* device = beginTransfer(handle, address);
+
+    if (!device)
+        return HAL_ERROR;
+
+    // Register pointer write, then a repeated start for the read
+    waitForBits(2*AddressBits + RegisterBits + size*DataBits + StopBits);
+
+    if (!device->readRegister(static_cast<uint8_t>(memAddress), data, size))
+    {
+        ++g_errors;
+        return HAL_ERROR;
+    }
+
+    return HAL_OK;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HAL_I2CEx_EnableFastModePlus(uint32_t)
+{
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void HAL_I2CEx_DisableFastModePlus(uint32_t)
+{
+}
+
+// ---------------------------------------------------------------------------------------------- //
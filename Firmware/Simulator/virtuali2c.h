@@ -0,0 +1,63 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "stm32l4xx_hal.h"
+
+#include <cstddef>
+#include <cstdint>
+
+class I2cDevice
+{
+public:
+    virtual ~I2cDevice() = default;
+
+    // Returning false makes the device NACK the transfer
+    virtual auto writeRegister(uint8_t reg, const uint8_t* data, size_t size) -> bool = 0;
+    virtual auto readRegister(uint8_t reg, uint8_t* data, size_t size) -> bool = 0;
+};
+
+class VirtualI2cBus
+{
+public:
+    struct Statistics
+    {
+        uint64_t transfers;
+        uint64_t errors;
+        uint64_t injectedErrors;
+    };
+
+public:
+    // Addresses are given left-aligned, as passed to the HAL
+    static void attach(uint16_t address, I2cDevice* device);
+
+    // Probability of an injected NACK per transfer, 0 to 1
+    static void setErrorRate(float rate);
+    static auto errorRate() -> float;
+
+    // Derived from TIMINGR the same way the peripheral generates SCL
+    static auto bitRate() -> uint32_t;
+
+    static auto statistics() -> Statistics;
+};
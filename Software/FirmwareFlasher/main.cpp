@@ -0,0 +1,373 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "device.h"
+#include "firmwarewriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------- //
+
+using namespace irb::Private;
+using namespace std::chrono_literals;
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr const char* BoardName = "RelayBoard";
+
+    // Boards acknowledge a launch request and reset half a second later
+    constexpr auto ResetDelay = 1s;
+    constexpr auto RetryInterval = 250ms;
+
+    struct Options
+    {
+        std::string hexFile;
+        std::vector<std::string> ports;
+        size_t jobs = 0;
+        std::chrono::seconds timeout = 10s;
+        bool launch = true;
+    };
+
+    struct Report
+    {
+        std::string port;
+        std::string error;
+        std::string firmwareVersion;
+        double switchTime = 0.0;
+        double writeTime = 0.0;
+        double totalTime = 0.0;
+        size_t writtenBytes = 0;
+    };
+
+    std::mutex g_outputMutex;
+
+    void printUsage(const char* program)
+    {
+        std::printf("Usage: %s [options] <file.hex> [port ...]\n"
+                    "  --jobs <n>       Maximum number of boards flashed at once, default all\n"
+                    "  --timeout <s>    Time allowed for a board to restart, default 10\n"
+                    "  --no-launch      Leaves the boards in the bootloader after flashing\n"
+                    "  --help           Prints this text\n\n"
+                    "Without ports, every serial port answering as %s is flashed.\n",
+                    program, BoardName);
+    }
+
+    auto secondsSince(Clock::time_point start) -> double
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    auto readHexFile(const std::string& filename) -> std::vector<std::string>
+    {
+        std::ifstream file(filename);
+
+        if (!file)
+            throw irb::Error("Unable to open " + filename + ".");
+
+        std::vector<std::string> records;
+        std::string line;
+
+        while (std::getline(file, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+
+            if (!line.empty())
+                records.push_back(line);
+        }
+
+        // The bootloader only checks the image once it sees the end-of-file record
+        if (records.empty() || records.back().compare(0, 9, ":00000001") != 0)
+            throw irb::Error(filename + " is not a complete Intel HEX file.");
+
+        return records;
+    }
+
+    auto listSerialPorts() -> std::vector<std::string>
+    {
+        std::vector<std::string> ports;
+
+#if defined(__linux__)
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator("/dev", error))
+        {
+            const std::string name = entry.path().filename().string();
+
+            if (name.starts_with("ttyACM"))
+                ports.push_back(name);
+        }
+
+        std::sort(ports.begin(), ports.end());
+#elif defined(_WIN32)
+        for (int i = 1; i <= 256; ++i)
+            ports.push_back("COM" + std::to_string(i));
+#endif
+
+        return ports;
+    }
+
+    auto isBoard(const std::string& port) -> bool
+    {
+        try {
+            return Device(port.c_str()).getBoardName() == BoardName;
+        }
+        catch (const irb::Error&) {
+            return false;
+        }
+    }
+
+    // Ports are probed concurrently, each one that is not a board costs a full timeout
+    auto findBoards() -> std::vector<std::string>
+    {
+        std::vector<std::string> candidates = listSerialPorts();
+        std::vector<std::future<bool>> probes;
+
+        for (const std::string& port : candidates)
+            probes.push_back(std::async(std::launch::async, isBoard, port));
+
+        std::vector<std::string> boards;
+
+        for (size_t i = 0; i < candidates.size(); ++i)
+        {
+            if (probes.at(i).get())
+                boards.push_back(candidates.at(i));
+        }
+
+        return boards;
+    }
+
+    // A board disappears while restarting and comes back under the same port name
+    auto reopen(const std::string& port, Device::BootMode mode, std::chrono::seconds timeout)
+        -> std::unique_ptr<Device>
+    {
+        std::this_thread::sleep_for(ResetDelay);
+
+        const Clock::time_point deadline = Clock::now() + timeout;
+        std::string error = "Wrong boot mode.";
+
+        do {
+            try {
+                auto device = std::make_unique<Device>(port.c_str());
+
+                if (device->getBootMode() == mode)
+                    return device;
+            }
+            catch (const irb::Error& e) {
+                error = e.what();
+            }
+
+            std::this_thread::sleep_for(RetryInterval);
+        }
+        while (Clock::now() < deadline);
+
+        throw irb::Error("Board did not restart: " + error);
+    }
+
+    void flashBoard(const Options& options, const std::vector<std::string>& records,
+                    Report& report)
+    {
+        const Clock::time_point start = Clock::now();
+
+        auto device = std::make_unique<Device>(report.port.c_str());
+
+        if (device->getBoardName() != BoardName)
+            throw irb::Error("Device is not a " + std::string(BoardName) + ".");
+
+        if (device->getBootMode() != Device::BootMode::Bootloader)
+        {
+            device->launchBootloader();
+            device.reset();
+
+            device = reopen(report.port, Device::BootMode::Bootloader, options.timeout);
+        }
+
+        report.switchTime = secondsSince(start);
+
+        const Clock::time_point writeStart = Clock::now();
+
+        FirmwareWriter writer(device.get());
+        writer.unlockFirmware();
+
+        const size_t sectorCount = device->getSectorCount();
+
+        for (size_t i = 0; i < sectorCount; ++i)
+            writer.eraseSector(i);
+
+        for (const std::string& record : records)
+            writer.writeHexRecord(record);
+
+        writer.lockFirmware();
+
+        if (!device->getFirmwareValid())
+            throw irb::Error("Firmware image is invalid after writing.");
+
+        report.writeTime = secondsSince(writeStart);
+        report.writtenBytes = writer.getWrittenBytes();
+
+        if (options.launch)
+        {
+            device->launchFirmware();
+            device.reset();
+
+            device = reopen(report.port, Device::BootMode::Firmware, options.timeout);
+            report.firmwareVersion = device->getFirmwareVersion();
+        }
+
+        report.totalTime = secondsSince(start);
+    }
+
+    void printReport(const Report& report)
+    {
+        const std::lock_guard lock(g_outputMutex);
+
+        if (!report.error.empty())
+        {
+            std::printf("%-16s FAILED: %s\n", report.port.c_str(), report.error.c_str());
+            return;
+        }
+
+        const double throughput = (report.writeTime > 0.0)
+                                ? report.writtenBytes / 1024.0 / report.writeTime : 0.0;
+
+        std::printf("%-16s OK  bootloader %5.2f s  write %5.2f s (%6.1f KiB sent, %6.1f KiB/s)  "
+                    "total %5.2f s  %s\n", report.port.c_str(), report.switchTime,
+                    report.writeTime, report.writtenBytes / 1024.0, throughput,
+                    report.totalTime, report.firmwareVersion.c_str());
+
+        std::fflush(stdout);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto main(int argc, char* argv[]) -> int
+{
+    Options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string option = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (option == "--jobs" && hasValue)
+            options.jobs = std::strtoul(argv[++i], nullptr, 0);
+        else if (option == "--timeout" && hasValue)
+            options.timeout = std::chrono::seconds(std::strtoul(argv[++i], nullptr, 0));
+        else if (option == "--no-launch")
+            options.launch = false;
+        else if (!option.starts_with("--") && options.hexFile.empty())
+            options.hexFile = option;
+        else if (!option.starts_with("--"))
+            options.ports.push_back(option);
+        else
+        {
+            printUsage(argv[0]);
+            return (option == "--help") ? 0 : 2;
+        }
+    }
+
+    if (options.hexFile.empty())
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<std::string> records;
+
+    try {
+        records = readHexFile(options.hexFile);
+    }
+    catch (const irb::Error& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    if (options.ports.empty())
+        options.ports = findBoards();
+
+    if (options.ports.empty())
+    {
+        std::fprintf(stderr, "No boards found.\n");
+        return 1;
+    }
+
+    const size_t jobs = (options.jobs > 0) ? std::min(options.jobs, options.ports.size())
+                                           : options.ports.size();
+
+    std::printf("Flashing %zu board(s), %zu at a time...\n", options.ports.size(), jobs);
+    std::fflush(stdout);
+
+    // Every board gets its own thread, the semaphore limits how many are busy at once
+    std::counting_semaphore<> slots(static_cast<std::ptrdiff_t>(jobs));
+    std::vector<Report> reports(options.ports.size());
+    std::vector<std::thread> threads;
+
+    const Clock::time_point start = Clock::now();
+
+    for (size_t i = 0; i < options.ports.size(); ++i)
+    {
+        reports.at(i).port = options.ports.at(i);
+
+        threads.emplace_back([&, i] {
+            slots.acquire();
+
+            try {
+                flashBoard(options, records, reports.at(i));
+            }
+            catch (const irb::Error& e) {
+                reports.at(i).error = e.what();
+            }
+
+            slots.release();
+            printReport(reports.at(i));
+        });
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    const auto failed = std::count_if(reports.begin(), reports.end(),
+                                      [](const Report& report) { return !report.error.empty(); });
+
+    std::printf("%zu of %zu board(s) flashed in %.2f s\n", reports.size() - failed,
+                reports.size(), secondsSince(start));
+
+    return (failed == 0) ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------------------------- //
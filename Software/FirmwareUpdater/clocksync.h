@@ -0,0 +1 @@
+../libIRB/clocksync.h
\ No newline at end of file
@@ -32,7 +32,8 @@ using namespace irb::Private;
 // ---------------------------------------------------------------------------------------------- //
 
 Component::Component(Device* device)
-    : m_device(device)
+    : m_device(device),
+      m_writer(device)
 {
     assert(device != nullptr);
 }
@@ -91,28 +92,28 @@ void Component::launchFirmware()
 
 void Component::unlockFirmware()
 {
-    m_device->unlockFirmware();
+    m_writer.unlockFirmware();
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void Component::lockFirmware()
 {
-    m_device->lockFirmware();
+    m_writer.lockFirmware();
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void Component::eraseSector(size_t sector)
 {
-    m_device->eraseSector(sector);
+    m_writer.eraseSector(sector);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void Component::writeHexRecord(const std::string& record)
 {
-    m_device->writeHexRecord(record);
+    m_writer.writeHexRecord(record);
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -24,6 +24,7 @@
 #pragma once
 
 #include "device.h"
+#include "firmwarewriter.h"
 
 #include <FirmwareUpdater/Core/component.h>
 
@@ -48,4 +49,5 @@ public:
 
 private:
     irb::Private::Device* m_device;
+    irb::Private::FirmwareWriter m_writer;
 };
@@ -0,0 +1 @@
+../libIRB/firmwarewriter.h
\ No newline at end of file
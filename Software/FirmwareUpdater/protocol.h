@@ -0,0 +1 @@
+../libIRB/protocol.h
\ No newline at end of file
@@ -0,0 +1,157 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "clocksync.h"
+using namespace irb::Private;
+
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------------------- //
+
+void ClockSync::reset()
+{
+    m_points.clear();
+
+    m_referenceTime = 0.0;
+    m_offset = 0.0;
+    m_drift = 0.0;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto ClockSync::update(const std::vector<Exchange>& exchanges) -> ClockStatus
+{
+    if (exchanges.empty())
+        throw irb::Error("No clock exchanges provided.");
+
+    // Queueing delays only ever add to the round trip, so the fastest exchange is the most
+    // symmetric one and gives the best offset estimate
+    const auto roundTrip = [](const Exchange& e) {
+        const double host = toMicroseconds(e.returned) - toMicroseconds(e.sent);
+        const double device = static_cast<double>(e.transmitted - e.received);
+        return host - device;
+    };
+
+    const auto best = std::min_element(exchanges.begin(), exchanges.end(),
+                                       [&](const auto& a, const auto& b) {
+        return roundTrip(a) < roundTrip(b);
+    });
+
+    const double sent = toMicroseconds(best->sent);
+    const double returned = toMicroseconds(best->returned);
+
+    const double offset = ((static_cast<double>(best->received) - sent) +
+                           (static_cast<double>(best->transmitted) - returned)) / 2.0;
+
+    // Device time running backwards means the board has been reset
+    if (!m_points.empty() && best->received < m_points.back().deviceTime)
+        m_points.clear();
+
+    m_points.push_back({ (sent + returned) / 2.0, offset, roundTrip(*best), best->transmitted });
+
+    if (m_points.size() > MaximumPointCount)
+        m_points.pop_front();
+
+    fit();
+    return status();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto ClockSync::status() const -> ClockStatus
+{
+    if (m_points.empty())
+        return { 0.0, 0.0, 0.0 };
+
+    const Point& last = m_points.back();
+    const double offset = m_offset + m_drift * (last.hostTime - m_referenceTime);
+
+    return { offset * 1e-6, m_drift * 1e6, last.roundTrip * 1e-6 };
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto ClockSync::toHostTime(uint64_t deviceTime) const -> Clock::time_point
+{
+    if (m_points.empty())
+        throw irb::Error("Clock has not been synchronized.");
+
+    // Inverts deviceTime = hostTime + offset + drift * (hostTime - referenceTime)
+    const double hostTime = (static_cast<double>(deviceTime) - m_offset + m_drift * m_referenceTime)
+                                / (1.0 + m_drift);
+
+    const auto duration = std::chrono::duration<double, std::micro>(hostTime);
+    return Clock::time_point(std::chrono::duration_cast<Clock::duration>(duration));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void ClockSync::fit()
+{
+    const Point& last = m_points.back();
+    const Point& first = m_points.front();
+
+    if (last.hostTime - first.hostTime < MinimumDriftSpan)
+    {
+        m_referenceTime = last.hostTime;
+        m_offset = last.offset;
+        m_drift = 0.0;
+        return;
+    }
+
+    // Least-squares line through all offsets
+    double meanTime = 0.0;
+    double meanOffset = 0.0;
+
+    for (const auto& point : m_points)
+    {
+        meanTime += point.hostTime;
+        meanOffset += point.offset;
+    }
+
+    meanTime /= m_points.size();
+    meanOffset /= m_points.size();
+
+    double covariance = 0.0;
+    double variance = 0.0;
+
+    for (const auto& point : m_points)
+    {
+        const double dt = point.hostTime - meanTime;
+        covariance += dt * (point.offset - meanOffset);
+        variance += dt * dt;
+    }
+
+    m_referenceTime = meanTime;
+    m_offset = meanOffset;
+    m_drift = covariance / variance;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto ClockSync::toMicroseconds(Clock::time_point time) -> double
+{
+    return std::chrono::duration<double, std::micro>(time.time_since_epoch()).count();
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,81 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include <irb.h>
+
+#include <chrono>
+#include <deque>
+#include <vector>
+
+namespace irb::Private {
+
+class ClockSync
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t MaximumPointCount = 32;
+
+    // Minimum time span covered by sync points before drift is estimated
+    static constexpr double MinimumDriftSpan = 10e6; // us
+
+    struct Exchange
+    {
+        Clock::time_point sent;
+        uint64_t received;    // Device time, us
+        uint64_t transmitted; // Device time, us
+        Clock::time_point returned;
+    };
+
+public:
+    void reset();
+
+    auto update(const std::vector<Exchange>& exchanges) -> ClockStatus;
+    auto status() const -> ClockStatus;
+
+    auto toHostTime(uint64_t deviceTime) const -> Clock::time_point;
+
+private:
+    struct Point
+    {
+        double hostTime;  // us
+        double offset;    // us, device minus host
+        double roundTrip; // us
+        uint64_t deviceTime;
+    };
+
+    void fit();
+
+    static auto toMicroseconds(Clock::time_point time) -> double;
+
+private:
+    std::deque<Point> m_points;
+
+    double m_referenceTime = 0.0;
+    double m_offset = 0.0;
+    double m_drift = 0.0;
+};
+
+} // End of namespace irb::Private
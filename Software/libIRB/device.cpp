@@ -22,8 +22,13 @@
 // ============================================================================================== //
 
 #include "device.h"
+#include "lzssencoder.h"
 using namespace irb::Private;
+using Protocol::Command;
 
+#include <algorithm>
+#include <fstream>
+#include <optional>
 #include <sstream>
 
 // ---------------------------------------------------------------------------------------------- //
@@ -66,6 +71,12 @@ namespace {
         return is;
     }
 
+    auto operator<<(std::ostream& os, irb::FilterTarget target) -> std::ostream&
+    {
+        os << ((target == irb::FilterTarget::Fault) ? "FAULT" : "REPORT");
+        return os;
+    }
+
     template <typename T>
     auto to(const std::string& s) -> T
     {
@@ -91,6 +102,78 @@ namespace {
 
 // ---------------------------------------------------------------------------------------------- //
 
+namespace {
+    // Profiles as saved by the RelayBoard application, i.e. a "Profile" group in INI format
+    // holding keys Voltage00 to Voltage15 and Current00 to Current15.
+    auto readProfileFile(const std::string& fileName) -> irb::PowerLimitArray
+    {
+        std::ifstream file(fileName);
+
+        if (!file)
+            throw irb::Error("Unable to open profile file '" + fileName + "'.");
+
+        std::array<std::optional<double>, irb::RelayCount> voltages;
+        std::array<std::optional<double>, irb::RelayCount> currents;
+
+        std::string group;
+        std::string line;
+
+        while (std::getline(file, line))
+        {
+            const size_t first = line.find_first_not_of(" \t\r");
+            const size_t last = line.find_last_not_of(" \t\r");
+
+            if (first == std::string::npos || line[first] == ';' || line[first] == '#')
+                continue;
+
+            line = line.substr(first, last - first + 1);
+
+            if (line.front() == '[' && line.back() == ']')
+            {
+                group = line.substr(1, line.length() - 2);
+                continue;
+            }
+
+            const size_t separator = line.find('=');
+
+            if (group != "Profile" || separator == std::string::npos)
+                continue;
+
+            const std::string key = line.substr(0, line.find_last_not_of(" \t", separator - 1) + 1);
+            const std::string value = line.substr(separator + 1);
+
+            for (size_t i = 0; i < irb::RelayCount; ++i)
+            {
+                const std::string number = (i < 10 ? "0" : "") + toString(i);
+
+                try {
+                    if (key == "Voltage" + number)
+                        voltages.at(i) = to<double>(value);
+                    else if (key == "Current" + number)
+                        currents.at(i) = to<double>(value);
+                }
+                catch (...) {
+                    throw irb::Error("Invalid value for " + key + " in profile file.");
+                }
+            }
+        }
+
+        irb::PowerLimitArray limits = {};
+
+        for (size_t i = 0; i < irb::RelayCount; ++i)
+        {
+            if (!voltages.at(i) || !currents.at(i))
+                throw irb::Error("Incomplete profile file '" + fileName + "'.");
+
+            limits.at(i) = { *voltages.at(i), *currents.at(i) };
+        }
+
+        return limits;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 class InvalidResponseError : public irb::Error
 {
 public:
@@ -100,119 +183,744 @@ public:
 
 // ---------------------------------------------------------------------------------------------- //
 
+namespace {
+    auto encodeRequest(const Protocol::CommandInfo& info,
+                       const std::string& arguments) -> std::string
+    {
+        const size_t count = arguments.empty()
+                             ? 0 : split(arguments, Protocol::TokenSeparator).size();
+
+        if (count < info.minArguments || count > info.maxArguments)
+            throw irb::Error("Invalid number of arguments for " + std::string(info.tag) + ".");
+
+        std::string request(info.tag);
+
+        if (!arguments.empty())
+            request += Protocol::TokenSeparator + arguments;
+
+        return request;
+    }
+
+    // Request line and attachment, sequence is empty unless uploading. Blocks that compress are
+    // sent as WRITE_PACKED_BLOCK, the checksum always covers the unpacked data.
+    auto encodeBlock(uint32_t address, std::span<const uint8_t> data,
+                     const std::string& sequence) -> std::vector<uint8_t>
+    {
+        if (data.empty() || data.size() > Device::MaximumBlockSize)
+            throw irb::Error("Invalid block size.");
+
+        static_assert(Device::MaximumBlockSize <= LzssEncoder::MaximumDistance);
+
+        const std::vector<uint8_t> packed = LzssEncoder::encode(data);
+        const bool usePacked = packed.size() < data.size();
+
+        std::ostringstream arguments;
+        arguments << "0x" << std::hex << address << " " << std::dec << data.size()
+                  << ",0x" << std::hex << Device::computeChecksum(data);
+
+        if (usePacked)
+            arguments << "," << std::dec << packed.size();
+
+        if (!sequence.empty())
+            arguments << " " << sequence;
+
+        const Command command = usePacked ? Command::WritePackedBlock : Command::WriteBlock;
+        const std::string line = encodeRequest(Protocol::info(command), arguments.str()) + "\r\n";
+
+        std::vector<uint8_t> request(line.begin(), line.end());
+
+        if (usePacked)
+            request.insert(request.end(), packed.begin(), packed.end());
+        else
+            request.insert(request.end(), data.begin(), data.end());
+
+        return request;
+    }
+
+    // Failures that sending the same request again may cure
+    auto isTransient(const std::string& error) -> bool
+    {
+        return error == "INVALID_CHECKSUM" || error == "INVALID_RECORD" ||
+               error == "INVALID_SEQUENCE" || error == "BLOCK_TIMEOUT" ||
+               error == "INVALID_DATA";
+    }
+
+    constexpr auto UploadTimeout = 2s;
+    constexpr int MaxUploadRetries = 3;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 Device::Device(const char* port)
     : m_port(port)
 {
 }
 
-// ---------------------------------------------------------------------------------------------- //
+// ---------------------------------------------------------------------------------------------- //
+
+Device::~Device() = default;
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::reset()
+{
+    sendCommand(Command::Reset);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::setRelayState(size_t index, RelayState state)
+{
+    sendCommand(Command::SetRelayState, toString(index) + " " + toString(state));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getRelayState(size_t index) const -> RelayState
+{
+    return parseRelayState(sendCommand(Command::GetRelayState, toString(index)));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getFaultMask() const -> uint16_t
+{
+    return parseULong(sendCommand(Command::GetFaultMask));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::clearFault(size_t index)
+{
+    sendCommand(Command::ClearFault, toString(index));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::setReclosePolicy(size_t index, const ReclosePolicy& policy)
+{
+    if (policy.retryCount > irb::MaximumRecloseRetryCount)
+        throw irb::Error("Invalid argument for retry count.");
+
+    if (policy.delay < irb::MinimumRecloseDelay || policy.delay > irb::MaximumRecloseDelay)
+        throw irb::Error("Invalid argument for reclose delay.");
+
+    if (policy.lockoutCount > irb::MaximumLockoutCount)
+        throw irb::Error("Invalid argument for lockout count.");
+
+    sendCommand(Command::SetReclosePolicy, toString(index) + " "
+                                           + toString(policy.retryCount) + ","
+                                           + toString(policy.delay) + ","
+                                           + toString(policy.lockoutCount));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getReclosePolicy(size_t index) const -> ReclosePolicy
+{
+    const std::string response = sendCommand(Command::GetReclosePolicy, toString(index));
+    const std::vector<std::string> values = split(response, ',');
+
+    try {
+        if (values.size() == 3)
+            return { to<size_t>(values.at(0)), to<size_t>(values.at(1)), to<size_t>(values.at(2)) };
+    }
+    catch (...) {
+    }
+
+    throw InvalidResponseError(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getRecloseStatus(size_t index) const -> RecloseStatus
+{
+    static const std::array<std::string, 4> states = {
+        "ACTIVE", "PENDING", "EXHAUSTED", "LOCKED"
+    };
+
+    const std::string response = sendCommand(Command::GetRecloseStatus, toString(index));
+    const std::vector<std::string> values = split(response, ',');
+
+    if (values.size() == 3 && std::find(states.begin(), states.end(), values.at(2)) != states.end())
+    {
+        try {
+            return {
+                to<size_t>(values.at(0)),
+                to<size_t>(values.at(1)),
+                values.at(2) == "LOCKED",
+                values.at(2) == "PENDING",
+                values.at(2) == "EXHAUSTED"
+            };
+        }
+        catch (...) {
+        }
+    }
+
+    throw InvalidResponseError(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::setStateMask(uint16_t mask)
+{
+    sendCommand(Command::SetStateMask, toString(mask));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getStateMask() const -> uint16_t
+{
+    return parseULong(sendCommand(Command::GetStateMask));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getRelayPower(size_t index) const -> RelayPower
+{
+    return parseRelayPower(sendCommand(Command::GetRelayPower, toString(index)));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getRelayWattage(size_t index) const -> double
+{
+    return parseDouble(sendCommand(Command::GetRelayWattage, toString(index)));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getEnergyCounters() const -> EnergyCounterArray
+{
+    const std::vector<std::string> lines = sendListCommand(Command::GetEnergyCounters);
+    if (lines.size() != RelayCount)
+        throw Error("Invalid number of energy counters received from device.");
+
+    EnergyCounterArray counters = {};
+
+    for (const auto& line : lines)
+    {
+        const auto [index, values] = parseIndexedValues(line, 3, RelayCount);
+        counters.at(index) = { values.at(0), values.at(1), values.at(2) };
+    }
+
+    return counters;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::resetEnergyCounters()
+{
+    sendCommand(Command::ResetEnergyCounters);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::resetEnergyCounter(size_t index)
+{
+    sendCommand(Command::ResetEnergyCounters, toString(index));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::setBusSpeed(BusSpeed speed)
+{
+    static const std::array<std::string, 3> speeds = {
+        "STANDARD", "FAST", "FAST_PLUS"
+    };
+
+    sendCommand(Command::SetBusSpeed, speeds.at(static_cast<size_t>(speed)));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getBusSpeed() const -> BusSpeed
+{
+    static const std::array<std::string, 3> speeds = {
+        "STANDARD", "FAST", "FAST_PLUS"
+    };
+
+    const std::string speed = sendCommand(Command::GetBusSpeed);
+
+    const auto it = std::find(speeds.begin(), speeds.end(), speed);
+
+    if (it == speeds.end())
+        throw InvalidResponseError(speed);
+
+    return static_cast<BusSpeed>(it - speeds.begin());
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::setFilter(size_t index, FilterTarget target, const FilterSettings& settings)
+{
+    if (settings.medianLength < 1 || settings.medianLength > irb::MaximumMedianLength)
+        throw irb::Error("Invalid argument for median length.");
+
+    if (settings.timeConstant < 0.0 || settings.timeConstant > irb::MaximumTimeConstant)
+        throw irb::Error("Invalid argument for time constant.");
+
+    sendCommand(Command::SetFilter, toString(index) + " "
+                                    + toString(target) + ","
+                                    + toString(settings.medianLength) + ","
+                                    + toString(settings.timeConstant));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getFilter(size_t index, FilterTarget target) const -> FilterSettings
+{
+    const std::string response = sendCommand(Command::GetFilter, toString(index) + " "
+                                                                 + toString(target));
+
+    const std::vector<std::string> values = split(response, ',');
+
+    try {
+        return { to<size_t>(values.at(0)), to<double>(values.at(1)) };
+    }
+    catch (...) {
+    }
+
+    throw InvalidResponseError(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::armCapture(size_t index, uint8_t triggerMask, double threshold)
+{
+    std::string arguments = toString(index) + " " + toString(+triggerMask);
+
+    if (triggerMask & ThresholdTrigger)
+        arguments += "," + toString(threshold);
+
+    sendCommand(Command::ArmCapture, arguments);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::disarmCapture()
+{
+    sendCommand(Command::DisarmCapture);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getCaptureStatus() const -> CaptureStatus
+{
+    static const std::array<std::string, 4> states = {
+        "IDLE", "ARMED", "TRIGGERED", "COMPLETE"
+    };
+
+    const std::string response = sendCommand(Command::GetCaptureStatus);
+    const std::vector<std::string> values = split(response, ',');
+
+    if (values.size() == 4)
+    {
+        const auto it = std::find(states.begin(), states.end(), values.at(0));
+
+        if (it != states.end())
+        {
+            try {
+                const auto state = static_cast<CaptureState>(it - states.begin());
+                const auto index = std::stoul(values.at(1));
+                const auto trigger = std::stoul(values.at(2), nullptr, 16);
+                const auto time = std::stoull(values.at(3));
+
+                return { state, index, static_cast<uint8_t>(trigger), time };
+            }
+            catch (...) {
+            }
+        }
+    }
+
+    throw InvalidResponseError(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::readCapture() const -> CaptureSampleVector
+{
+    const std::vector<std::string> lines = sendListCommand(Command::ReadCapture);
+
+    CaptureSampleVector samples;
+
+    for (const auto& line : lines)
+    {
+        const auto [index, values] = parseIndexedValues(line, 3, CaptureSampleCount);
+
+        if (index != samples.size())
+            throw InvalidResponseError(line);
+
+        samples.push_back({ values.at(0) * 1e-6, values.at(1), values.at(2) });
+    }
+
+    return samples;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::characterizeRelay(size_t index)
+{
+    sendCommand(Command::CharacterizeRelay, toString(index));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getCharacterizationStatus() const -> CharacterizationStatus
+{
+    static const std::array<std::string, 4> states = {
+        "IDLE", "RUNNING", "COMPLETE", "FAILED"
+    };
+
+    const std::string response = sendCommand(Command::GetCharacterizationStatus);
+    const std::vector<std::string> values = split(response, ',');
+    if (values.size() == 2)
+    {
+        const auto it = std::find(states.begin(), states.end(), values.at(0));
+
+        if (it != states.end())
+        {
+            try {
+                const auto state = static_cast<CharacterizationState>(it - states.begin());
+                return { state, to<size_t>(values.at(1)) };
+            }
+            catch (...) {
+            }
+        }
+    }
+
+    throw InvalidResponseError(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getSwitchTiming(size_t index) const -> SwitchTiming
+{
+    const std::string response = sendCommand(Command::GetSwitchTiming, toString(index));
+    const std::vector<std::string> values = split(response, ',');
+
+    try {
+        if (values.size() == 5)
+        {
+            return {
+                to<uint32_t>(values.at(0)) * 1e-6,
+                to<uint32_t>(values.at(1)) * 1e-6,
+                to<uint32_t>(values.at(2)) * 1e-6,
+                to<uint32_t>(values.at(3)) * 1e-6,
+                to<uint32_t>(values.at(4)) * 1e-6
+            };
+        }
+    }
+    catch (...) {
+    }
+
+    throw InvalidResponseError(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getJournalStatus() const -> JournalStatus
+{
+    const std::string response = sendCommand(Command::GetJournalStatus);
+    const std::vector<std::string> values = split(response, ',');
+
+    try {
+        return { to<uint32_t>(values.at(0)), to<uint32_t>(values.at(1)) };
+    }
+    catch (...) {
+    }
+
+    throw InvalidResponseError(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::readJournal(uint32_t cursor, size_t count) const -> JournalEntryVector
+{
+    static const std::array<std::string, 19> events = {
+        "BOOT", "RELAY_ON", "RELAY_OFF", "FAULT", "I2C_ERROR", "LIMIT_CHANGE", "LIMITS_SAVED",
+        "RESET", "TIMESTAMPS", "CAPTURE_ARMED", "CAPTURE_DISARMED", "CAPTURE_TRIGGERED",
+        "PROFILE_STORED", "PROFILE_LOADED", "BUS_SPEED",
+        "CHARACTERIZED", "RECLOSE", "LOCKOUT", "FAULT_CLEARED"
+    };
+
+    const std::vector<std::string> lines = sendListCommand(Command::ReadJournal,
+                                                           toString(cursor) + ","
+                                                           + toString(count));
+
+    JournalEntryVector entries;
+
+    for (const auto& line : lines)
+    {
+        const std::vector<std::string> tokens = split(line, ' ');
+        const std::vector<std::string> values = split(tokens.back(), ',');
+
+        if (tokens.size() != 2 || values.size() != 5)
+            throw InvalidResponseError(line);
+
+        const auto it = std::find(events.begin(), events.end(), values.at(1));
+
+        if (it == events.end())
+            throw InvalidResponseError(line);
+
+        try {
+            entries.push_back({
+                to<uint32_t>(tokens.at(0)),
+                std::stoull(values.at(0)),
+                static_cast<JournalEvent>(it - events.begin()),
+                to<int>(values.at(2)),
+                to<double>(values.at(3)),
+                to<double>(values.at(4))
+            });
+        }
+        catch (...) {
+            throw InvalidResponseError(line);
+        }
+    }
+
+    return entries;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getPerfCounters() const -> PerfCounterVector
+{
+    const std::vector<std::string> lines = sendListCommand(Command::GetPerfCounters);
+    PerfCounterVector counters;
+
+    for (const auto& line : lines)
+    {
+        const std::vector<std::string> tokens = split(line, ' ');
+        const std::vector<std::string> values = split(tokens.back(), ',');
+
+        try {
+            const bool valid = tokens.size() == 2 && values.size() == 5 &&
+                               to<size_t>(tokens.at(0)) == counters.size();
+            if (!valid)
+                throw std::exception();
+
+            counters.push_back({ values.at(0),
+                                 to<uint32_t>(values.at(1)), to<uint32_t>(values.at(2)),
+                                 to<uint32_t>(values.at(3)), to<uint32_t>(values.at(4)), {} });
+        }
+        catch (...) {
+            throw InvalidResponseError(line);
+        }
+    }
+
+    const std::vector<std::string> histograms = sendListCommand(Command::GetPerfHistograms);
+    if (histograms.size() != counters.size())
+        throw Error("Invalid number of performance histograms received from device.");
+
+    for (const auto& line : histograms)
+    {
+        const auto [index, values] = parseIndexedValues(line, PerfHistogramBinCount,
+                                                        counters.size());
+
+        for (size_t i = 0; i < PerfHistogramBinCount; ++i)
+            counters.at(index).histogram.at(i) = static_cast<uint16_t>(values.at(i));
+    }
+
+    return counters;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::resetPerfCounters()
+{
+    sendCommand(Command::ResetPerfCounters);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getDeviceTime() const -> uint64_t
+{
+    const std::string response = sendCommand(Command::GetDeviceTime);
+    const std::vector<std::string> values = split(response, ',');
+
+    try {
+        return std::stoull(values.at(1));
+    }
+    catch (...) {
+    }
+
+    throw InvalidResponseError(response);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::setTimestampsEnabled(bool enabled)
+{
+    sendCommand(Command::SetTimestamps, enabled ? "ON" : "OFF");
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getLastResponseTime() const -> uint64_t
+{
+    return m_lastResponseTime;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::synchronizeClock(size_t rounds) -> ClockStatus
+{
+    if (rounds == 0)
+        throw irb::Error("Invalid argument for number of rounds.");
+
+    std::vector<ClockSync::Exchange> exchanges;
+
+    for (size_t i = 0; i < rounds; ++i)
+    {
+        const auto sent = ClockSync::Clock::now();
+        const std::string response = sendCommand(Command::GetDeviceTime);
+        const auto returned = ClockSync::Clock::now();
 
-Device::~Device() = default;
+        const std::vector<std::string> values = split(response, ',');
+
+        try {
+            exchanges.push_back({ sent, std::stoull(values.at(0)),
+                                  std::stoull(values.at(1)), returned });
+        }
+        catch (...) {
+            throw InvalidResponseError(response);
+        }
+    }
+
+    return m_clockSync.update(exchanges);
+}
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Device::reset()
+auto Device::toHostTime(uint64_t deviceTime) const -> std::chrono::steady_clock::time_point
 {
-    const std::string response = sendRequest("<RESET>");
-
-    if (response != "<OK>")
-        throw InvalidResponseError(response);
+    return m_clockSync.toHostTime(deviceTime);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Device::setRelayState(size_t index, RelayState state)
+void Device::setPowerLimit(size_t index, RelayPower power)
 {
-    const std::string request = "<SET_RELAY_STATE> " + toString(index) + " " + toString(state);
-    const std::string response = sendRequest(request);
+    if (power.voltage < irb::MinimumVoltageLimit || power.voltage > irb::MaximumVoltageLimit)
+        throw irb::Error("Invalid argument for voltage limit.");
 
-    if (response != "<OK>")
-        throw InvalidResponseError(response);
+    if (power.current < irb::MinimumCurrentLimit || power.current > irb::MaximumCurrentLimit)
+        throw irb::Error("Invalid argument for current limit.");
+
+    sendCommand(Command::SetPowerLimit, toString(index) + " "
+                                        + toString(power.voltage) + "," + toString(power.current));
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Device::getRelayState(size_t index) const -> RelayState
+auto Device::getPowerLimit(size_t index) const -> RelayPower
 {
-    const std::string response = sendRequest("<GET_RELAY_STATE> " + toString(index));
-    return parseRelayState(response, "<RELAY_STATE>");
+    return parseRelayPower(sendCommand(Command::GetPowerLimit, toString(index)));
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Device::getFaultMask() const -> uint16_t
+void Device::savePowerLimits()
 {
-    const std::string response = sendRequest("<GET_FAULT_MASK>");
-    return parseULong(response, "<FAULT_MASK>");
+    const auto timeout = 1s;
+    sendCommand(Command::SavePowerLimits, {}, timeout);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Device::setStateMask(uint16_t mask)
+void Device::storeProfile(size_t index, const std::string& name, const PowerLimitArray& limits)
 {
-    const std::string response = sendRequest("<SET_STATE_MASK> " + toString(mask));
+    const bool nameValid = !name.empty() && name.length() <= MaximumProfileNameLength &&
+                           std::all_of(name.begin(), name.end(), [](char c) {
+                               return c > ' ' && c <= '~' && c != ',';
+                           });
+    if (!nameValid)
+        throw irb::Error("Invalid profile name.");
+
+    for (size_t i = 0; i < RelayCount; ++i)
+    {
+        const RelayPower& power = limits.at(i);
 
-    if (response != "<OK>")
-        throw InvalidResponseError(response);
-}
+        if (power.voltage < irb::MinimumVoltageLimit || power.voltage > irb::MaximumVoltageLimit)
+            throw irb::Error("Invalid argument for voltage limit.");
 
-// ---------------------------------------------------------------------------------------------- //
+        if (power.current < irb::MinimumCurrentLimit || power.current > irb::MaximumCurrentLimit)
+            throw irb::Error("Invalid argument for current limit.");
 
-auto Device::getStateMask() const -> uint16_t
-{
-    const std::string response = sendRequest("<GET_STATE_MASK>");
-    return parseULong(response, "<STATE_MASK>");
+        sendCommand(Command::SetProfileLimit, toString(i) + " "
+                                              + toString(power.voltage) + ","
+                                              + toString(power.current));
+    }
+
+    const auto timeout = 1s;
+    sendCommand(Command::StoreProfile, toString(index) + " " + name, timeout);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Device::getRelayPower(size_t index) const -> RelayPower
+void Device::storeProfileFile(size_t index, const std::string& name, const std::string& fileName)
 {
-    const std::string response = sendRequest("<GET_RELAY_POWER> " + toString(index));
-    return parseRelayPower(response, "<RELAY_POWER>");
+    storeProfile(index, name, readProfileFile(fileName));
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Device::setPowerLimit(size_t index, RelayPower power)
+auto Device::getProfiles() const -> ProfileInfoVector
 {
-    if (power.voltage < irb::MinimumVoltageLimit || power.voltage > irb::MaximumVoltageLimit)
-        throw irb::Error("Invalid argument for voltage limit.");
+    const std::vector<std::string> lines = sendListCommand(Command::GetProfiles);
 
-    if (power.current < irb::MinimumCurrentLimit || power.current > irb::MaximumCurrentLimit)
-        throw irb::Error("Invalid argument for current limit.");
+    ProfileInfoVector profiles;
 
-    const std::string response = sendRequest("<SET_POWER_LIMIT> " + toString(index) + " "
-                                        + toString(power.voltage) + "," + toString(power.current));
-    if (response != "<OK>")
-        throw InvalidResponseError(response);
+    for (const auto& line : lines)
+    {
+        const std::vector<std::string> tokens = split(line, ' ');
+
+        try {
+            if (tokens.size() != 2 || to<size_t>(tokens.at(0)) >= ProfileCount)
+                throw std::exception();
+
+            profiles.push_back({ to<size_t>(tokens.at(0)), tokens.at(1) });
+        }
+        catch (...) {
+            throw InvalidResponseError(line);
+        }
+    }
+
+    return profiles;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Device::getPowerLimit(size_t index) const -> RelayPower
+auto Device::getProfileLimits(size_t index) const -> PowerLimitArray
 {
-    const std::string response = sendRequest("<GET_POWER_LIMIT> " + toString(index));
-    return parseRelayPower(response, "<POWER_LIMIT>");
+    const std::vector<std::string> lines = sendListCommand(Command::GetProfileLimits,
+                                                           toString(index));
+    if (lines.size() != RelayCount)
+        throw Error("Invalid number of profile limits received from device.");
+
+    PowerLimitArray limits = {};
+
+    for (const auto& line : lines)
+    {
+        const auto [relay, values] = parseIndexedValues(line, 2, RelayCount);
+        limits.at(relay) = { values.at(0), values.at(1) };
+    }
+
+    return limits;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Device::savePowerLimits()
+void Device::loadProfile(size_t index)
 {
-    const auto timeout = 1s;
-    const std::string response = sendRequest("<SAVE_POWER_LIMITS>", timeout);
-
-    if (response != "<OK>")
-        throw InvalidResponseError(response);
+    sendCommand(Command::LoadProfile, toString(index));
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 auto Device::getBootMode() const -> BootMode
 {
-    const std::string response = sendRequest("<GET_BOOT_MODE>");
-    const std::string mode = parseString(response, "<BOOT_MODE>");
+    const std::string mode = sendCommand(Command::GetBootMode);
 
     if (mode == "BOOTLOADER")
         return BootMode::Bootloader;
@@ -220,101 +928,129 @@ auto Device::getBootMode() const -> BootMode
     if (mode == "FIRMWARE")
         return BootMode::Firmware;
 
-    throw InvalidResponseError(response);
+    throw InvalidResponseError(mode);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 auto Device::getBoardName() const -> std::string
 {
-    const std::string response = sendRequest("<GET_BOARD_NAME>");
-    return parseString(response, "<BOARD_NAME>");
+    return sendCommand(Command::GetBoardName);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 auto Device::getHardwareVersion() const -> std::string
 {
-    const std::string response = sendRequest("<GET_HARDWARE_VERSION>");
-    return parseString(response, "<HARDWARE_VERSION>");
+    return sendCommand(Command::GetHardwareVersion);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 auto Device::getFirmwareVersion() const -> std::string
 {
-    const std::string response = sendRequest("<GET_FIRMWARE_VERSION>");
-    return parseString(response, "<FIRMWARE_VERSION>");
+    return sendCommand(Command::GetFirmwareVersion);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 auto Device::getSerialNumber() const -> std::string
 {
-    const std::string response = sendRequest("<GET_SERIAL_NUMBER>");
-    return parseString(response, "<SERIAL_NUMBER>");
+    return sendCommand(Command::GetSerialNumber);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 auto Device::getBuildTimestamp() const -> unsigned long
 {
-    const std::string response = sendRequest("<GET_BUILD_TIMESTAMP>");
-    return parseULong(response, "<BUILD_TIMESTAMP>");
+    return parseULong(sendCommand(Command::GetBuildTimestamp));
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void Device::launchBootloader()
 {
-    const std::string response = sendRequest("<LAUNCH_BOOTLOADER>");
-
-    if (response != "<OK>")
-        throw InvalidResponseError(response);
+    sendCommand(Command::LaunchBootloader);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 auto Device::getBootloaderVersion() const -> std::string
 {
-    const std::string response = sendRequest("<GET_BOOTLOADER_VERSION>");
-    return parseString(response, "<BOOTLOADER_VERSION>");
+    return sendCommand(Command::GetBootloaderVersion);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 auto Device::getSectorCount() const -> size_t
 {
-    const std::string response = sendRequest("<GET_SECTOR_COUNT>");
-    return parseULong(response, "<SECTOR_COUNT>");
+    return parseULong(sendCommand(Command::GetSectorCount));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getSectorChecksums() const -> std::vector<SectorChecksum>
+{
+    const std::vector<std::string> lines = sendListCommand(Command::GetSectorChecksums);
+
+    std::vector<SectorChecksum> sectors;
+
+    for (const auto& line : lines)
+    {
+        const std::vector<std::string> tokens = split(line, ' ');
+
+        if (tokens.size() != 2 || parseULong(tokens.at(0)) != sectors.size())
+            throw InvalidResponseError(line);
+
+        const std::vector<std::string> values = split(tokens.at(1), ',');
+
+        if (values.size() != 2)
+            throw InvalidResponseError(line);
+
+        sectors.push_back({
+            static_cast<uint32_t>(parseULong(values.at(0))),
+            static_cast<uint32_t>(parseULong(values.at(1)))
+        });
+    }
+
+    return sectors;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getRangeChecksum(uint32_t address, size_t size) const -> uint32_t
+{
+    std::ostringstream arguments;
+    arguments << "0x" << std::hex << address << std::dec << " " << size;
+
+    return static_cast<uint32_t>(parseULong(sendCommand(Command::GetRangeChecksum,
+                                                        arguments.str())));
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 auto Device::getFirmwareValid() const -> bool
 {
-    const std::string response = sendRequest("<GET_FIRMWARE_VALID>");
-    return parseULong(response, "<FIRMWARE_VALID>");
+    return parseULong(sendCommand(Command::GetFirmwareValid));
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void Device::unlockFirmware()
 {
-    const std::string response = sendRequest("<UNLOCK_FIRMWARE>");
+    sendCommand(Command::UnlockFirmware);
 
-    if (response != "<OK>")
-        throw InvalidResponseError(response);
+    m_uploads.clear();
+    m_uploadSequence = 0;
+    m_uploadBytes = 0;
+    m_uploadRetries = 0;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
 void Device::lockFirmware()
 {
-    const std::string response = sendRequest("<LOCK_FIRMWARE>");
-
-    if (response != "<OK>")
-        throw InvalidResponseError(response);
+    sendCommand(Command::LockFirmware);
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -322,10 +1058,15 @@ void Device::lockFirmware()
 void Device::eraseSector(size_t sector)
 {
     const auto timeout = 2s;
-    const std::string response = sendRequest("<ERASE_SECTOR> " + toString(sector), timeout);
+    sendCommand(Command::EraseSector, toString(sector), timeout);
+}
 
-    if (response != "<OK>")
-        throw InvalidResponseError(response);
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::eraseTail(size_t firstSector)
+{
+    const auto timeout = 20s;
+    sendCommand(Command::EraseTail, toString(firstSector), timeout);
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -333,20 +1074,74 @@ void Device::eraseSector(size_t sector)
 void Device::writeHexRecord(const std::string& record)
 {
     const auto timeout = 1s;
-    const std::string response = sendRequest("<WRITE_HEX_RECORD> " + record, timeout);
+    sendCommand(Command::WriteHexRecord, record, timeout);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::writeBlock(uint32_t address, std::span<const uint8_t> data)
+{
+    const auto timeout = 1s;
+
+    m_buffer.clear();
+    m_port.sendData(encodeBlock(address, data, {}));
+
+    const std::string response = receiveResponse(timeout);
+    checkError(response);
 
-    if (response != "<OK>")
+    if (response != Protocol::OkTag)
         throw InvalidResponseError(response);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
+void Device::uploadHexRecord(const std::string& record)
+{
+    const uint32_t sequence = m_uploadSequence + m_uploads.size();
+    const std::string request = encodeRequest(Protocol::info(Command::WriteHexRecord),
+                                              record + " " + toString(sequence)) + "\r\n";
+
+    queueUpload(std::vector<uint8_t>(request.begin(), request.end()));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::uploadBlock(uint32_t address, std::span<const uint8_t> data)
+{
+    const uint32_t sequence = m_uploadSequence + m_uploads.size();
+    queueUpload(encodeBlock(address, data, toString(sequence)));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::finishUpload()
+{
+    while (!m_uploads.empty())
+        receiveUploadReply();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void Device::launchFirmware()
 {
-    const std::string response = sendRequest("<LAUNCH_FIRMWARE>");
+    sendCommand(Command::LaunchFirmware);
+}
 
-    if (response != "<OK>")
-        throw InvalidResponseError(response);
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::computeChecksum(std::span<const uint8_t> data) -> uint32_t
+{
+    uint32_t crc = 0x00000000;
+
+    for (uint8_t byte : data)
+    {
+        crc ^= byte;
+
+        for (int i = 0; i < 8; ++i)
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+    }
+
+    return crc;
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -354,94 +1149,227 @@ void Device::launchFirmware()
 auto Device::sendRequest(std::string request,
                          std::chrono::milliseconds timeout) const -> std::string
 {
+    m_buffer.clear();
+
     request += "\r\n";
     m_port.sendData(std::vector<uint8_t>(request.begin(), request.end()));
 
-    const bool dataAvailable = m_port.waitForDataAvailable(timeout);
+    const std::string response = receiveResponse(timeout);
 
-    if (!dataAvailable)
-        throw Error("Request timed out.");
+    checkError(response);
+    return response;
+}
 
-    const std::vector<uint8_t> data = m_port.readAllData();
-    std::string response(data.begin(), data.end());
+// ---------------------------------------------------------------------------------------------- //
 
-    static const std::string lineBreak = "\r\n";
+auto Device::sendCommand(Protocol::Command command, const std::string& arguments,
+                         std::chrono::milliseconds timeout) const -> std::string
+{
+    const Protocol::CommandInfo& info = Protocol::info(command);
+    const std::string response = sendRequest(encodeRequest(info, arguments), timeout);
 
-    if (!response.ends_with(lineBreak))
-        throw InvalidResponseError(response);
+    if (info.reply == Protocol::Reply::Ok)
+    {
+        if (response != Protocol::OkTag)
+            throw InvalidResponseError(response);
 
-    response.erase(response.size() - lineBreak.size());
+        return {};
+    }
 
-    checkError(response);
-    return response;
+    const std::vector<std::string> tokens = split(response, Protocol::TokenSeparator);
+
+    if (tokens.size() == 2 && tokens.at(0) == info.response)
+        return tokens.at(1);
+
+    throw InvalidResponseError(response);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-void Device::checkError(const std::string& response) const
+auto Device::sendListCommand(Protocol::Command command, const std::string& arguments,
+                             std::chrono::milliseconds timeout) const -> std::vector<std::string>
 {
-    const std::string tag = response.substr(0, response.find_first_of(' '));
+    const Protocol::CommandInfo& info = Protocol::info(command);
 
-    if (tag == "<ERROR>")
+    std::string response = sendRequest(encodeRequest(info, arguments), timeout);
+    std::vector<std::string> lines;
+
+    while (response != Protocol::OkTag)
     {
-        const std::string error = response.substr(tag.length() + 1);
-        throw Error(mapError(error));
+        const std::string tag = response.substr(0, response.find_first_of(' '));
+
+        if (tag != info.response || tag.length() == response.length())
+            throw InvalidResponseError(response);
+
+        lines.push_back(response.substr(tag.length() + 1));
+
+        response = receiveResponse(timeout);
+        checkError(response);
     }
+
+    return lines;
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Device::parseString(const std::string& response,
-                         const std::string& expectedTag) const -> std::string
+auto Device::receiveResponse(std::chrono::milliseconds timeout) const -> std::string
 {
-    const std::vector<std::string> tokens = split(response, ' ');
+    static const std::string lineBreak = "\r\n";
 
-    if (tokens.size() == 2 && tokens.at(0) == expectedTag)
-        return tokens.at(1);
+    size_t position = m_buffer.find(lineBreak);
 
-    throw InvalidResponseError(response);
+    while (position == std::string::npos)
+    {
+        const bool dataAvailable = m_port.waitForDataAvailable(timeout);
+
+        if (!dataAvailable)
+        {
+            if (m_buffer.empty())
+                throw Error("Request timed out.");
+
+            throw InvalidResponseError(m_buffer);
+        }
+
+        const std::vector<uint8_t> data = m_port.readAllData();
+        m_buffer.append(data.begin(), data.end());
+
+        position = m_buffer.find(lineBreak);
+    }
+
+    std::string response = m_buffer.substr(0, position);
+    m_buffer.erase(0, position + lineBreak.size());
+
+    // Strip optional device time stamp
+    const size_t marker = response.rfind(" @");
+
+    if (marker != std::string::npos)
+    {
+        const std::string time = response.substr(marker + 2);
+
+        if (!time.empty() && time.find_first_not_of("0123456789") == std::string::npos)
+        {
+            m_lastResponseTime = std::stoull(time);
+            response.erase(marker);
+        }
+    }
+
+    return response;
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::queueUpload(std::vector<uint8_t> request)
+{
+    if (m_uploads.empty())
+        m_buffer.clear();
+
+    while (!m_uploads.empty() && m_uploadBytes + request.size() > Protocol::UploadWindow)
+        receiveUploadReply();
+
+    m_port.sendData(request);
+
+    m_uploadBytes += request.size();
+    m_uploads.push_back(std::move(request));
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::receiveUploadReply()
+{
+    const std::string response = receiveResponse(UploadTimeout);
+    checkError(response);
+
+    const std::vector<std::string> tokens = split(response, Protocol::TokenSeparator);
+
+    if (tokens.size() != 2)
+        throw InvalidResponseError(response);
+
+    const std::vector<std::string> values = split(tokens.at(1), Protocol::ValueSeparator);
+    const unsigned long sequence = parseULong(values.at(0));
+
+    const auto acknowledge = [this](unsigned long last) {
+        while (!m_uploads.empty() && m_uploadSequence <= last)
+        {
+            m_uploadBytes -= m_uploads.front().size();
+            m_uploads.pop_front();
+            ++m_uploadSequence;
+        }
+    };
+
+    if (tokens.at(0) == Protocol::UploadAckTag && values.size() == 1)
+    {
+        acknowledge(sequence);
+        m_uploadRetries = 0;
+    }
+    else if (tokens.at(0) == Protocol::UploadNakTag && values.size() == 2)
+    {
+        // Everything before the failed request has been written
+        if (sequence > 0)
+            acknowledge(sequence - 1);
+
+        if (m_uploads.empty() || m_uploadSequence != sequence)
+            throw InvalidResponseError(response);
+
+        const std::string& error = values.at(1);
+
+        if (!isTransient(error) || ++m_uploadRetries > MaxUploadRetries)
+            throw Error(mapError(error));
+
+        // Requests sent after the failed one may still be waiting in the bootloader, which drops
+        // them. A plain request is only answered once they are gone and there is room again.
+        sendCommand(Command::GetBootMode);
+
+        for (const std::vector<uint8_t>& request : m_uploads)
+            m_port.sendData(request);
+    }
+    else
+        throw InvalidResponseError(response);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Device::parseULong(const std::string& response,
-                        const std::string& expectedTag) const -> unsigned long
+void Device::checkError(const std::string& response) const
 {
-    const std::string value = parseString(response, expectedTag);
+    const std::string tag = response.substr(0, response.find_first_of(' '));
+
+    if (tag == Protocol::ErrorTag)
+    {
+        const std::string error = response.substr(tag.length() + 1);
+        throw Error(mapError(error));
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
 
+auto Device::parseULong(const std::string& value) const -> unsigned long
+{
     try {
         return std::stoul(value, nullptr, 0);
     }
     catch (...) {
     }
 
-    throw InvalidResponseError(response);
+    throw InvalidResponseError(value);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Device::parseRelayState(const std::string& response,
-                             const std::string& expectedTag) const -> RelayState
+auto Device::parseRelayState(const std::string& value) const -> RelayState
 {
-    const std::string state = parseString(response, expectedTag);
-
     try {
-        return to<RelayState>(state);
+        return to<RelayState>(value);
     }
     catch (...) {
     }
 
-    throw InvalidResponseError(response);
+    throw InvalidResponseError(value);
 }
 
 // ---------------------------------------------------------------------------------------------- //
 
-auto Device::parseRelayPower(const std::string& response,
-                             const std::string& expectedTag) const -> RelayPower
+auto Device::parseRelayPower(const std::string& value) const -> RelayPower
 {
-    const std::string power = parseString(response, expectedTag);
-
-    const std::vector<std::string> values = split(power, ',');
+    const std::vector<std::string> values = split(value, ',');
 
     if (values.size() == 2)
     {
@@ -454,7 +1382,55 @@ auto Device::parseRelayPower(const std::string& response,
         }
     }
 
-    throw InvalidResponseError(response);
+    throw InvalidResponseError(value);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::parseDouble(const std::string& value) const -> double
+{
+    try {
+        return to<double>(value);
+    }
+    catch (...) {
+    }
+
+    throw InvalidResponseError(value);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::parseIndexedValues(const std::string& line,
+                                size_t valueCount, size_t indexCount) const
+                                    -> std::pair<size_t, std::vector<double>>
+{
+    const std::vector<std::string> tokens = split(line, ' ');
+
+    if (tokens.size() == 2)
+    {
+        const std::vector<std::string> values = split(tokens.at(1), ',');
+
+        if (values.size() == valueCount)
+        {
+            try {
+                const auto index = to<size_t>(tokens.at(0));
+
+                if (index < indexCount)
+                {
+                    std::vector<double> result;
+
+                    for (const auto& value : values)
+                        result.push_back(to<double>(value));
+
+                    return { index, result };
+                }
+            }
+            catch (...) {
+            }
+        }
+    }
+
+    throw InvalidResponseError(line);
 }
 
 // ---------------------------------------------------------------------------------------------- //
@@ -488,6 +1464,33 @@ auto Device::mapError(const std::string& error) -> std::string
     if (error == "DATA_MISMATCH")
         return "Data mismatch.";
 
+    if (error == "INVALID_CHECKSUM")
+        return "Invalid checksum.";
+
+    if (error == "BLOCK_TIMEOUT")
+        return "Block transfer timed out.";
+
+    if (error == "INVALID_SEQUENCE")
+        return "Invalid sequence number.";
+
+    if (error == "INVALID_DATA")
+        return "Invalid compressed data.";
+
+    if (error == "CAPTURE_INCOMPLETE")
+        return "Capture incomplete.";
+
+    if (error == "PROFILE_EMPTY")
+        return "Profile empty.";
+
+    if (error == "SAMPLING_BUSY")
+        return "Sampling busy.";
+
+    if (error == "RELAY_FAULT")
+        return "Relay fault.";
+
+    if (error == "NOT_CHARACTERIZED")
+        return "Not characterized.";
+
     return "Unknown error code received: " + error;
 }
 
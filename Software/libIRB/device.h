@@ -23,10 +23,14 @@
 
 #pragma once
 
+#include "clocksync.h"
+#include "protocol.h"
 #include "serialport.h"
 
 #include <irb.h>
 
+#include <deque>
+
 namespace irb::Private {
 
 class IRB_EXPORT Device
@@ -40,6 +44,16 @@ public:
 
     static constexpr std::chrono::milliseconds DefaultTimeout = SerialPort::DefaultTimeout;
 
+    // One flash sector, blocks must not be larger
+    static constexpr size_t MaximumBlockSize = 2048;
+
+    // Flash contents as reported by the bootloader, sectors are MaximumBlockSize bytes each
+    struct SectorChecksum
+    {
+        uint32_t address;
+        uint32_t checksum;
+    };
+
 public:
     Device(const char* port);
     ~Device();
@@ -51,16 +65,62 @@ public:
 
     auto getFaultMask() const -> uint16_t;
 
+    void clearFault(size_t index);
+
+    void setReclosePolicy(size_t index, const ReclosePolicy& policy);
+    auto getReclosePolicy(size_t index) const -> ReclosePolicy;
+    auto getRecloseStatus(size_t index) const -> RecloseStatus;
+
     void setStateMask(uint16_t mask);
     auto getStateMask() const -> uint16_t;
 
     auto getRelayPower(size_t index) const -> RelayPower;
+    auto getRelayWattage(size_t index) const -> double;
+
+    auto getEnergyCounters() const -> EnergyCounterArray;
+    void resetEnergyCounters();
+    void resetEnergyCounter(size_t index);
+
+    void setBusSpeed(BusSpeed speed);
+    auto getBusSpeed() const -> BusSpeed;
+
+    void setFilter(size_t index, FilterTarget target, const FilterSettings& settings);
+    auto getFilter(size_t index, FilterTarget target) const -> FilterSettings;
+
+    void armCapture(size_t index, uint8_t triggerMask, double threshold);
+    void disarmCapture();
+    auto getCaptureStatus() const -> CaptureStatus;
+    auto readCapture() const -> CaptureSampleVector;
+
+    void characterizeRelay(size_t index);
+    auto getCharacterizationStatus() const -> CharacterizationStatus;
+    auto getSwitchTiming(size_t index) const -> SwitchTiming;
+
+    auto getJournalStatus() const -> JournalStatus;
+    auto readJournal(uint32_t cursor, size_t count) const -> JournalEntryVector;
+
+    auto getPerfCounters() const -> PerfCounterVector;
+    void resetPerfCounters();
+
+    auto getDeviceTime() const -> uint64_t;
+
+    void setTimestampsEnabled(bool enabled);
+    auto getLastResponseTime() const -> uint64_t;
+
+    auto synchronizeClock(size_t rounds) -> ClockStatus;
+    auto toHostTime(uint64_t deviceTime) const -> std::chrono::steady_clock::time_point;
 
     void setPowerLimit(size_t index, RelayPower power);
     auto getPowerLimit(size_t index) const -> RelayPower;
 
     void savePowerLimits();
 
+    void storeProfile(size_t index, const std::string& name, const PowerLimitArray& limits);
+    void storeProfileFile(size_t index, const std::string& name, const std::string& fileName);
+    auto getProfiles() const -> ProfileInfoVector;
+    auto getProfileLimits(size_t index) const -> PowerLimitArray;
+    void loadProfile(size_t index);
+
     auto getBootMode() const -> BootMode;
 
     auto getBoardName() const -> std::string;
@@ -76,38 +136,77 @@ public:
     // Bootloader-specific
     auto getBootloaderVersion() const -> std::string;
     auto getSectorCount() const -> size_t;
+    auto getSectorChecksums() const -> std::vector<SectorChecksum>;
+    auto getRangeChecksum(uint32_t address, size_t size) const -> uint32_t;
     auto getFirmwareValid() const -> bool;
 
     void unlockFirmware();
     void lockFirmware();
 
     void eraseSector(size_t sector);
+
+    // Erases all sectors from the given one on that are neither blank nor written since unlocking,
+    // others are erased by the bootloader when first written to
+    void eraseTail(size_t firstSector);
+
     void writeHexRecord(const std::string& record);
 
+    // Raw data at an absolute address, sent in one round trip instead of one per record
+    void writeBlock(uint32_t address, std::span<const uint8_t> data);
+
+    // Pipelined versions of the two above. Requests are sent without waiting for a reply as
+    // long as Protocol::UploadWindow allows, and failed ones are resent from where the bootloader
+    // reports the failure. finishUpload() must be called before any other request.
+    void uploadHexRecord(const std::string& record);
+    void uploadBlock(uint32_t address, std::span<const uint8_t> data);
+    void finishUpload();
+
     void launchFirmware();
 
+    // The CRC-32 used for blocks, sectors and the firmware image
+    static auto computeChecksum(std::span<const uint8_t> data) -> uint32_t;
+
 private:
     auto sendRequest(std::string request,
                      std::chrono::milliseconds timeout = DefaultTimeout) const -> std::string;
 
-    void checkError(const std::string& response) const;
+    // Request tags, argument counts and response tags all come from the shared protocol table
+    auto sendCommand(Protocol::Command command, const std::string& arguments = {},
+                     std::chrono::milliseconds timeout = DefaultTimeout) const -> std::string;
 
-    auto parseString(const std::string& response,
-                     const std::string& expectedTag) const -> std::string;
+    auto sendListCommand(Protocol::Command command, const std::string& arguments = {},
+                         std::chrono::milliseconds timeout = DefaultTimeout) const
+                            -> std::vector<std::string>;
 
-    auto parseULong(const std::string& response,
-                    const std::string& expectedTag) const -> unsigned long;
+    auto receiveResponse(std::chrono::milliseconds timeout) const -> std::string;
 
-    auto parseRelayState(const std::string& response,
-                         const std::string& expectedTag) const -> RelayState;
+    void queueUpload(std::vector<uint8_t> request);
+    void receiveUploadReply();
+
+    void checkError(const std::string& response) const;
 
-    auto parseRelayPower(const std::string& response,
-                         const std::string& expectedTag) const -> RelayPower;
+    auto parseULong(const std::string& value) const -> unsigned long;
+    auto parseRelayState(const std::string& value) const -> RelayState;
+    auto parseRelayPower(const std::string& value) const -> RelayPower;
+    auto parseDouble(const std::string& value) const -> double;
+
+    auto parseIndexedValues(const std::string& line, size_t valueCount, size_t indexCount) const
+                                -> std::pair<size_t, std::vector<double>>;
 
     static auto mapError(const std::string& error) -> std::string;
 
 private:
     SerialPort m_port;
+    mutable std::string m_buffer;
+    mutable uint64_t m_lastResponseTime = 0;
+
+    ClockSync m_clockSync;
+
+    // Requests not yet acknowledged, the first one has sequence number m_uploadSequence
+    std::deque<std::vector<uint8_t>> m_uploads;
+    uint32_t m_uploadSequence = 0;
+    size_t m_uploadBytes = 0;
+    int m_uploadRetries = 0;
 };
 
 } // End of namespace irb::Private
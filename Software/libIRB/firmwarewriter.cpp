@@ -0,0 +1,339 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "firmwarewriter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <optional>
+#include <sstream>
+
+// ---------------------------------------------------------------------------------------------- //
+
+using namespace irb::Private;
+
+// ---------------------------------------------------------------------------------------------- //
+
+namespace {
+    enum class RecordType : uint8_t
+    {
+        Data = 0,
+        EndOfFile = 1,
+        ExtendedLinearAddress = 4
+    };
+
+    struct Record
+    {
+        uint8_t type;
+        uint16_t address;
+        std::vector<uint8_t> data;
+    };
+
+    // Only as strict as needed to find data, the bootloader checks everything it is sent
+    auto parseRecord(const std::string& string) -> std::optional<Record>
+    {
+        if (string.size() < 11 || string.front() != ':' || string.size() % 2 == 0)
+            return {};
+
+        std::vector<uint8_t> bytes;
+        uint8_t checksum = 0;
+
+        for (size_t i = 1; i < string.size(); i += 2)
+        {
+            const std::string hex = string.substr(i, 2);
+
+            if (hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+                return {};
+
+            bytes.push_back(static_cast<uint8_t>(std::stoul(hex, nullptr, 16)));
+            checksum += bytes.back();
+        }
+
+        if (checksum != 0 || bytes.at(0) + 5u != bytes.size())
+            return {};
+
+        return Record {
+            bytes.at(3),
+            static_cast<uint16_t>((bytes.at(1) << 8) | bytes.at(2)),
+            std::vector<uint8_t>(bytes.begin() + 4, bytes.end() - 1)
+        };
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+FirmwareWriter::FirmwareWriter(Device* device)
+    : m_device(device)
+{
+    assert(device != nullptr);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareWriter::unlockFirmware()
+{
+    m_baseAddress = 0;
+    m_block.clear();
+    m_sectors.clear();
+    m_writtenBlocks.clear();
+    m_verifyBlocks = false;
+    m_writtenBytes = 0;
+
+    m_device->unlockFirmware();
+
+    // Older bootloaders don't report sector checksums and get every sector written
+    std::vector<Device::SectorChecksum> checksums;
+
+    try {
+        checksums = m_device->getSectorChecksums();
+    }
+    catch (const irb::Error&) {
+        return;
+    }
+
+    for (const Device::SectorChecksum& sector : checksums)
+        m_sectors.push_back({ sector.address, sector.checksum, {}, {} });
+
+    // Range checksums came later still, an empty range tells whether they are supported
+    if (m_sectors.empty())
+        return;
+
+    try {
+        m_device->getRangeChecksum(m_sectors.front().address, 0);
+        m_verifyBlocks = true;
+    }
+    catch (const irb::Error&) {}
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareWriter::lockFirmware()
+{
+    writeSectors();
+    verifyBlocks();
+
+    m_device->lockFirmware();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareWriter::eraseSector(size_t sector)
+{
+    // Left to writeSectors(), the bootloader erases sectors as they are written
+    if (sector < m_sectors.size())
+        return;
+
+    verifyBlocks();
+
+    m_device->eraseSector(sector);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareWriter::writeHexRecord(const std::string& record)
+{
+    const std::optional<Record> parsed = parseRecord(record);
+
+    if (parsed && parsed->type == static_cast<uint8_t>(RecordType::Data))
+        return storeData(m_baseAddress | parsed->address, parsed->data);
+
+    if (parsed && parsed->type == static_cast<uint8_t>(RecordType::ExtendedLinearAddress)
+               && parsed->data.size() == 2)
+    {
+        m_baseAddress = (parsed->data.at(0) << 24) | (parsed->data.at(1) << 16);
+        return;
+    }
+
+    // The end-of-file record makes the bootloader checksum the image, all data must be written.
+    // Verifying the blocks first pinpoints a failure instead of just reporting an invalid image.
+    if (parsed && parsed->type == static_cast<uint8_t>(RecordType::EndOfFile))
+    {
+        writeSectors();
+        verifyBlocks();
+    }
+
+    flushBlock();
+    m_device->uploadHexRecord(record);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareWriter::storeData(uint32_t address, const std::vector<uint8_t>& data)
+{
+    if (m_sectors.empty())
+        return appendData(address, data);
+
+    const uint32_t firstAddress = m_sectors.front().address;
+
+    for (uint8_t byte : data)
+    {
+        const size_t index = (address - firstAddress) / Device::MaximumBlockSize;
+
+        if (address < firstAddress || index >= m_sectors.size())
+            throw irb::Error("Firmware image contains data outside of the firmware sectors.");
+
+        Sector& sector = m_sectors.at(index);
+
+        if (sector.data.empty())
+        {
+            sector.data.assign(Device::MaximumBlockSize, 0xff);
+            sector.written.assign(Device::MaximumBlockSize, false);
+        }
+
+        const size_t offset = address - sector.address;
+
+        sector.data.at(offset) = byte;
+        sector.written.at(offset) = true;
+
+        ++address;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareWriter::writeSectors()
+{
+    std::vector<Sector> sectors = std::move(m_sectors);
+    m_sectors.clear();
+
+    size_t head = sectors.size();
+    size_t tail = 0;
+
+    for (size_t i = 0; i < sectors.size(); ++i)
+    {
+        if (!sectors.at(i).data.empty())
+        {
+            head = std::min(head, i);
+            tail = i + 1;
+        }
+    }
+
+    // Sectors in front of the image, the user page at least, hold the configuration and are
+    // left alone. All others are expected to be blank unless the image has data for them.
+    std::vector<size_t> changed;
+
+    for (size_t i = head; i < sectors.size(); ++i)
+    {
+        if (sectors.at(i).data.empty())
+            sectors.at(i).data.assign(Device::MaximumBlockSize, 0xff);
+
+        if (Device::computeChecksum(sectors.at(i).data) != sectors.at(i).checksum)
+            changed.push_back(i);
+    }
+
+    // Sectors with data are erased on their first write. Of the others, those behind the last
+    // one with data are left to a single request, which skips sectors that are blank already.
+    flushBlock();
+    m_device->finishUpload();
+
+    for (size_t i : changed)
+    {
+        if (i >= tail)
+        {
+            m_device->eraseTail(tail);
+            break;
+        }
+
+        if (sectors.at(i).written.empty())
+            m_device->eraseSector(i);
+    }
+
+    for (size_t i : changed)
+    {
+        const Sector& sector = sectors.at(i);
+
+        for (size_t begin = 0, end = 0; begin < sector.written.size(); begin = end)
+        {
+            const bool written = sector.written.at(begin);
+
+            while (end < sector.written.size() && sector.written.at(end) == written)
+                ++end;
+
+            if (written)
+                appendData(sector.address + begin, { sector.data.begin() + begin,
+                                                     sector.data.begin() + end });
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareWriter::appendData(uint32_t address, const std::vector<uint8_t>& data)
+{
+    for (uint8_t byte : data)
+    {
+        if (!m_block.empty() && address != m_blockAddress + m_block.size())
+            flushBlock();
+
+        if (m_block.empty())
+            m_blockAddress = address;
+
+        m_block.push_back(byte);
+        ++address;
+
+        if (address % Device::MaximumBlockSize == 0)
+            flushBlock();
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareWriter::flushBlock()
+{
+    if (m_block.empty())
+        return;
+
+    // Cleared first, a failed block must not be sent again with the next one
+    const std::vector<uint8_t> block = std::move(m_block);
+    m_block.clear();
+
+    m_device->uploadBlock(m_blockAddress, block);
+    m_writtenBytes += block.size();
+
+    if (m_verifyBlocks)
+        m_writtenBlocks.push_back({ m_blockAddress, block.size(), Device::computeChecksum(block) });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void FirmwareWriter::verifyBlocks()
+{
+    flushBlock();
+    m_device->finishUpload();
+
+    // Cleared first like the block itself, a failure must not be reported again
+    const std::vector<WrittenBlock> blocks = std::move(m_writtenBlocks);
+    m_writtenBlocks.clear();
+
+    for (const WrittenBlock& block : blocks)
+    {
+        if (m_device->getRangeChecksum(block.address, block.size) != block.checksum)
+        {
+            std::ostringstream message;
+            message << "Verification of block at 0x" << std::hex << block.address << " failed.";
+            throw irb::Error(message.str());
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1,95 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#pragma once
+
+#include "device.h"
+
+#include <string>
+#include <vector>
+
+namespace irb::Private {
+
+// Drives a firmware update from the lines of an Intel HEX file, shared by the updater component
+// and the command-line flasher. Uploads are pipelined, so errors may surface a few calls later.
+class IRB_EXPORT FirmwareWriter
+{
+public:
+    FirmwareWriter(Device* device);
+
+    void unlockFirmware();
+    void lockFirmware();
+
+    void eraseSector(size_t sector);
+    void writeHexRecord(const std::string& record);
+
+    // Data bytes sent since unlocking, less than the image if unchanged sectors were skipped
+    auto getWrittenBytes() const -> size_t { return m_writtenBytes; }
+
+private:
+    // Image of one sector as it should be after the update, 0xff where the file has no data
+    struct Sector
+    {
+        uint32_t address;
+        uint32_t checksum;
+        std::vector<uint8_t> data;
+        std::vector<bool> written;
+    };
+
+    // Block sent to the device, read back by checksum once the upload has finished
+    struct WrittenBlock
+    {
+        uint32_t address;
+        size_t size;
+        uint32_t checksum;
+    };
+
+    // Data is collected until the end of the file, then only sectors that differ from what the
+    // device reports are erased and written. Without sector checksums it is passed on directly.
+    void storeData(uint32_t address, const std::vector<uint8_t>& data);
+    void writeSectors();
+
+    // Data records are collected into sector-aligned blocks, everything else is passed on as is
+    void appendData(uint32_t address, const std::vector<uint8_t>& data);
+    void flushBlock();
+
+    // Sends the pending block, waits for the upload to finish and compares every block written
+    // since the last call with what the device has in flash
+    void verifyBlocks();
+
+private:
+    Device* m_device;
+
+    std::vector<Sector> m_sectors;
+
+    bool m_verifyBlocks = false;
+    std::vector<WrittenBlock> m_writtenBlocks;
+
+    uint32_t m_baseAddress = 0;
+    uint32_t m_blockAddress = 0;
+    std::vector<uint8_t> m_block;
+
+    size_t m_writtenBytes = 0;
+};
+
+} // End of namespace irb::Private
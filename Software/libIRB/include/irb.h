@@ -39,10 +39,14 @@
 
 #ifdef __cplusplus
 
+#include <array>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 // ---------------------------------------------------------------------------------------------- //
 
@@ -70,6 +74,200 @@ struct RelayPower
     double current;
 };
 
+struct EnergyCounter
+{
+    double charge;   // C
+    double energy;   // Wh
+    double duration; // s
+};
+
+using EnergyCounterArray = std::array<EnergyCounter, RelayCount>;
+
+// Clock rate of the power monitor bus, high-speed mode is not supported
+enum class BusSpeed
+{
+    Standard, // 100 kHz
+    Fast,     // 400 kHz
+    FastPlus  // 1 MHz
+};
+
+constexpr size_t MaximumMedianLength = 7;
+constexpr double MaximumTimeConstant = 60.0;
+
+enum class FilterTarget
+{
+    Fault,
+    Report
+};
+
+// Median length 1 and time constant 0 disable filtering
+struct FilterSettings
+{
+    size_t medianLength;
+    double timeConstant; // s
+};
+
+constexpr size_t CaptureSampleCount = 128;
+
+constexpr uint8_t SwitchTrigger    = 0x01;
+constexpr uint8_t FaultTrigger     = 0x02;
+constexpr uint8_t ThresholdTrigger = 0x04;
+
+enum class CaptureState
+{
+    Idle,
+    Armed,
+    Triggered,
+    Complete
+};
+
+struct CaptureStatus
+{
+    CaptureState state;
+    size_t index;
+    uint8_t trigger;
+    uint64_t triggerTime; // Device time, us
+};
+
+struct CaptureSample
+{
+    double time; // s, relative to trigger
+    double voltage;
+    double current;
+};
+
+using CaptureSampleVector = std::vector<CaptureSample>;
+
+constexpr size_t MaximumRecloseRetryCount = 10;
+constexpr size_t MinimumRecloseDelay = 1;     // ms
+constexpr size_t MaximumRecloseDelay = 60000; // ms
+constexpr size_t MaximumLockoutCount = 255;
+
+// Retry count 0 disables reclosing, lockout count 0 disables the lockout
+struct ReclosePolicy
+{
+    size_t retryCount;
+    size_t delay; // ms, doubled with every further retry
+    size_t lockoutCount;
+};
+
+// Pending while a reclose is scheduled, exhausted after a fault that left no retry
+struct RecloseStatus
+{
+    size_t tripCount;
+    size_t retryIndex;
+    bool lockedOut;
+    bool pending;
+    bool exhausted;
+};
+
+enum class CharacterizationState
+{
+    Idle,
+    Running,
+    Complete,
+    Failed
+};
+
+struct CharacterizationStatus
+{
+    CharacterizationState state;
+    size_t index;
+};
+
+// Times in s after the relay output was written, delay to half of the current step,
+// settling until within 5 % of the final current, resolution is the sampling interval
+struct SwitchTiming
+{
+    double onDelay;
+    double onSettling;
+    double offDelay;
+    double offSettling;
+    double resolution;
+};
+
+constexpr size_t JournalEntryCount = 128;
+constexpr size_t DefaultJournalReadCount = 16;
+constexpr size_t MaximumJournalReadCount = 32;
+
+enum class JournalEvent
+{
+    Boot,
+    RelayOn,
+    RelayOff,
+    Fault,
+    I2cError,
+    LimitChange,
+    LimitsSaved,
+    Reset,
+    Timestamps,
+    CaptureArmed,
+    CaptureDisarmed,
+    CaptureTriggered,
+    ProfileStored,
+    ProfileLoaded,
+    BusSpeed,
+    Characterized,
+    Reclose,
+    Lockout,
+    FaultCleared
+};
+
+struct JournalEntry
+{
+    uint32_t sequence;
+    uint64_t time; // Device time, us
+    JournalEvent event;
+    int channel;   // -1 if none
+    double value1;
+    double value2;
+};
+
+using JournalEntryVector = std::vector<JournalEntry>;
+
+struct JournalStatus
+{
+    uint32_t first;
+    uint32_t next;
+};
+
+constexpr size_t PerfHistogramBinCount = 12;
+
+// Durations in CPU cycles at 80 MHz
+struct PerfCounter
+{
+    std::string name;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+    std::array<uint16_t, PerfHistogramBinCount> histogram;
+};
+
+using PerfCounterVector = std::vector<PerfCounter>;
+
+constexpr size_t DefaultSyncRounds = 8;
+
+constexpr size_t ProfileCount = 4;
+constexpr size_t MaximumProfileNameLength = 11;
+
+using PowerLimitArray = std::array<RelayPower, RelayCount>;
+
+struct ProfileInfo
+{
+    size_t index;
+    std::string name;
+};
+
+using ProfileInfoVector = std::vector<ProfileInfo>;
+
+struct ClockStatus
+{
+    double offset;    // s, device minus host
+    double drift;     // ppm
+    double roundTrip; // s
+};
+
 using Error = std::runtime_error;
 
 // ---------------------------------------------------------------------------------------------- //
@@ -87,16 +285,72 @@ public:
 
     auto getFaultMask() const -> uint16_t;
 
+    // Leaves the relay switched off and all other relays untouched
+    void clearFault(size_t index);
+
+    void setReclosePolicy(size_t index, const ReclosePolicy& policy);
+    auto getReclosePolicy(size_t index) const -> ReclosePolicy;
+    auto getRecloseStatus(size_t index) const -> RecloseStatus;
+
     void setStateMask(uint16_t mask);
     auto getStateMask() const -> uint16_t;
 
     auto getRelayPower(size_t index) const -> RelayPower;
+    auto getRelayWattage(size_t index) const -> double;
+
+    auto getEnergyCounters() const -> EnergyCounterArray;
+    void resetEnergyCounters();
+    void resetEnergyCounter(size_t index);
+
+    // The device falls back to a lower speed by itself on repeated bus errors
+    void setBusSpeed(BusSpeed speed);
+    auto getBusSpeed() const -> BusSpeed;
+
+    // Settings are kept in RAM only and reset to unfiltered on power-up
+    void setFilter(size_t index, FilterTarget target, const FilterSettings& settings);
+    auto getFilter(size_t index, FilterTarget target) const -> FilterSettings;
+
+    void armCapture(size_t index, uint8_t triggerMask, double threshold = 0.0);
+    void disarmCapture();
+    auto getCaptureStatus() const -> CaptureStatus;
+    auto readCapture() const -> CaptureSampleVector;
+
+    // Switches the relay on and off again, it needs a load of at least 10 mA
+    void characterizeRelay(size_t index);
+    auto getCharacterizationStatus() const -> CharacterizationStatus;
+    auto getSwitchTiming(size_t index) const -> SwitchTiming;
+
+    auto getJournalStatus() const -> JournalStatus;
+
+    // Entries older than JournalStatus::first are lost, a gap in sequence numbers shows this
+    auto readJournal(uint32_t cursor, size_t count = DefaultJournalReadCount) const
+        -> JournalEntryVector;
+
+    auto getPerfCounters() const -> PerfCounterVector;
+    void resetPerfCounters();
+
+    auto getDeviceTime() const -> uint64_t;
+
+    void setTimestampsEnabled(bool enabled);
+    auto getLastResponseTime() const -> uint64_t;
+
+    // Repeated calls refine the drift estimate
+    auto synchronizeClock(size_t rounds = DefaultSyncRounds) -> ClockStatus;
+    auto toHostTime(uint64_t deviceTime) const -> std::chrono::steady_clock::time_point;
 
     void setPowerLimit(size_t index, RelayPower power);
     auto getPowerLimit(size_t index) const -> RelayPower;
 
     void savePowerLimits();
 
+    // Limits in effect are not changed until the profile is loaded. Profile files are the
+    // .prof files saved from the limits dialog of the RelayBoard application.
+    void storeProfile(size_t index, const std::string& name, const PowerLimitArray& limits);
+    void storeProfileFile(size_t index, const std::string& name, const std::string& fileName);
+    auto getProfiles() const -> ProfileInfoVector;
+    auto getProfileLimits(size_t index) const -> PowerLimitArray;
+    void loadProfile(size_t index);
+
     auto getHardwareVersion() const -> std::string;
     auto getFirmwareVersion() const -> std::string;
     auto getSerialNumber() const -> std::string;
@@ -137,6 +391,31 @@ extern "C" {
 #define IRB_MINIMUM_CURRENT_LIMIT  0.0
 #define IRB_MAXIMUM_CURRENT_LIMIT  2.0
 
+#define IRB_MAXIMUM_MEDIAN_LENGTH 7
+#define IRB_MAXIMUM_TIME_CONSTANT 60.0
+
+#define IRB_MAXIMUM_RECLOSE_RETRY_COUNT 10
+#define IRB_MINIMUM_RECLOSE_DELAY 1
+#define IRB_MAXIMUM_RECLOSE_DELAY 60000
+#define IRB_MAXIMUM_LOCKOUT_COUNT 255
+
+#define IRB_CAPTURE_SAMPLE_COUNT 128
+
+#define IRB_CAPTURE_TRIGGER_SWITCH    0x01
+#define IRB_CAPTURE_TRIGGER_FAULT     0x02
+#define IRB_CAPTURE_TRIGGER_THRESHOLD 0x04
+
+#define IRB_JOURNAL_ENTRY_COUNT 128
+#define IRB_MAXIMUM_JOURNAL_READ_COUNT 32
+
+#define IRB_PERF_HISTOGRAM_BIN_COUNT 12
+#define IRB_PERF_COUNTER_NAME_LENGTH 15
+
+#define IRB_DEFAULT_SYNC_ROUNDS 8
+
+#define IRB_PROFILE_COUNT 4
+#define IRB_MAXIMUM_PROFILE_NAME_LENGTH 11
+
 #define IRB_VERSION_LENGTH 3
 #define IRB_SERIAL_NUMBER_LENGTH 12
 
@@ -155,6 +434,138 @@ typedef struct {
     double current;
 } irb_relay_power;
 
+typedef struct {
+    double charge;
+    double energy;
+    double duration;
+} irb_energy_counter;
+
+typedef enum {
+    IRB_BUS_SPEED_STANDARD,
+    IRB_BUS_SPEED_FAST,
+    IRB_BUS_SPEED_FAST_PLUS
+} irb_bus_speed;
+
+typedef enum {
+    IRB_FILTER_TARGET_FAULT,
+    IRB_FILTER_TARGET_REPORT
+} irb_filter_target;
+
+typedef struct {
+    size_t median_length;
+    double time_constant;
+} irb_filter_settings;
+
+typedef enum {
+    IRB_CAPTURE_STATE_IDLE,
+    IRB_CAPTURE_STATE_ARMED,
+    IRB_CAPTURE_STATE_TRIGGERED,
+    IRB_CAPTURE_STATE_COMPLETE
+} irb_capture_state;
+
+typedef struct {
+    irb_capture_state state;
+    size_t index;
+    uint8_t trigger;
+    uint64_t trigger_time;
+} irb_capture_status;
+
+typedef struct {
+    double time;
+    double voltage;
+    double current;
+} irb_capture_sample;
+
+typedef struct {
+    size_t retry_count;
+    size_t delay;
+    size_t lockout_count;
+} irb_reclose_policy;
+
+typedef struct {
+    size_t trip_count;
+    size_t retry_index;
+    int locked_out;
+    int pending;
+    int exhausted;
+} irb_reclose_status;
+
+typedef enum {
+    IRB_CHARACTERIZATION_STATE_IDLE,
+    IRB_CHARACTERIZATION_STATE_RUNNING,
+    IRB_CHARACTERIZATION_STATE_COMPLETE,
+    IRB_CHARACTERIZATION_STATE_FAILED
+} irb_characterization_state;
+
+typedef struct {
+    irb_characterization_state state;
+    size_t index;
+} irb_characterization_status;
+
+typedef struct {
+    double on_delay;
+    double on_settling;
+    double off_delay;
+    double off_settling;
+    double resolution;
+} irb_switch_timing;
+
+typedef enum {
+    IRB_JOURNAL_EVENT_BOOT,
+    IRB_JOURNAL_EVENT_RELAY_ON,
+    IRB_JOURNAL_EVENT_RELAY_OFF,
+    IRB_JOURNAL_EVENT_FAULT,
+    IRB_JOURNAL_EVENT_I2C_ERROR,
+    IRB_JOURNAL_EVENT_LIMIT_CHANGE,
+    IRB_JOURNAL_EVENT_LIMITS_SAVED,
+    IRB_JOURNAL_EVENT_RESET,
+    IRB_JOURNAL_EVENT_TIMESTAMPS,
+    IRB_JOURNAL_EVENT_CAPTURE_ARMED,
+    IRB_JOURNAL_EVENT_CAPTURE_DISARMED,
+    IRB_JOURNAL_EVENT_CAPTURE_TRIGGERED,
+    IRB_JOURNAL_EVENT_PROFILE_STORED,
+    IRB_JOURNAL_EVENT_PROFILE_LOADED,
+    IRB_JOURNAL_EVENT_BUS_SPEED,
+    IRB_JOURNAL_EVENT_CHARACTERIZED,
+    IRB_JOURNAL_EVENT_RECLOSE,
+    IRB_JOURNAL_EVENT_LOCKOUT,
+    IRB_JOURNAL_EVENT_FAULT_CLEARED
+} irb_journal_event;
+
+typedef struct {
+    uint32_t sequence;
+    uint64_t time;
+    irb_journal_event event;
+    int channel;
+    double value1;
+    double value2;
+} irb_journal_entry;
+
+typedef struct {
+    uint32_t first;
+    uint32_t next;
+} irb_journal_status;
+
+typedef struct {
+    char name[IRB_PERF_COUNTER_NAME_LENGTH + 1];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+    uint16_t histogram[IRB_PERF_HISTOGRAM_BIN_COUNT];
+} irb_perf_counter;
+
+typedef struct {
+    double offset;
+    double drift;
+    double round_trip;
+} irb_clock_status;
+
+typedef struct {
+    size_t index;
+    char name[IRB_MAXIMUM_PROFILE_NAME_LENGTH + 1];
+} irb_profile_info;
+
 typedef struct _irb_device irb_device;
 
 // ---------------------------------------------------------------------------------------------- //
@@ -166,6 +577,15 @@ irb_result IRB_EXPORT irb_reset_device(irb_device* device);
 
 irb_result IRB_EXPORT irb_get_fault_mask(irb_device* device, uint16_t* mask);
 
+irb_result IRB_EXPORT irb_clear_fault(irb_device* device, size_t index);
+
+irb_result IRB_EXPORT irb_set_reclose_policy(irb_device* device, size_t index,
+                                             irb_reclose_policy policy);
+irb_result IRB_EXPORT irb_get_reclose_policy(irb_device* device, size_t index,
+                                             irb_reclose_policy* policy);
+irb_result IRB_EXPORT irb_get_reclose_status(irb_device* device, size_t index,
+                                             irb_reclose_status* status);
+
 irb_result IRB_EXPORT irb_set_relay_state(irb_device* device, size_t index, irb_relay_state state);
 irb_result IRB_EXPORT irb_get_relay_state(irb_device* device, size_t index, irb_relay_state* state);
 
@@ -173,12 +593,72 @@ irb_result IRB_EXPORT irb_set_state_mask(irb_device* device, uint16_t mask);
 irb_result IRB_EXPORT irb_get_state_mask(irb_device* device, uint16_t* mask);
 
 irb_result IRB_EXPORT irb_get_relay_power(irb_device* device, size_t index, irb_relay_power* power);
+irb_result IRB_EXPORT irb_get_relay_wattage(irb_device* device, size_t index, double* wattage);
+
+irb_result IRB_EXPORT irb_get_energy_counters(irb_device* device, irb_energy_counter counters[]);
+irb_result IRB_EXPORT irb_reset_energy_counters(irb_device* device);
+irb_result IRB_EXPORT irb_reset_energy_counter(irb_device* device, size_t index);
+
+irb_result IRB_EXPORT irb_set_bus_speed(irb_device* device, irb_bus_speed speed);
+irb_result IRB_EXPORT irb_get_bus_speed(irb_device* device, irb_bus_speed* speed);
+
+irb_result IRB_EXPORT irb_set_filter(irb_device* device, size_t index, irb_filter_target target,
+                                     irb_filter_settings settings);
+irb_result IRB_EXPORT irb_get_filter(irb_device* device, size_t index, irb_filter_target target,
+                                     irb_filter_settings* settings);
+
+irb_result IRB_EXPORT irb_arm_capture(irb_device* device, size_t index,
+                                      uint8_t trigger_mask, double threshold);
+irb_result IRB_EXPORT irb_disarm_capture(irb_device* device);
+irb_result IRB_EXPORT irb_get_capture_status(irb_device* device, irb_capture_status* status);
+
+// Buffer must hold IRB_CAPTURE_SAMPLE_COUNT samples
+irb_result IRB_EXPORT irb_read_capture(irb_device* device,
+                                       irb_capture_sample samples[], size_t* count);
+
+irb_result IRB_EXPORT irb_characterize_relay(irb_device* device, size_t index);
+irb_result IRB_EXPORT irb_get_characterization_status(irb_device* device,
+                                                      irb_characterization_status* status);
+irb_result IRB_EXPORT irb_get_switch_timing(irb_device* device, size_t index,
+                                            irb_switch_timing* timing);
+
+irb_result IRB_EXPORT irb_get_journal_status(irb_device* device, irb_journal_status* status);
+
+// Reads at most IRB_MAXIMUM_JOURNAL_READ_COUNT entries
+irb_result IRB_EXPORT irb_read_journal(irb_device* device, uint32_t cursor, size_t max_count,
+                                       irb_journal_entry entries[], size_t* count);
+
+irb_result IRB_EXPORT irb_get_perf_counters(irb_device* device, size_t max_count,
+                                            irb_perf_counter counters[], size_t* count);
+irb_result IRB_EXPORT irb_reset_perf_counters(irb_device* device);
+
+irb_result IRB_EXPORT irb_get_device_time(irb_device* device, uint64_t* time);
+
+irb_result IRB_EXPORT irb_set_timestamps_enabled(irb_device* device, int enabled);
+irb_result IRB_EXPORT irb_get_last_response_time(irb_device* device, uint64_t* time);
+
+irb_result IRB_EXPORT irb_synchronize_clock(irb_device* device, size_t rounds,
+                                            irb_clock_status* status);
+
+// Host time in seconds on the same clock as C++ std::chrono::steady_clock
+irb_result IRB_EXPORT irb_to_host_time(irb_device* device, uint64_t device_time, double* host_time);
 
 irb_result IRB_EXPORT irb_set_power_limit(irb_device* device, size_t index, irb_relay_power power);
 irb_result IRB_EXPORT irb_get_power_limit(irb_device* device, size_t index, irb_relay_power* power);
 
 irb_result IRB_EXPORT irb_save_power_limits(irb_device* device);
 
+// Limit arrays hold IRB_RELAY_COUNT entries, profile buffer IRB_PROFILE_COUNT entries
+irb_result IRB_EXPORT irb_store_profile(irb_device* device, size_t index, const char* name,
+                                        const irb_relay_power limits[]);
+irb_result IRB_EXPORT irb_store_profile_file(irb_device* device, size_t index, const char* name,
+                                             const char* file_name);
+irb_result IRB_EXPORT irb_get_profiles(irb_device* device,
+                                       irb_profile_info profiles[], size_t* count);
+irb_result IRB_EXPORT irb_get_profile_limits(irb_device* device, size_t index,
+                                             irb_relay_power limits[]);
+irb_result IRB_EXPORT irb_load_profile(irb_device* device, size_t index);
+
 irb_result IRB_EXPORT irb_get_hardware_version(irb_device* device, char buffer[]);
 irb_result IRB_EXPORT irb_get_firmware_version(irb_device* device, char buffer[]);
 irb_result IRB_EXPORT irb_get_serial_number(irb_device* device, char buffer[]);
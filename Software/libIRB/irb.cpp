@@ -26,6 +26,8 @@
 #include <irb.h>
 using namespace irb;
 
+#include <algorithm>
+
 // ---------------------------------------------------------------------------------------------- //
 
 class Device::Private
@@ -69,6 +71,34 @@ auto Device::getFaultMask() const -> uint16_t
 
 // ---------------------------------------------------------------------------------------------- //
 
+void Device::clearFault(size_t index)
+{
+    d->device.clearFault(index);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::setReclosePolicy(size_t index, const ReclosePolicy& policy)
+{
+    d->device.setReclosePolicy(index, policy);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getReclosePolicy(size_t index) const -> ReclosePolicy
+{
+    return d->device.getReclosePolicy(index);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getRecloseStatus(size_t index) const -> RecloseStatus
+{
+    return d->device.getRecloseStatus(index);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void Device::setRelayState(size_t index, RelayState state)
 {
     d->device.setRelayState(index, state);
@@ -104,6 +134,174 @@ auto Device::getRelayPower(size_t index) const -> RelayPower
 
 // ---------------------------------------------------------------------------------------------- //
 
+auto Device::getRelayWattage(size_t index) const -> double
+{
+    return d->device.getRelayWattage(index);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getEnergyCounters() const -> EnergyCounterArray
+{
+    return d->device.getEnergyCounters();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::resetEnergyCounters()
+{
+    d->device.resetEnergyCounters();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::resetEnergyCounter(size_t index)
+{
+    d->device.resetEnergyCounter(index);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::setBusSpeed(BusSpeed speed)
+{
+    d->device.setBusSpeed(speed);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getBusSpeed() const -> BusSpeed
+{
+    return d->device.getBusSpeed();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::setFilter(size_t index, FilterTarget target, const FilterSettings& settings)
+{
+    d->device.setFilter(index, target, settings);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getFilter(size_t index, FilterTarget target) const -> FilterSettings
+{
+    return d->device.getFilter(index, target);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::armCapture(size_t index, uint8_t triggerMask, double threshold)
+{
+    d->device.armCapture(index, triggerMask, threshold);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::disarmCapture()
+{
+    d->device.disarmCapture();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getCaptureStatus() const -> CaptureStatus
+{
+    return d->device.getCaptureStatus();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::readCapture() const -> CaptureSampleVector
+{
+    return d->device.readCapture();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::characterizeRelay(size_t index)
+{
+    d->device.characterizeRelay(index);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getCharacterizationStatus() const -> CharacterizationStatus
+{
+    return d->device.getCharacterizationStatus();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getSwitchTiming(size_t index) const -> SwitchTiming
+{
+    return d->device.getSwitchTiming(index);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getJournalStatus() const -> JournalStatus
+{
+    return d->device.getJournalStatus();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::readJournal(uint32_t cursor, size_t count) const -> JournalEntryVector
+{
+    return d->device.readJournal(cursor, count);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getPerfCounters() const -> PerfCounterVector
+{
+    return d->device.getPerfCounters();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::resetPerfCounters()
+{
+    d->device.resetPerfCounters();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getDeviceTime() const -> uint64_t
+{
+    return d->device.getDeviceTime();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::setTimestampsEnabled(bool enabled)
+{
+    d->device.setTimestampsEnabled(enabled);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getLastResponseTime() const -> uint64_t
+{
+    return d->device.getLastResponseTime();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::synchronizeClock(size_t rounds) -> ClockStatus
+{
+    return d->device.synchronizeClock(rounds);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::toHostTime(uint64_t deviceTime) const -> std::chrono::steady_clock::time_point
+{
+    return d->device.toHostTime(deviceTime);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 void Device::setPowerLimit(size_t index, RelayPower power)
 {
     d->device.setPowerLimit(index, power);
@@ -125,6 +323,41 @@ void Device::savePowerLimits()
 
 // ---------------------------------------------------------------------------------------------- //
 
+void Device::storeProfile(size_t index, const std::string& name, const PowerLimitArray& limits)
+{
+    d->device.storeProfile(index, name, limits);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::storeProfileFile(size_t index, const std::string& name, const std::string& fileName)
+{
+    d->device.storeProfileFile(index, name, fileName);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getProfiles() const -> ProfileInfoVector
+{
+    return d->device.getProfiles();
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto Device::getProfileLimits(size_t index) const -> PowerLimitArray
+{
+    return d->device.getProfileLimits(index);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+void Device::loadProfile(size_t index)
+{
+    d->device.loadProfile(index);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 auto Device::getHardwareVersion() const -> std::string
 {
     return d->device.getHardwareVersion();
@@ -217,6 +450,53 @@ irb_result irb_get_fault_mask(irb_device* device, uint16_t* mask)
 
 // ---------------------------------------------------------------------------------------------- //
 
+irb_result irb_clear_fault(irb_device* device, size_t index)
+{
+    return _irb_call([&]{ device->device.clearFault(index); }, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_set_reclose_policy(irb_device* device, size_t index, irb_reclose_policy policy)
+{
+    const auto func = [&]
+    {
+        const ReclosePolicy p = { policy.retry_count, policy.delay, policy.lockout_count };
+        device->device.setReclosePolicy(index, p);
+    };
+
+    return _irb_call(func, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_reclose_policy(irb_device* device, size_t index, irb_reclose_policy* policy)
+{
+    const auto func = [&]
+    {
+        const ReclosePolicy p = device->device.getReclosePolicy(index);
+        *policy = { p.retryCount, p.delay, p.lockoutCount };
+    };
+
+    return _irb_call(func, [&]{ *policy = { 0, 0, 0 }; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_reclose_status(irb_device* device, size_t index, irb_reclose_status* status)
+{
+    const auto func = [&]
+    {
+        const RecloseStatus s = device->device.getRecloseStatus(index);
+        *status = { s.tripCount, s.retryIndex, s.lockedOut ? 1 : 0, s.pending ? 1 : 0,
+                    s.exhausted ? 1 : 0 };
+    };
+
+    return _irb_call(func, [&]{ *status = { 0, 0, 0, 0, 0 }; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 irb_result irb_set_relay_state(irb_device* device, size_t index, irb_relay_state state)
 {
     const auto func = [&]
@@ -271,6 +551,298 @@ irb_result irb_get_relay_power(irb_device* device, size_t index, irb_relay_power
 
 // ---------------------------------------------------------------------------------------------- //
 
+irb_result irb_get_relay_wattage(irb_device* device, size_t index, double* wattage)
+{
+    return _irb_call([&]{ *wattage = device->device.getRelayWattage(index); },
+                     [&]{ *wattage = 0.0; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_energy_counters(irb_device* device, irb_energy_counter counters[])
+{
+    const auto func = [&]
+    {
+        const EnergyCounterArray c = device->device.getEnergyCounters();
+
+        for (size_t i = 0; i < RelayCount; ++i)
+            counters[i] = { c[i].charge, c[i].energy, c[i].duration };
+    };
+
+    const auto cleanup = [&]
+    {
+        for (size_t i = 0; i < RelayCount; ++i)
+            counters[i] = { 0.0, 0.0, 0.0 };
+    };
+
+    return _irb_call(func, cleanup);
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_reset_energy_counters(irb_device* device)
+{
+    return _irb_call([&]{ device->device.resetEnergyCounters(); }, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_reset_energy_counter(irb_device* device, size_t index)
+{
+    return _irb_call([&]{ device->device.resetEnergyCounter(index); }, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_set_bus_speed(irb_device* device, irb_bus_speed speed)
+{
+    return _irb_call([&]{ device->device.setBusSpeed(static_cast<BusSpeed>(speed)); }, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_bus_speed(irb_device* device, irb_bus_speed* speed)
+{
+    const auto func = [&]
+    {
+        *speed = static_cast<irb_bus_speed>(device->device.getBusSpeed());
+    };
+
+    return _irb_call(func, [&]{ *speed = IRB_BUS_SPEED_STANDARD; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_set_filter(irb_device* device, size_t index, irb_filter_target target,
+                          irb_filter_settings settings)
+{
+    const auto func = [&]
+    {
+        const FilterTarget t = (target == IRB_FILTER_TARGET_FAULT) ? FilterTarget::Fault
+                                                                   : FilterTarget::Report;
+        const FilterSettings s = { settings.median_length, settings.time_constant };
+        device->device.setFilter(index, t, s);
+    };
+
+    return _irb_call(func, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_filter(irb_device* device, size_t index, irb_filter_target target,
+                          irb_filter_settings* settings)
+{
+    const auto func = [&]
+    {
+        const FilterTarget t = (target == IRB_FILTER_TARGET_FAULT) ? FilterTarget::Fault
+                                                                   : FilterTarget::Report;
+        const FilterSettings s = device->device.getFilter(index, t);
+        *settings = { s.medianLength, s.timeConstant };
+    };
+
+    return _irb_call(func, [&]{ *settings = { 0, 0.0 }; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_arm_capture(irb_device* device, size_t index, uint8_t trigger_mask, double threshold)
+{
+    return _irb_call([&]{ device->device.armCapture(index, trigger_mask, threshold); }, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_disarm_capture(irb_device* device)
+{
+    return _irb_call([&]{ device->device.disarmCapture(); }, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_capture_status(irb_device* device, irb_capture_status* status)
+{
+    const auto func = [&]
+    {
+        const CaptureStatus s = device->device.getCaptureStatus();
+        *status = { static_cast<irb_capture_state>(s.state), s.index, s.trigger, s.triggerTime };
+    };
+
+    return _irb_call(func, [&]{ *status = { IRB_CAPTURE_STATE_IDLE, 0, 0, 0 }; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_read_capture(irb_device* device, irb_capture_sample samples[], size_t* count)
+{
+    const auto func = [&]
+    {
+        const CaptureSampleVector s = device->device.readCapture();
+
+        for (size_t i = 0; i < s.size(); ++i)
+            samples[i] = { s[i].time, s[i].voltage, s[i].current };
+
+        *count = s.size();
+    };
+
+    return _irb_call(func, [&]{ *count = 0; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_characterize_relay(irb_device* device, size_t index)
+{
+    return _irb_call([&]{ device->device.characterizeRelay(index); }, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_characterization_status(irb_device* device,
+                                           irb_characterization_status* status)
+{
+    const auto func = [&]
+    {
+        const CharacterizationStatus s = device->device.getCharacterizationStatus();
+        *status = { static_cast<irb_characterization_state>(s.state), s.index };
+    };
+
+    return _irb_call(func, [&]{ *status = { IRB_CHARACTERIZATION_STATE_IDLE, 0 }; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_switch_timing(irb_device* device, size_t index, irb_switch_timing* timing)
+{
+    const auto func = [&]
+    {
+        const SwitchTiming t = device->device.getSwitchTiming(index);
+        *timing = { t.onDelay, t.onSettling, t.offDelay, t.offSettling, t.resolution };
+    };
+
+    return _irb_call(func, [&]{ *timing = { 0.0, 0.0, 0.0, 0.0, 0.0 }; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_journal_status(irb_device* device, irb_journal_status* status)
+{
+    const auto func = [&]
+    {
+        const JournalStatus s = device->device.getJournalStatus();
+        *status = { s.first, s.next };
+    };
+
+    return _irb_call(func, [&]{ *status = { 0, 0 }; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_read_journal(irb_device* device, uint32_t cursor, size_t max_count,
+                            irb_journal_entry entries[], size_t* count)
+{
+    const auto func = [&]
+    {
+        const JournalEntryVector e = device->device.readJournal(cursor, max_count);
+
+        for (size_t i = 0; i < e.size() && i < max_count; ++i)
+        {
+            entries[i] = { e[i].sequence, e[i].time, static_cast<irb_journal_event>(e[i].event),
+                           e[i].channel, e[i].value1, e[i].value2 };
+        }
+
+        *count = std::min(e.size(), max_count);
+    };
+
+    return _irb_call(func, [&]{ *count = 0; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_perf_counters(irb_device* device, size_t max_count,
+                                 irb_perf_counter counters[], size_t* count)
+{
+    const auto func = [&]
+    {
+        const PerfCounterVector c = device->device.getPerfCounters();
+
+        *count = std::min(c.size(), max_count);
+
+        for (size_t i = 0; i < *count; ++i)
+        {
+            irb_perf_counter& counter = counters[i];
+
+            const size_t length = c[i].name.copy(counter.name, IRB_PERF_COUNTER_NAME_LENGTH);
+            counter.name[length] = '\0';
+
+            counter.count = c[i].count;
+            counter.min = c[i].min;
+            counter.max = c[i].max;
+            counter.mean = c[i].mean;
+
+            std::copy(c[i].histogram.begin(), c[i].histogram.end(), counter.histogram);
+        }
+    };
+
+    return _irb_call(func, [&]{ *count = 0; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_reset_perf_counters(irb_device* device)
+{
+    return _irb_call([&]{ device->device.resetPerfCounters(); }, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_device_time(irb_device* device, uint64_t* time)
+{
+    return _irb_call([&]{ *time = device->device.getDeviceTime(); },
+                     [&]{ *time = 0; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_set_timestamps_enabled(irb_device* device, int enabled)
+{
+    return _irb_call([&]{ device->device.setTimestampsEnabled(enabled != 0); }, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_last_response_time(irb_device* device, uint64_t* time)
+{
+    return _irb_call([&]{ *time = device->device.getLastResponseTime(); },
+                     [&]{ *time = 0; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_synchronize_clock(irb_device* device, size_t rounds, irb_clock_status* status)
+{
+    const auto func = [&]
+    {
+        const ClockStatus s = device->device.synchronizeClock(rounds);
+        *status = { s.offset, s.drift, s.roundTrip };
+    };
+
+    return _irb_call(func, [&]{ *status = { 0.0, 0.0, 0.0 }; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_to_host_time(irb_device* device, uint64_t device_time, double* host_time)
+{
+    const auto func = [&]
+    {
+        const auto time = device->device.toHostTime(device_time);
+        *host_time = std::chrono::duration<double>(time.time_since_epoch()).count();
+    };
+
+    return _irb_call(func, [&]{ *host_time = 0.0; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 irb_result irb_set_power_limit(irb_device* device, size_t index, irb_relay_power power)
 {
     const auto func = [&]
@@ -304,6 +876,77 @@ irb_result irb_save_power_limits(irb_device* device)
 
 // ---------------------------------------------------------------------------------------------- //
 
+irb_result irb_store_profile(irb_device* device, size_t index, const char* name,
+                             const irb_relay_power limits[])
+{
+    const auto func = [&]
+    {
+        PowerLimitArray l = {};
+
+        for (size_t i = 0; i < l.size(); ++i)
+            l[i] = { limits[i].voltage, limits[i].current };
+
+        device->device.storeProfile(index, name, l);
+    };
+
+    return _irb_call(func, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_store_profile_file(irb_device* device, size_t index, const char* name,
+                                  const char* file_name)
+{
+    return _irb_call([&]{ device->device.storeProfileFile(index, name, file_name); }, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_profiles(irb_device* device, irb_profile_info profiles[], size_t* count)
+{
+    const auto func = [&]
+    {
+        const ProfileInfoVector p = device->device.getProfiles();
+
+        *count = std::min(p.size(), ProfileCount);
+
+        for (size_t i = 0; i < *count; ++i)
+        {
+            profiles[i].index = p[i].index;
+
+            const size_t length = p[i].name.copy(profiles[i].name,
+                                                 IRB_MAXIMUM_PROFILE_NAME_LENGTH);
+            profiles[i].name[length] = '\0';
+        }
+    };
+
+    return _irb_call(func, [&]{ *count = 0; });
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_get_profile_limits(irb_device* device, size_t index, irb_relay_power limits[])
+{
+    const auto func = [&]
+    {
+        const PowerLimitArray l = device->device.getProfileLimits(index);
+
+        for (size_t i = 0; i < l.size(); ++i)
+            limits[i] = { l[i].voltage, l[i].current };
+    };
+
+    return _irb_call(func, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
+irb_result irb_load_profile(irb_device* device, size_t index)
+{
+    return _irb_call([&]{ device->device.loadProfile(index); }, []{});
+}
+
+// ---------------------------------------------------------------------------------------------- //
+
 irb_result irb_get_hardware_version(irb_device* device, char buffer[])
 {
     const auto func = [&]
@@ -0,0 +1,121 @@
+// ============================================================================================== //
+//                                                                                                //
+//  This file is part of the ISF RelayBoard project.                                              //
+//                                                                                                //
+//  Author:                                                                                       //
+//  Marcel Hasler <mahasler@gmail.com>                                                            //
+//                                                                                                //
+//  Copyright (c) 2021 - 2023                                                                     //
+//  Bonn-Rhein-Sieg University of Applied Sciences                                                //
+//                                                                                                //
+//  This program is free software: you can redistribute it and/or modify it under the terms       //
+//  of the GNU General Public License as published by the Free Software Foundation, either        //
+//  version 3 of the License, or (at your option) any later version.                              //
+//                                                                                                //
+//  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;     //
+//  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.     //
+//  See the GNU General Public License for more details.                                          //
+//                                                                                                //
+//  You should have received a copy of the GNU General Public License along with this program.    //
+//  If not, see <https://www.gnu.org/licenses/>.                                                  //
+//                                                                                                //
+// ============================================================================================== //
+
+#include "lzssencoder.h"
+
+#include <utility>
+
+// ---------------------------------------------------------------------------------------------- //
+
+using namespace irb::Private;
+
+// ---------------------------------------------------------------------------------------------- //
+
+auto LzssEncoder::encode(std::span<const uint8_t> data) -> std::vector<uint8_t>
+{
+    constexpr size_t MinimumLength = 3;
+    constexpr size_t MaximumLength = MinimumLength + 31;
+    constexpr size_t MaximumChain = 64;
+
+    constexpr size_t HashSize = 4096;
+    std::vector<int> heads(HashSize, -1);
+    std::vector<int> previous(data.size(), -1);
+
+    const auto hashAt = [&](size_t position) -> size_t {
+        return ((data[position] << 4) ^ (data[position + 1] << 2) ^ data[position + 2])
+                    % HashSize;
+    };
+
+    const auto insert = [&](size_t position) {
+        if (position + MinimumLength > data.size())
+            return;
+
+        previous.at(position) = heads.at(hashAt(position));
+        heads.at(hashAt(position)) = static_cast<int>(position);
+    };
+
+    const auto findMatch = [&](size_t position) -> std::pair<size_t, size_t> {
+        if (position + MinimumLength > data.size())
+            return { 0, 0 };
+
+        size_t length = 0;
+        size_t distance = 0;
+        size_t chain = 0;
+
+        for (int j = heads.at(hashAt(position)); j >= 0 && chain < MaximumChain;
+             j = previous.at(j))
+        {
+            const auto candidate = static_cast<size_t>(j);
+            size_t n = 0;
+
+            while (n < MaximumLength && position + n < data.size()
+                                     && data[candidate + n] == data[position + n])
+                ++n;
+
+            if (n > length)
+            {
+                length = n;
+                distance = position - candidate;
+            }
+
+            ++chain;
+        }
+
+        return { length, distance };
+    };
+
+    std::vector<uint8_t> packed;
+    size_t flags = 0;
+
+    for (size_t position = 0, item = 0; position < data.size(); ++item)
+    {
+        if (item % 8 == 0)
+        {
+            flags = packed.size();
+            packed.push_back(0);
+        }
+
+        const auto [length, distance] = findMatch(position);
+
+        if (length < MinimumLength)
+        {
+            packed.at(flags) |= (1 << (item % 8));
+            packed.push_back(data[position]);
+
+            insert(position++);
+            continue;
+        }
+
+        const auto reference = static_cast<uint16_t>(((length - MinimumLength) << 11)
+                                                     | (distance - 1));
+        packed.push_back(reference & 0xff);
+        packed.push_back(reference >> 8);
+
+        for (size_t i = 0; i < length; ++i)
+            insert(position++);
+    }
+
+    return packed;
+}
+
+// ---------------------------------------------------------------------------------------------- //
@@ -0,0 +1 @@
+../../Firmware/Common/protocol.h
\ No newline at end of file